@@ -0,0 +1,426 @@
+#include "Engine\Commandlet\Commandlet.hpp"
+#include "Engine\Commandlet\CommandletRegistration.hpp"
+#include "Engine\Memory\MemoryAllocatePool.hpp"
+#include "Engine\Memory\MemoryThreadCache.hpp"
+#include "Engine\Memory\AllocationTrace.hpp"
+#include "Engine\Core\SamplingProfiler.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <Psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+
+namespace Henry
+{
+
+// One replay step , the trace addresses are renumbered into dense slots so replaying is only array indexing.
+struct ReplayOp
+{
+	unsigned int m_slot;
+	unsigned int m_sizeInBytes;		// 0 frees the slot
+};
+
+
+struct ReplayTrace
+{
+	std::vector<ReplayOp> m_ops;
+	size_t m_numberOfSlots;
+	size_t m_numberOfAllocations;
+	size_t m_peakLiveBytes;
+	size_t m_peakOpIndex;
+	size_t m_numberOfThreads;
+	size_t m_numberOfCallsites;
+};
+
+
+struct ReplayResult
+{
+	double m_nanosecondsPerOp;
+	size_t m_peakResidentBytes;
+	float m_fragmentation;			// reported by the allocator , negative when it can't tell
+};
+
+
+// Every allocator taking part in the replay , add new allocators here.
+struct ReplayAllocator
+{
+	const char* m_name;
+	void (*m_begin)(size_t peakLiveBytes);
+	void* (*m_allocate)(size_t sizeInBytes);
+	void (*m_free)(void* p);
+	float (*m_getFragmentation)();
+	void (*m_end)();
+};
+
+
+static const size_t REPLAY_TOUCH_STRIDE = 4096;
+static MemoryAllocatePool* s_replayPool = nullptr;
+static MemoryAllocatePool* s_previousPool = nullptr;
+
+static void MallocBegin(size_t peakLiveBytes) { (void)peakLiveBytes; }
+static void* MallocAllocate(size_t sizeInBytes) { return malloc(sizeInBytes); }
+static void MallocFree(void* p) { free(p); }
+static float MallocFragmentation() { return -1.0f; }
+static void MallocEnd() {}
+
+static void PoolBegin(size_t peakLiveBytes)
+{
+	size_t reserveSize = peakLiveBytes * 4 > ((size_t)256 << 20) ? peakLiveBytes * 4 : ((size_t)256 << 20);
+	s_previousPool = _memoryAllocatePool;
+	s_replayPool = new MemoryAllocatePool();
+	s_replayPool->InitializeReserved(reserveSize);
+	_memoryAllocatePool = s_replayPool;
+}
+static void* PoolAllocate(size_t sizeInBytes) { return s_replayPool->AllocateMemory(sizeInBytes); }
+static void PoolFree(void* p) { s_replayPool->FreeMemory(p); }
+static float PoolFragmentation()
+{
+	MemoryFreeBlockHistogram histogram;
+	s_replayPool->GetFreeBlockHistogram(histogram);
+	return histogram.m_fragmentation;
+}
+static void PoolEnd()
+{
+	delete s_replayPool;
+	s_replayPool = nullptr;
+	_memoryAllocatePool = s_previousPool;
+}
+
+static void* ThreadCacheReplayAllocate(size_t sizeInBytes) { return ThreadCacheAllocate(sizeInBytes); }
+static void ThreadCacheReplayFree(void* p) { ThreadCacheFree(p); }
+static void ThreadCacheEnd()
+{
+	MemoryThreadCache::GetThreadCache()->Flush();
+	PoolEnd();
+}
+
+static const ReplayAllocator REPLAY_ALLOCATORS[] =
+{
+	{ "malloc" , MallocBegin , MallocAllocate , MallocFree , MallocFragmentation , MallocEnd },
+	{ "pool" , PoolBegin , PoolAllocate , PoolFree , PoolFragmentation , PoolEnd },
+	{ "threadcache" , PoolBegin , ThreadCacheReplayAllocate , ThreadCacheReplayFree , PoolFragmentation , ThreadCacheEnd },
+};
+static const size_t NUM_REPLAY_ALLOCATORS = sizeof(REPLAY_ALLOCATORS) / sizeof(REPLAY_ALLOCATORS[0]);
+
+
+static size_t GetResidentBytes()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.WorkingSetSize;
+#else
+	FILE* file = fopen("/proc/self/statm", "r");
+	if (file == nullptr)
+		return 0;
+
+	unsigned long totalPages = 0;
+	unsigned long residentPages = 0;
+	int matched = fscanf(file, "%lu %lu", &totalPages, &residentPages);
+	fclose(file);
+	return matched == 2 ? (size_t)residentPages * (size_t)sysconf(_SC_PAGESIZE) : 0;
+#endif
+}
+
+
+static void BuildReplayTrace(const std::vector<AllocationTraceRecord>& records, ReplayTrace& out_trace)
+{
+	std::unordered_map<unsigned long long, unsigned int> liveSlots;
+	std::vector<unsigned int> freeSlots;
+	std::vector<unsigned int> slotSizes;
+	std::vector<bool> seenThreads(256, false);
+	size_t liveBytes = 0;
+
+	out_trace.m_ops.clear();
+	out_trace.m_ops.reserve(records.size());
+	out_trace.m_numberOfAllocations = 0;
+	out_trace.m_peakLiveBytes = 0;
+	out_trace.m_peakOpIndex = 0;
+	out_trace.m_numberOfThreads = 0;
+
+	for (size_t index = 0; index < records.size(); ++index)
+	{
+		const AllocationTraceRecord& record = records[index];
+		if (!seenThreads[record.m_thread])
+		{
+			seenThreads[record.m_thread] = true;
+			++out_trace.m_numberOfThreads;
+		}
+
+		ReplayOp op;
+		if (record.m_op == ALLOCATION_TRACE_ALLOCATE)
+		{
+			if (freeSlots.empty())
+			{
+				freeSlots.push_back((unsigned int)slotSizes.size());
+				slotSizes.push_back(0);
+			}
+
+			op.m_slot = freeSlots.back();
+			op.m_sizeInBytes = record.m_sizeInBytes > 0 ? record.m_sizeInBytes : 1;
+			freeSlots.pop_back();
+			liveSlots[record.m_address] = op.m_slot;
+			slotSizes[op.m_slot] = op.m_sizeInBytes;
+			liveBytes += op.m_sizeInBytes;
+			++out_trace.m_numberOfAllocations;
+		}
+		else
+		{
+			// frees of blocks allocated before the trace started can't be replayed
+			std::unordered_map<unsigned long long, unsigned int>::iterator found = liveSlots.find(record.m_address);
+			if (found == liveSlots.end())
+				continue;
+
+			op.m_slot = found->second;
+			op.m_sizeInBytes = 0;
+			liveSlots.erase(found);
+			freeSlots.push_back(op.m_slot);
+			liveBytes -= slotSizes[op.m_slot];
+		}
+
+		out_trace.m_ops.push_back(op);
+		if (liveBytes > out_trace.m_peakLiveBytes)
+		{
+			out_trace.m_peakLiveBytes = liveBytes;
+			out_trace.m_peakOpIndex = out_trace.m_ops.size() - 1;
+		}
+	}
+
+	out_trace.m_numberOfSlots = slotSizes.size();
+}
+
+
+static ReplayResult ReplayOnce(const ReplayAllocator& allocator, const ReplayTrace& trace, int iterations)
+{
+	ReplayResult result;
+	result.m_nanosecondsPerOp = 0.0;
+	result.m_peakResidentBytes = 0;
+	result.m_fragmentation = -1.0f;
+
+	std::vector<void*> slots(trace.m_numberOfSlots, nullptr);
+	allocator.m_begin(trace.m_peakLiveBytes);
+	size_t baseResidentBytes = GetResidentBytes();
+	double bestSeconds = 0.0;
+
+	for (int iteration = 0; iteration < iterations; ++iteration)
+	{
+		double sampleSeconds = 0.0;
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		for (size_t index = 0; index < trace.m_ops.size(); ++index)
+		{
+			const ReplayOp& op = trace.m_ops[index];
+			if (op.m_sizeInBytes)
+			{
+				// touch every page so resident memory follows what the trace asked for
+				char* p = (char*)allocator.m_allocate(op.m_sizeInBytes);
+				for (size_t offset = 0; offset < op.m_sizeInBytes; offset += REPLAY_TOUCH_STRIDE)
+					p[offset] = (char)offset;
+				slots[op.m_slot] = p;
+			}
+			else
+			{
+				allocator.m_free(slots[op.m_slot]);
+				slots[op.m_slot] = nullptr;
+			}
+
+			// sample memory once per pass at the live byte peak , the time spent is taken out again
+			if (index == trace.m_peakOpIndex)
+			{
+				std::chrono::high_resolution_clock::time_point sampleStart = std::chrono::high_resolution_clock::now();
+				size_t residentBytes = GetResidentBytes();
+				if (residentBytes > baseResidentBytes && residentBytes - baseResidentBytes > result.m_peakResidentBytes)
+					result.m_peakResidentBytes = residentBytes - baseResidentBytes;
+				result.m_fragmentation = allocator.m_getFragmentation();
+				sampleSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - sampleStart).count();
+			}
+		}
+		std::chrono::high_resolution_clock::time_point stop = std::chrono::high_resolution_clock::now();
+
+		for (size_t slot = 0; slot < slots.size(); ++slot)
+		{
+			if (slots[slot])
+			{
+				allocator.m_free(slots[slot]);
+				slots[slot] = nullptr;
+			}
+		}
+
+		double seconds = std::chrono::duration<double>(stop - start).count() - sampleSeconds;
+		if (iteration == 0 || seconds < bestSeconds)
+			bestSeconds = seconds;
+	}
+
+	allocator.m_end();
+	result.m_nanosecondsPerOp = trace.m_ops.empty() ? 0.0 : bestSeconds * 1e9 / trace.m_ops.size();
+	return result;
+}
+
+
+// On Linux every allocator replays in its own child process so the resident memory of one run
+// doesn't hide the growth of the next.
+static bool ReplayAllocatorIsolated(const ReplayAllocator& allocator, const ReplayTrace& trace, int iterations, ReplayResult& out_result)
+{
+#if defined(_WIN32)
+	out_result = ReplayOnce(allocator, trace, iterations);
+	return true;
+#else
+	int pipeFds[2];
+	if (pipe(pipeFds) != 0)
+		return false;
+
+	fflush(stdout);
+	pid_t child = fork();
+	if (child < 0)
+	{
+		close(pipeFds[0]);
+		close(pipeFds[1]);
+		return false;
+	}
+
+	if (child == 0)
+	{
+		close(pipeFds[0]);
+		ReplayResult result = ReplayOnce(allocator, trace, iterations);
+		ssize_t written = write(pipeFds[1], &result, sizeof(result));
+		close(pipeFds[1]);
+		SamplingProfiler::FinishChildProcess();
+		_exit(written == (ssize_t)sizeof(result) ? 0 : 1);
+	}
+
+	close(pipeFds[1]);
+	ssize_t bytesRead = read(pipeFds[0], &out_result, sizeof(out_result));
+	close(pipeFds[0]);
+	int status = 0;
+	waitpid(child, &status, 0);
+	return bytesRead == (ssize_t)sizeof(out_result) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#endif
+}
+
+
+// Game like mix recorded through AllocationTrace : lots of short lived small blocks ,
+// per frame buffers and a slowly growing set of long lived assets.
+static bool WriteSyntheticTrace(const char* filePath, int numberOfOps)
+{
+	if (!AllocationTrace::Start(filePath))
+		return false;
+
+	const size_t LIVE_CAPACITY = 16384;
+	std::vector<char*> live(LIVE_CAPACITY, nullptr);
+	char* fakeAddress = (char*)(size_t)0x10000;
+	unsigned int seed = 12345u;
+	for (int op = 0; op < numberOfOps; ++op)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		size_t slot = (seed >> 8) % LIVE_CAPACITY;
+		if (live[slot])
+		{
+			AllocationTrace::RecordFree(live[slot]);
+			live[slot] = nullptr;
+			continue;
+		}
+
+		unsigned int sizeClass = (seed >> 20) % 100;
+		size_t sizeInBytes = 16 + (seed >> 12) % 240;
+		if (sizeClass >= 98)
+			sizeInBytes = 64 * 1024 + (seed >> 4) % (960 * 1024);
+		else if (sizeClass >= 85)
+			sizeInBytes = 1024 + (seed >> 8) % (15 * 1024);
+
+		live[slot] = fakeAddress;
+		AllocationTrace::RecordAllocate(fakeAddress, sizeInBytes, __FILE__, __LINE__ + (int)(sizeClass / 10));
+		fakeAddress += (sizeInBytes + 15) & ~(size_t)15;
+	}
+
+	AllocationTrace::Stop();
+	return true;
+}
+
+
+class AllocationReplayBenchmark : public Commandlet
+{
+public:
+	AllocationReplayBenchmark(const CommandletArguments* args) : Commandlet(args) {};
+	bool Execute();
+	static Commandlet* CreateCommand(const CommandletArguments* args) { return new AllocationReplayBenchmark(args); };
+};
+
+
+// Usage : -AllocationReplay <tracePath | synthetic = synthetic> <iterations = 5>
+bool AllocationReplayBenchmark::Execute()
+{
+	std::string tracePath = "synthetic";
+	int iterations = 5;
+	if (m_commandletArgs->arguments.size() > 0)
+		tracePath = m_commandletArgs->arguments[0];
+	if (m_commandletArgs->arguments.size() > 1)
+		iterations = atoi(m_commandletArgs->arguments[1].c_str());
+	if (iterations < 1)
+		iterations = 1;
+
+	if (tracePath == "synthetic")
+	{
+		tracePath = "synthetic_allocations.trace";
+		if (!WriteSyntheticTrace(tracePath.c_str(), 2000000))
+		{
+			printf("Can't write %s\n", tracePath.c_str());
+			return m_exitAfterExecuted;
+		}
+	}
+
+	std::vector<AllocationTraceRecord> records;
+	std::vector<AllocationTraceCallsite> callsites;
+	if (!AllocationTrace::Load(tracePath.c_str(), records, callsites))
+	{
+		printf("Can't load allocation trace %s\n", tracePath.c_str());
+		return m_exitAfterExecuted;
+	}
+
+	ReplayTrace trace;
+	BuildReplayTrace(records, trace);
+	trace.m_numberOfCallsites = callsites.size();
+	records.clear();
+
+	printf("trace %s : %d ops , %d allocations , peak live %d KB , %d threads , %d callsites\n", tracePath.c_str(),
+		(int)trace.m_ops.size(), (int)trace.m_numberOfAllocations, (int)(trace.m_peakLiveBytes / 1024), (int)trace.m_numberOfThreads, (int)trace.m_numberOfCallsites);
+	printf("%-12s %10s %10s %14s %10s %10s\n", "allocator", "ns/op", "Mops/s", "peak RSS KB", "overhead", "frag");
+
+	for (size_t index = 0; index < NUM_REPLAY_ALLOCATORS; ++index)
+	{
+		ReplayResult result;
+		if (!ReplayAllocatorIsolated(REPLAY_ALLOCATORS[index], trace, iterations, result))
+		{
+			printf("%-12s failed\n", REPLAY_ALLOCATORS[index].m_name);
+			continue;
+		}
+
+		// overhead : share of the resident growth that wasn't asked for by the trace
+		double overhead = result.m_peakResidentBytes > trace.m_peakLiveBytes ? 1.0 - (double)trace.m_peakLiveBytes / result.m_peakResidentBytes : 0.0;
+		char fragmentation[16] = "n/a";
+		if (result.m_fragmentation >= 0.0f)
+			sprintf(fragmentation, "%.3f", result.m_fragmentation);
+
+		printf("%-12s %10.2f %10.2f %14d %10.3f %10s\n", REPLAY_ALLOCATORS[index].m_name, result.m_nanosecondsPerOp,
+			result.m_nanosecondsPerOp > 0.0 ? 1e3 / result.m_nanosecondsPerOp : 0.0, (int)(result.m_peakResidentBytes / 1024), overhead, fragmentation);
+	}
+
+	return m_exitAfterExecuted;
+}
+
+
+static CommandletRegistration s_allocationReplayRegistration("AllocationReplay", &AllocationReplayBenchmark::CreateCommand);
+
+};
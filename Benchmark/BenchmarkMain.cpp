@@ -0,0 +1,29 @@
+#include "Engine\Commandlet\Commandlet.hpp"
+#include "EngineBenchmark.hpp"
+
+#include <stdio.h>
+#include <string>
+
+
+// Headless entry point for the engine benchmarks , every benchmark is a commandlet.
+// e.g. EngineBenchmark.exe -MemoryContention 32 1000000
+// or EngineBenchmark.exe -BenchmarkSuite results.json baseline.json 10 , which exits with 1 on a regression.
+int main(int argc, char** argv)
+{
+	std::string commandLine;
+	for (int index = 1; index < argc; ++index)
+	{
+		if (index != 1)
+			commandLine += ' ';
+		commandLine += argv[index];
+	}
+
+	if (commandLine.empty())
+	{
+		printf("Usage : EngineBenchmark -<Benchmark> <Arguments>\n");
+		return 1;
+	}
+
+	Henry::Commandlet::AnalysisAndRunCommandlet(commandLine);
+	return Henry::EngineBenchmark::s_exitCode;
+}
@@ -0,0 +1,74 @@
+#include "EngineBenchmark.hpp"
+
+#include "Engine\Core\TimingWheel.hpp"
+
+#include <stdio.h>
+
+
+namespace Henry
+{
+
+const size_t TIMING_WHEEL_BENCHMARK_NODES = 4096;
+const unsigned long long TIMING_WHEEL_BENCHMARK_MAX_DELAY = 100000;
+const unsigned long long TIMING_WHEEL_BENCHMARK_STEP = 16;
+
+
+class TimingWheelBenchmark : public EngineBenchmark
+{
+public:
+	TimingWheelBenchmark() : EngineBenchmark("TimingWheel.ScheduleAdvance") {};
+
+	// An expiry a few ticks past a 2^32 boundary has to fire on time , it used to wait out a whole turn.
+	bool Setup()
+	{
+		TimingWheel wheel;
+		TimingWheelNode node;
+		unsigned long long boundary = 1ull << 32;
+		wheel.Advance(boundary - 10);
+		wheel.Schedule(&node, boundary + 5);
+		wheel.Advance(boundary + 4);
+		bool early = wheel.PopExpired() != nullptr;
+		wheel.Advance(boundary + 5);
+		if (early || wheel.PopExpired() != &node)
+		{
+			printf("%-40s expiry across the 2^32 tick boundary fired %s\n", m_name, early ? "early" : "late");
+			EngineBenchmark::s_exitCode = 1;
+			return false;
+		}
+
+		m_seed = 1;
+		return true;
+	};
+
+	// Every batch starts just short of a 2^32 boundary so the scheduling crosses it.
+	size_t Run()
+	{
+		TimingWheel wheel;
+		unsigned long long tick = (1ull << 32) - TIMING_WHEEL_BENCHMARK_MAX_DELAY / 2;
+		wheel.Advance(tick);
+		for (size_t index = 0; index < TIMING_WHEEL_BENCHMARK_NODES; ++index)
+		{
+			m_seed = m_seed * 1664525u + 1013904223u;
+			wheel.Schedule(&m_nodes[index], tick + 1 + m_seed % TIMING_WHEEL_BENCHMARK_MAX_DELAY);
+		}
+
+		size_t numberOfFired = 0;
+		while (numberOfFired < TIMING_WHEEL_BENCHMARK_NODES)
+		{
+			tick += TIMING_WHEEL_BENCHMARK_STEP;
+			wheel.Advance(tick);
+			while (wheel.PopExpired())
+				++numberOfFired;
+		}
+		return TIMING_WHEEL_BENCHMARK_NODES;
+	};
+
+private:
+	TimingWheelNode m_nodes[TIMING_WHEEL_BENCHMARK_NODES];
+	unsigned int m_seed;
+};
+
+
+static TimingWheelBenchmark s_timingWheelBenchmark;
+
+};
@@ -0,0 +1,222 @@
+#include "EngineBenchmark.hpp"
+
+#include "Engine\Commandlet\Commandlet.hpp"
+#include "Engine\Commandlet\CommandletRegistration.hpp"
+#include "Engine\Core\Timebase.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <string>
+
+
+namespace Henry
+{
+
+int EngineBenchmark::s_exitCode = 0;
+
+
+EngineBenchmark::EngineBenchmark(const char* name)
+	: m_name(name)
+{
+	GetBenchmarks().push_back(this);
+}
+
+
+std::vector<EngineBenchmark*>& EngineBenchmark::GetBenchmarks()
+{
+	static std::vector<EngineBenchmark*> s_benchmarks;
+	return s_benchmarks;
+}
+
+
+struct EngineBenchmarkResult
+{
+	std::string m_name;
+	double m_nanosecondsPerOp;		// median of the samples
+	double m_minNanosecondsPerOp;
+	double m_maxNanosecondsPerOp;
+	size_t m_opsPerSample;
+};
+
+
+static FILE* OpenFile(const char* path, const char* mode)
+{
+	FILE* file = nullptr;
+#ifdef _MSC_VER
+	fopen_s(&file, path, mode);
+#else
+	file = fopen(path, mode);
+#endif
+	return file;
+}
+
+
+// Calibrates the batch count so one sample lasts at least ENGINE_BENCHMARK_MIN_SAMPLE_SECONDS , then keeps the median sample.
+static EngineBenchmarkResult RunBenchmark(EngineBenchmark* benchmark)
+{
+	unsigned long long startTicks = Timebase::GetTicks();
+	size_t warmupOps = benchmark->Run();
+	double warmupSeconds = Timebase::TicksToSeconds(Timebase::GetTicks() - startTicks);
+
+	size_t batchesPerSample = 1;
+	if (warmupSeconds > 0.0 && warmupSeconds < ENGINE_BENCHMARK_MIN_SAMPLE_SECONDS)
+		batchesPerSample = (size_t)(ENGINE_BENCHMARK_MIN_SAMPLE_SECONDS / warmupSeconds) + 1;
+
+	double samples[ENGINE_BENCHMARK_SAMPLES];
+	size_t opsPerSample = warmupOps;
+	for (int sample = 0; sample < ENGINE_BENCHMARK_SAMPLES; ++sample)
+	{
+		size_t ops = 0;
+		startTicks = Timebase::GetTicks();
+		for (size_t batch = 0; batch < batchesPerSample; ++batch)
+			ops += benchmark->Run();
+		double seconds = Timebase::TicksToSeconds(Timebase::GetTicks() - startTicks);
+
+		opsPerSample = ops;
+		samples[sample] = ops != 0 ? seconds * 1e9 / ops : 0.0;
+	}
+
+	std::sort(samples, samples + ENGINE_BENCHMARK_SAMPLES);
+	EngineBenchmarkResult result;
+	result.m_name = benchmark->m_name;
+	result.m_nanosecondsPerOp = samples[ENGINE_BENCHMARK_SAMPLES / 2];
+	result.m_minNanosecondsPerOp = samples[0];
+	result.m_maxNanosecondsPerOp = samples[ENGINE_BENCHMARK_SAMPLES - 1];
+	result.m_opsPerSample = opsPerSample;
+	return result;
+}
+
+
+// One benchmark per line , so the baseline can be read back without a json parser.
+static bool WriteResults(const char* path, const std::vector<EngineBenchmarkResult>& results)
+{
+	FILE* file = OpenFile(path, "w");
+	if (!file)
+		return false;
+
+	fprintf(file, "{\n\t\"timebase\" : \"%s\",\n\t\"benchmarks\" : [\n", Timebase::GetSource() == TIMEBASE_TSC ? "tsc" : "reference");
+	for (size_t index = 0; index < results.size(); ++index)
+	{
+		const EngineBenchmarkResult& result = results[index];
+		fprintf(file, "\t\t{ \"name\" : \"%s\", \"nsPerOp\" : %.3f, \"minNsPerOp\" : %.3f, \"maxNsPerOp\" : %.3f, \"opsPerSample\" : %llu }%s\n",
+			result.m_name.c_str(), result.m_nanosecondsPerOp, result.m_minNanosecondsPerOp, result.m_maxNanosecondsPerOp,
+			(unsigned long long)result.m_opsPerSample, index + 1 < results.size() ? "," : "");
+	}
+	fprintf(file, "\t]\n}\n");
+	fclose(file);
+	return true;
+}
+
+
+static bool ReadBaseline(const char* path, std::map<std::string, double>& baseline)
+{
+	FILE* file = OpenFile(path, "r");
+	if (!file)
+		return false;
+
+	char line[1024];
+	while (fgets(line, sizeof(line), file))
+	{
+		const char* name = strstr(line, "\"name\"");
+		const char* nanosecondsPerOp = strstr(line, "\"nsPerOp\"");
+		if (!name || !nanosecondsPerOp)
+			continue;
+
+		name = strchr(name + 6, '\"');
+		const char* nameEnd = name ? strchr(name + 1, '\"') : nullptr;
+		nanosecondsPerOp = strchr(nanosecondsPerOp + 9, ':');
+		if (!nameEnd || !nanosecondsPerOp)
+			continue;
+
+		baseline[std::string(name + 1, nameEnd)] = strtod(nanosecondsPerOp + 1, nullptr);
+	}
+
+	fclose(file);
+	return true;
+}
+
+
+class EngineBenchmarkSuite : public Commandlet
+{
+public:
+	EngineBenchmarkSuite(const CommandletArguments* args) : Commandlet(args) {};
+	bool Execute();
+	static Commandlet* CreateCommand(const CommandletArguments* args) { return new EngineBenchmarkSuite(args); };
+};
+
+
+// Usage : -BenchmarkSuite <results.json = EngineBenchmark.json> <baseline.json | none> <thresholdPercent = 10> <nameFilter>
+// A missing baseline file is created from this run , later runs flag every benchmark slower than the threshold.
+bool EngineBenchmarkSuite::Execute()
+{
+	const std::vector<std::string>& arguments = m_commandletArgs->arguments;
+	std::string resultsPath = arguments.size() > 0 ? arguments[0] : "EngineBenchmark.json";
+	std::string baselinePath = arguments.size() > 1 && arguments[1] != "none" ? arguments[1] : "";
+	double thresholdPercent = arguments.size() > 2 ? atof(arguments[2].c_str()) : ENGINE_BENCHMARK_DEFAULT_THRESHOLD_PERCENT;
+	std::string filter = arguments.size() > 3 ? arguments[3] : "";
+
+	std::map<std::string, double> baseline;
+	bool hasBaseline = !baselinePath.empty() && ReadBaseline(baselinePath.c_str(), baseline);
+
+	std::vector<EngineBenchmarkResult> results;
+	int numberOfRegressions = 0;
+	printf("%-40s %12s %12s %12s %9s\n", "benchmark", "ns/op", "min ns/op", "baseline", "delta");
+	std::vector<EngineBenchmark*>& benchmarks = EngineBenchmark::GetBenchmarks();
+	for (size_t index = 0; index < benchmarks.size(); ++index)
+	{
+		EngineBenchmark* benchmark = benchmarks[index];
+		if (!filter.empty() && strstr(benchmark->m_name, filter.c_str()) == nullptr)
+			continue;
+
+		if (!benchmark->Setup())
+		{
+			printf("%-40s skipped\n", benchmark->m_name);
+			continue;
+		}
+
+		EngineBenchmarkResult result = RunBenchmark(benchmark);
+		benchmark->Teardown();
+		results.push_back(result);
+
+		std::map<std::string, double>::iterator it = baseline.find(result.m_name);
+		if (it == baseline.end() || it->second <= 0.0)
+		{
+			printf("%-40s %12.2f %12.2f %12s %9s\n", result.m_name.c_str(), result.m_nanosecondsPerOp, result.m_minNanosecondsPerOp, "-", "new");
+			continue;
+		}
+
+		double deltaPercent = (result.m_nanosecondsPerOp / it->second - 1.0) * 100.0;
+		bool regressed = deltaPercent > thresholdPercent;
+		if (regressed)
+			++numberOfRegressions;
+		printf("%-40s %12.2f %12.2f %12.2f %+8.1f%%%s\n", result.m_name.c_str(), result.m_nanosecondsPerOp, result.m_minNanosecondsPerOp,
+			it->second, deltaPercent, regressed ? "  REGRESSION" : "");
+	}
+
+	if (WriteResults(resultsPath.c_str(), results))
+		printf("results written to %s\n", resultsPath.c_str());
+	else
+		printf("Can't write results to %s\n", resultsPath.c_str());
+
+	if (!baselinePath.empty() && !hasBaseline)
+	{
+		if (WriteResults(baselinePath.c_str(), results))
+			printf("no baseline found , %s created from this run\n", baselinePath.c_str());
+	}
+
+	if (numberOfRegressions != 0)
+	{
+		printf("%d benchmark(s) regressed more than %.1f%% against %s\n", numberOfRegressions, thresholdPercent, baselinePath.c_str());
+		EngineBenchmark::s_exitCode = 1;
+	}
+
+	return m_exitAfterExecuted;
+}
+
+
+static CommandletRegistration s_engineBenchmarkSuiteRegistration("BenchmarkSuite", &EngineBenchmarkSuite::CreateCommand);
+
+};
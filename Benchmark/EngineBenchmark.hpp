@@ -0,0 +1,35 @@
+#pragma once
+
+#ifndef ENGINEBENCHMARK_HPP
+#define ENGINEBENCHMARK_HPP
+
+#include <stddef.h>
+#include <vector>
+
+namespace Henry
+{
+
+const int ENGINE_BENCHMARK_SAMPLES = 9;
+const double ENGINE_BENCHMARK_MIN_SAMPLE_SECONDS = 0.02;
+const double ENGINE_BENCHMARK_DEFAULT_THRESHOLD_PERCENT = 10.0;
+
+// One headless benchmark of the suite , a static instance registers itself.
+// Run() does one batch of work and returns how many operations were in it.
+class EngineBenchmark
+{
+public:
+	EngineBenchmark(const char* name);
+	virtual ~EngineBenchmark() {};
+	virtual bool Setup() { return true; };		// false skips the benchmark
+	virtual size_t Run() = 0;
+	virtual void Teardown() {};
+
+	const char* m_name;
+
+	static std::vector<EngineBenchmark*>& GetBenchmarks();
+	static int s_exitCode;
+};
+
+};
+
+#endif
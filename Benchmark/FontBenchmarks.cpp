@@ -0,0 +1,53 @@
+#include "EngineBenchmark.hpp"
+
+#include "Engine\Renderer\BitmapFont.hpp"
+
+#include <string>
+
+
+namespace Henry
+{
+
+const size_t FONT_BENCHMARK_BATCH = 64;
+
+
+// Text layout against the built-in arial metrics , the glyph sheet isn't loaded so no GL context is needed.
+class FontLayoutBenchmark : public EngineBenchmark
+{
+public:
+	FontLayoutBenchmark() : EngineBenchmark("BitmapFont.GetWidthOfText"), m_font(nullptr) {};
+
+	bool Setup()
+	{
+		m_font = new BitmapFont(ARIAL_NORMAL, false);
+		m_sentence = "The quick brown fox jumps over the lazy dog 0123456789 , frame %d took %.2f ms";
+		return m_font->ParsingGlyphData();
+	};
+
+	size_t Run()
+	{
+		float fontHeight = 16.0f;
+		size_t numberOfCharacters = 0;
+		for (size_t index = 0; index < FONT_BENCHMARK_BATCH; ++index)
+		{
+			m_font->GetWidthOfText(m_sentence, fontHeight, (int)index, 16.6f);
+			numberOfCharacters += m_sentence.length();
+		}
+		return numberOfCharacters;
+	};
+
+	void Teardown()
+	{
+		delete m_font;
+		m_font = nullptr;
+	};
+
+private:
+	BitmapFont* m_font;
+	std::string m_sentence;
+};
+
+
+static FontLayoutBenchmark s_fontLayoutBenchmark;
+
+};
@@ -0,0 +1,42 @@
+#include "EngineBenchmark.hpp"
+
+#include "Engine\Math\Matrix4.hpp"
+
+
+namespace Henry
+{
+
+const size_t MATRIX_BENCHMARK_BATCH = 4096;
+
+
+class MatrixTransformBenchmark : public EngineBenchmark
+{
+public:
+	MatrixTransformBenchmark() : EngineBenchmark("Matrix4.ApplyTransformMatrix") {};
+
+	// keeps the chain stable , a pure rotation about z by a small angle
+	bool Setup()
+	{
+		float transform[16] = { 0.9998f, 0.0175f, 0.0f, 0.0f,  -0.0175f, 0.9998f, 0.0f, 0.0f,  0.0f, 0.0f, 1.0f, 0.0f,  0.0f, 0.0f, 0.0f, 1.0f };
+		for (int index = 0; index < 16; ++index)
+			m_transform[index] = transform[index];
+		m_matrix.LoadIdentity();
+		return true;
+	};
+
+	size_t Run()
+	{
+		for (size_t index = 0; index < MATRIX_BENCHMARK_BATCH; ++index)
+			m_matrix.ApplyTransformMatrix(m_transform);
+		return MATRIX_BENCHMARK_BATCH;
+	};
+
+private:
+	Matrix4 m_matrix;
+	float m_transform[16];
+};
+
+
+static MatrixTransformBenchmark s_matrixTransformBenchmark;
+
+};
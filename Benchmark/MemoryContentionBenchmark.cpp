@@ -0,0 +1,135 @@
+#include "Engine\Commandlet\Commandlet.hpp"
+#include "Engine\Commandlet\CommandletRegistration.hpp"
+#include "Engine\Memory\MemoryAllocatePool.hpp"
+#include "Engine\Memory\MemoryThreadCache.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+
+namespace Henry
+{
+
+enum ContentionAllocator { SYSTEM_MALLOC = 0 , CENTRAL_POOL , THREAD_CACHE , NUM_CONTENTION_ALLOCATORS };
+static const char* CONTENTION_ALLOCATOR_NAMES[NUM_CONTENTION_ALLOCATORS] = { "malloc" , "pool" , "threadcache" };
+static const int LIVE_BLOCKS_PER_THREAD = 256;
+
+
+static void* ContentionAllocate(ContentionAllocator allocator, size_t size)
+{
+	switch (allocator)
+	{
+	case CENTRAL_POOL:
+		return _memoryAllocatePool->AllocateMemory(size, __FILE__, __LINE__);
+	case THREAD_CACHE:
+		return ThreadCacheAllocate(size, __FILE__, __LINE__);
+	default:
+		return malloc(size);
+	}
+}
+
+
+static void ContentionFree(ContentionAllocator allocator, void* p)
+{
+	switch (allocator)
+	{
+	case CENTRAL_POOL:
+		_memoryAllocatePool->FreeMemory(p);
+		break;
+	case THREAD_CACHE:
+		ThreadCacheFree(p);
+		break;
+	default:
+		free(p);
+		break;
+	}
+}
+
+
+static void ContentionWorker(ContentionAllocator allocator, int opsPerThread, unsigned int seed)
+{
+	void* liveBlocks[LIVE_BLOCKS_PER_THREAD] = { 0 };
+	for (int op = 0; op < opsPerThread; ++op)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		int slot = (seed >> 8) % LIVE_BLOCKS_PER_THREAD;
+		if (liveBlocks[slot])
+		{
+			ContentionFree(allocator, liveBlocks[slot]);
+			liveBlocks[slot] = nullptr;
+		}
+		else
+		{
+			size_t size = 8 + ((seed >> 16) % 504);
+			liveBlocks[slot] = ContentionAllocate(allocator, size);
+			*(char*)liveBlocks[slot] = (char)size;
+		}
+	}
+
+	for (int slot = 0; slot < LIVE_BLOCKS_PER_THREAD; ++slot)
+	{
+		if (liveBlocks[slot])
+			ContentionFree(allocator, liveBlocks[slot]);
+	}
+
+	if (allocator == THREAD_CACHE)
+		MemoryThreadCache::GetThreadCache()->Flush();
+}
+
+
+class MemoryContentionBenchmark : public Commandlet
+{
+public:
+	MemoryContentionBenchmark(const CommandletArguments* args) : Commandlet(args) {};
+	bool Execute();
+	static Commandlet* CreateCommand(const CommandletArguments* args) { return new MemoryContentionBenchmark(args); };
+};
+
+
+// Usage : -MemoryContention <maxThreads = 32> <opsPerThread = 1000000>
+bool MemoryContentionBenchmark::Execute()
+{
+	int maxThreads = 32;
+	int opsPerThread = 1000000;
+	if (m_commandletArgs->arguments.size() > 0)
+		maxThreads = atoi(m_commandletArgs->arguments[0].c_str());
+	if (m_commandletArgs->arguments.size() > 1)
+		opsPerThread = atoi(m_commandletArgs->arguments[1].c_str());
+
+	if (!_memoryAllocatePool)
+	{
+		_memoryAllocatePool = new MemoryAllocatePool();
+		_memoryAllocatePool->Initialize(256 * 1024 * 1024);
+	}
+
+	printf("%-12s %8s %12s %12s\n", "allocator", "threads", "ns/op", "Mops/s");
+	for (int allocator = 0; allocator < NUM_CONTENTION_ALLOCATORS; ++allocator)
+	{
+		for (int numberOfThreads = 1; numberOfThreads <= maxThreads; numberOfThreads *= 2)
+		{
+			std::vector<std::thread> workers;
+			workers.reserve(numberOfThreads);
+
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			for (int index = 0; index < numberOfThreads; ++index)
+				workers.push_back(std::thread(ContentionWorker, (ContentionAllocator)allocator, opsPerThread, 12345u + index));
+			for (int index = 0; index < numberOfThreads; ++index)
+				workers[index].join();
+			std::chrono::high_resolution_clock::time_point stop = std::chrono::high_resolution_clock::now();
+
+			double elapsedSeconds = std::chrono::duration<double>(stop - start).count();
+			double totalOps = (double)numberOfThreads * opsPerThread;
+			printf("%-12s %8d %12.2f %12.2f\n", CONTENTION_ALLOCATOR_NAMES[allocator], numberOfThreads, elapsedSeconds * 1e9 / opsPerThread, totalOps / elapsedSeconds * 1e-6);
+		}
+	}
+
+	return m_exitAfterExecuted;
+}
+
+
+static CommandletRegistration s_memoryContentionRegistration("MemoryContention", &MemoryContentionBenchmark::CreateCommand);
+
+};
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "EngineBenchmark.hpp"
+
+#include "Engine\Network\NetworkingSystem.hpp"
+
+#include <string.h>
+
+
+namespace Henry
+{
+
+const u_short NETWORK_BENCHMARK_PORT = 27315;
+const int NETWORK_BENCHMARK_MESSAGES = 32;
+const int NETWORK_BENCHMARK_PAYLOAD_SIZE = 256;
+const int NETWORK_BENCHMARK_MAX_POLLS = 1000;
+
+
+// Unreliable messages sent to an echo server on 127.0.0.1 and received back by the client , one op is one round trip.
+class NetworkLoopbackBenchmark : public EngineBenchmark
+{
+public:
+	NetworkLoopbackBenchmark() : EngineBenchmark("NetworkingSystem.Loopback"), m_server(nullptr), m_client(nullptr) {};
+
+	bool Setup()
+	{
+		m_server = new NetworkingSystem(UDP_SERVER, "127.0.0.1", NETWORK_BENCHMARK_PORT, 0, true, true);
+		m_client = new NetworkingSystem(UDP_CLIENT, "127.0.0.1", NETWORK_BENCHMARK_PORT, 1, true);
+		memset(m_payload, 'x', sizeof(m_payload));
+
+		// the first exchange registers the client on the server
+		return Run() != 0;
+	};
+
+	size_t Run()
+	{
+		for (int index = 0; index < NETWORK_BENCHMARK_MESSAGES; ++index)
+			m_client->PushMessage(UNRELIABLE, m_payload, NETWORK_BENCHMARK_PAYLOAD_SIZE);
+
+		m_client->Update(0.0f);
+		size_t received = 0;
+		for (int poll = 0; poll < NETWORK_BENCHMARK_MAX_POLLS && received < NETWORK_BENCHMARK_MESSAGES; ++poll)
+		{
+			m_server->Update(0.0f);
+			m_client->Update(0.0f);
+			received += m_client->GetProcessList().size();
+			m_client->ClearProcessList();
+		}
+		m_server->ClearProcessList();
+		return received;
+	};
+
+	void Teardown()
+	{
+		delete m_client;
+		delete m_server;
+		m_client = nullptr;
+		m_server = nullptr;
+	};
+
+private:
+	NetworkingSystem* m_server;
+	NetworkingSystem* m_client;
+	char m_payload[NETWORK_BENCHMARK_PAYLOAD_SIZE];
+};
+
+
+static NetworkLoopbackBenchmark s_networkLoopbackBenchmark;
+
+};
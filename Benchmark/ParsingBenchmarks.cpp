@@ -0,0 +1,285 @@
+#include "EngineBenchmark.hpp"
+
+#include "Engine\Parsing\ObjLoader\ObjLoader.hpp"
+#include "Engine\Parsing\BufferParser\BufferParser.hpp"
+#include "Engine\Parsing\ZipUtils\ZipHelper.hpp"
+#include "Engine\Parsing\ZipUtils\zip.h"
+#include "Engine\Parsing\TinyXML\tinyxml.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+
+namespace Henry
+{
+
+// The inputs are generated at setup , so the suite doesn't depend on any asset on disk.
+const int PARSING_BENCHMARK_GRID_SIZE = 64;
+const int PARSING_BENCHMARK_XML_ELEMENTS = 2048;
+const char* PARSING_BENCHMARK_OBJ_PATH = "EngineBenchmark_mesh.obj";
+const char* PARSING_BENCHMARK_BUFFER_PATH = "EngineBenchmark_mesh.buffer";
+const char* PARSING_BENCHMARK_ZIP_PATH = "EngineBenchmark_data.zip";
+const char* PARSING_BENCHMARK_PATH_IN_ZIP = "Data/glyphs.xml";
+const char* PARSING_BENCHMARK_ZIP_PASSWORD = "c23";
+
+
+static bool WriteTextFile(const char* path, const std::string& content)
+{
+	FILE* file = nullptr;
+#ifdef _MSC_VER
+	fopen_s(&file, path, "wb");
+#else
+	file = fopen(path, "wb");
+#endif
+	if (!file)
+		return false;
+
+	fwrite(content.c_str(), 1, content.size(), file);
+	fclose(file);
+	return true;
+}
+
+
+// A grid of quads with positions , texture coordinates and normals , faces as v/vt/vn triangles.
+static std::string GenerateObjText()
+{
+	std::string text("# engine benchmark grid\n");
+	char line[128];
+	for (int y = 0; y <= PARSING_BENCHMARK_GRID_SIZE; ++y)
+	{
+		for (int x = 0; x <= PARSING_BENCHMARK_GRID_SIZE; ++x)
+		{
+			float u = (float)x / PARSING_BENCHMARK_GRID_SIZE;
+			float v = (float)y / PARSING_BENCHMARK_GRID_SIZE;
+#ifdef _MSC_VER
+			sprintf_s(line, sizeof(line), "v %f %f %f\nvt %f %f\nvn 0.0 0.0 1.0\n", u * 10.0f, v * 10.0f, 0.0f, u, v);
+#else
+			snprintf(line, sizeof(line), "v %f %f %f\nvt %f %f\nvn 0.0 0.0 1.0\n", u * 10.0f, v * 10.0f, 0.0f, u, v);
+#endif
+			text += line;
+		}
+	}
+
+	int rowLength = PARSING_BENCHMARK_GRID_SIZE + 1;
+	for (int y = 0; y < PARSING_BENCHMARK_GRID_SIZE; ++y)
+	{
+		for (int x = 0; x < PARSING_BENCHMARK_GRID_SIZE; ++x)
+		{
+			int a = y * rowLength + x + 1;
+			int b = a + 1;
+			int c = a + rowLength;
+			int d = c + 1;
+#ifdef _MSC_VER
+			sprintf_s(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d\nf %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, d, d, d, a, a, a, d, d, d, c, c, c);
+#else
+			snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d\nf %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, d, d, d, a, a, a, d, d, d, c, c, c);
+#endif
+			text += line;
+		}
+	}
+
+	return text;
+}
+
+
+// The same grid as the obj file , as vertices and triangle indices.
+static void GenerateMesh(std::vector<Vertex_PCTN>& vertices, std::vector<int>& indices)
+{
+	int rowLength = PARSING_BENCHMARK_GRID_SIZE + 1;
+	vertices.resize(rowLength * rowLength);
+	for (size_t index = 0; index < vertices.size(); ++index)
+	{
+		float u = (float)(index % rowLength) / PARSING_BENCHMARK_GRID_SIZE;
+		float v = (float)(index / rowLength) / PARSING_BENCHMARK_GRID_SIZE;
+		vertices[index].position = Vec3f(u * 10.0f, v * 10.0f, 0.0f);
+		vertices[index].color = RGBA(1.0f, 1.0f, 1.0f, 1.0f);
+		vertices[index].texCoords = Vec2f(u, v);
+	}
+
+	indices.clear();
+	for (int y = 0; y < PARSING_BENCHMARK_GRID_SIZE; ++y)
+	{
+		for (int x = 0; x < PARSING_BENCHMARK_GRID_SIZE; ++x)
+		{
+			int a = y * rowLength + x;
+			indices.push_back(a);
+			indices.push_back(a + 1);
+			indices.push_back(a + rowLength + 1);
+			indices.push_back(a);
+			indices.push_back(a + rowLength + 1);
+			indices.push_back(a + rowLength);
+		}
+	}
+}
+
+
+// Shaped like a BMFont descriptor , the same kind of document BitmapFont parses.
+static std::string GenerateXmlText()
+{
+	std::string text("<?xml version=\"1.0\"?>\n<font>\n<common lineHeight=\"45\" base=\"36\" scaleW=\"1024\" scaleH=\"1024\" pages=\"1\"/>\n<chars>\n");
+	char line[256];
+	for (int index = 0; index < PARSING_BENCHMARK_XML_ELEMENTS; ++index)
+	{
+#ifdef _MSC_VER
+		sprintf_s(line, sizeof(line), "<char id=\"%d\" x=\"%d\" y=\"%d\" width=\"30\" height=\"55\" xoffset=\"-4\" yoffset=\"-5\" xadvance=\"22\" page=\"0\" chnl=\"15\" />\n",
+			index, (index * 31) % 1024, (index / 32) * 56);
+#else
+		snprintf(line, sizeof(line), "<char id=\"%d\" x=\"%d\" y=\"%d\" width=\"30\" height=\"55\" xoffset=\"-4\" yoffset=\"-5\" xadvance=\"22\" page=\"0\" chnl=\"15\" />\n",
+			index, (index * 31) % 1024, (index / 32) * 56);
+#endif
+		text += line;
+	}
+	text += "</chars>\n</font>\n";
+	return text;
+}
+
+
+class ObjLoadBenchmark : public EngineBenchmark
+{
+public:
+	ObjLoadBenchmark() : EngineBenchmark("ObjLoader.LoadFile") {};
+	bool Setup() { return WriteTextFile(PARSING_BENCHMARK_OBJ_PATH, GenerateObjText()); };
+	void Teardown() { remove(PARSING_BENCHMARK_OBJ_PATH); };
+
+	size_t Run()
+	{
+		ObjLoader loader;
+		loader.LoadFile(PARSING_BENCHMARK_OBJ_PATH);
+		return 1;
+	};
+};
+
+
+class BufferWriteBenchmark : public EngineBenchmark
+{
+public:
+	BufferWriteBenchmark() : EngineBenchmark("BufferParser.WriteFile") {};
+	bool Setup() { GenerateMesh(m_vertices, m_indices); return true; };
+	void Teardown() { remove(PARSING_BENCHMARK_BUFFER_PATH); };
+
+	size_t Run()
+	{
+		BufferParser parser;
+		parser.WriteFile(PARSING_BENCHMARK_BUFFER_PATH, m_vertices, m_indices);
+		return 1;
+	};
+
+private:
+	std::vector<Vertex_PCTN> m_vertices;
+	std::vector<int> m_indices;
+};
+
+
+// Loads the file written by BufferParser.WriteFile and reads every field back in the same order.
+class BufferReadBenchmark : public EngineBenchmark
+{
+public:
+	BufferReadBenchmark() : EngineBenchmark("BufferParser.Read") {};
+
+	bool Setup()
+	{
+		std::vector<Vertex_PCTN> vertices;
+		std::vector<int> indices;
+		GenerateMesh(vertices, indices);
+		BufferParser parser;
+		return parser.WriteFile(PARSING_BENCHMARK_BUFFER_PATH, vertices, indices);
+	};
+
+	void Teardown() { remove(PARSING_BENCHMARK_BUFFER_PATH); };
+
+	size_t Run()
+	{
+		BufferParser parser;
+		ScratchScope scratch;
+		if (!parser.LoadFile(PARSING_BENCHMARK_BUFFER_PATH, scratch))
+			return 0;
+
+		char header;
+		for (int index = 0; index < 6; ++index)
+			parser.ReadChar(header);
+
+		std::string description;
+		parser.ReadString(description);
+
+		unsigned int numberOfIndices = 0;
+		unsigned int vertexIndex;
+		parser.ReadUInt(numberOfIndices);
+		for (unsigned int index = 0; index < numberOfIndices; ++index)
+			parser.ReadUInt(vertexIndex);
+
+		unsigned int numberOfVertices = 0;
+		float component;
+		unsigned char color;
+		parser.ReadUInt(numberOfVertices);
+		for (unsigned int index = 0; index < numberOfVertices; ++index)
+		{
+			for (int field = 0; field < 3; ++field)
+				parser.ReadFloat(component);
+			for (int field = 0; field < 4; ++field)
+				parser.ReadUChar(color);
+			for (int field = 0; field < 11; ++field)
+				parser.ReadFloat(component);
+		}
+		return 1;
+	};
+};
+
+
+class ZipContentBenchmark : public EngineBenchmark
+{
+public:
+	ZipContentBenchmark() : EngineBenchmark("ZipHelper.GetContentInZip") {};
+
+	bool Setup()
+	{
+		std::string content = GenerateXmlText();
+		HZIP zipFile = CreateZip(TEXT("EngineBenchmark_data.zip"), PARSING_BENCHMARK_ZIP_PASSWORD);
+		if (!zipFile)
+			return false;
+
+		ZRESULT result = ZipAdd(zipFile, TEXT("Data/glyphs.xml"), (void*)content.c_str(), (unsigned int)content.size());
+		CloseZip(zipFile);
+		return result == ZR_OK;
+	};
+
+	void Teardown() { remove(PARSING_BENCHMARK_ZIP_PATH); };
+
+	// the archive stays open in ZipHelper::s_zipMap after the first call , so this is lookup plus inflate
+	size_t Run()
+	{
+		int length;
+		bool success;
+		const unsigned char* buffer = ZipHelper::GetContentInZip(PARSING_BENCHMARK_ZIP_PATH, PARSING_BENCHMARK_PATH_IN_ZIP, PARSING_BENCHMARK_ZIP_PASSWORD, &length, &success);
+		delete[] buffer;
+		return success ? 1 : 0;
+	};
+};
+
+
+class XmlParseBenchmark : public EngineBenchmark
+{
+public:
+	XmlParseBenchmark() : EngineBenchmark("TinyXML.Parse") {};
+	bool Setup() { m_text = GenerateXmlText(); return true; };
+	void Teardown() { m_text.clear(); };
+
+	size_t Run()
+	{
+		TiXmlDocument document;
+		document.Parse(m_text.c_str(), 0, TIXML_ENCODING_UTF8);
+		return document.Error() ? 0 : 1;
+	};
+
+private:
+	std::string m_text;
+};
+
+
+static ObjLoadBenchmark s_objLoadBenchmark;
+static BufferWriteBenchmark s_bufferWriteBenchmark;
+static BufferReadBenchmark s_bufferReadBenchmark;
+static ZipContentBenchmark s_zipContentBenchmark;
+static XmlParseBenchmark s_xmlParseBenchmark;
+
+};
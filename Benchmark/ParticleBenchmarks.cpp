@@ -0,0 +1,70 @@
+#include "EngineBenchmark.hpp"
+
+#include "Engine\Physic\ParticleSystem.hpp"
+#include "Engine\Physic\ParticleUpdateFunctions.hpp"
+
+#include <stdlib.h>
+
+
+namespace Henry
+{
+
+const int PARTICLE_BENCHMARK_COUNT = 10000;
+const float PARTICLE_BENCHMARK_DELTA_SECONDS = 1.0f / 60.0f;
+
+
+// One ParticleSystem::Update over a full system , once for every update kernel.
+class ParticleUpdateBenchmark : public EngineBenchmark
+{
+public:
+	ParticleUpdateBenchmark(const char* name, ParticleUpdate* updateFunction) : EngineBenchmark(name), m_updateFunction(updateFunction), m_particleSystem(nullptr) {};
+
+	bool Setup()
+	{
+		srand(1);
+		Emitter emitter(Vec3f(-1.0f, -1.0f, -1.0f), Vec3f(1.0f, 1.0f, 1.0f), Vec3f(0.0f, 0.0f, 5.0f), m_updateFunction, SPHERE, 1.0f);
+		emitter.gravity = Vec3f(0.0f, 0.0f, -9.8f);
+
+		Particle particle;
+		particle.mass = 1.0f;
+		particle.k = 1.0f;
+		particle.c = 0.1f;
+		particle.position = Vec3f(0.0f, 0.0f, 0.0f);
+		particle.velocity = emitter.velocity;
+		particle.surviveTime = 2.0f;
+		particle.size = 0.1f;
+		particle.color = RGBA(1.0f, 1.0f, 1.0f, 1.0f);
+
+		m_particleSystem = new ParticleSystem(emitter, particle, PARTICLE_BENCHMARK_COUNT, particle.surviveTime, true);
+		return true;
+	};
+
+	size_t Run()
+	{
+		m_particleSystem->Update(PARTICLE_BENCHMARK_DELTA_SECONDS);
+		return m_particleSystem->m_maxNum;
+	};
+
+	void Teardown()
+	{
+		delete m_particleSystem;
+		m_particleSystem = nullptr;
+	};
+
+private:
+	ParticleUpdate* m_updateFunction;
+	ParticleSystem* m_particleSystem;
+};
+
+
+static ParticleUpdateBenchmark s_leafBenchmark("ParticleSystem.Update.Leaf", &ParticleUpdateFunctions::LeafUpdate);
+static ParticleUpdateBenchmark s_explosionBenchmark("ParticleSystem.Update.Explosion", &ParticleUpdateFunctions::ExplosionUpdate);
+static ParticleUpdateBenchmark s_fountainBenchmark("ParticleSystem.Update.Fountain", &ParticleUpdateFunctions::FountainUpdate);
+static ParticleUpdateBenchmark s_debrisBenchmark("ParticleSystem.Update.Debris", &ParticleUpdateFunctions::DebrisUpdate);
+static ParticleUpdateBenchmark s_fireworkBenchmark("ParticleSystem.Update.Firework", &ParticleUpdateFunctions::FireworkUpdate);
+static ParticleUpdateBenchmark s_snowBenchmark("ParticleSystem.Update.Snow", &ParticleUpdateFunctions::SnowUpdate);
+static ParticleUpdateBenchmark s_fireBallBenchmark("ParticleSystem.Update.FireBall", &ParticleUpdateFunctions::FireBallUpdate);
+static ParticleUpdateBenchmark s_smokeBenchmark("ParticleSystem.Update.Smoke", &ParticleUpdateFunctions::SmokeUpdate);
+static ParticleUpdateBenchmark s_burstBenchmark("ParticleSystem.Update.Burst", &ParticleUpdateFunctions::BurstUpdate);
+
+};
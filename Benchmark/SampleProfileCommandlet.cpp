@@ -0,0 +1,62 @@
+#include "Engine\Commandlet\Commandlet.hpp"
+#include "Engine\Commandlet\CommandletRegistration.hpp"
+#include "Engine\Core\SamplingProfiler.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+
+namespace Henry
+{
+
+static std::string s_sampleProfilePath;
+
+
+static void WriteSampleProfileAtExit()
+{
+	SamplingProfiler::Stop();
+	if (SamplingProfiler::WriteFoldedStacks(s_sampleProfilePath.c_str(), true))
+		printf("sample profile : %d samples , %d dropped , written to %s\n", (int)SamplingProfiler::GetNumberOfSamples(),
+			(int)SamplingProfiler::GetNumberOfDroppedSamples(), s_sampleProfilePath.c_str());
+	else
+		printf("Can't write sample profile %s\n", s_sampleProfilePath.c_str());
+}
+
+
+// Samples the benchmarks that follow it on the command line and writes folded stacks when the process exits.
+// e.g. EngineBenchmark -SampleProfile alloc.folded 997 -AllocationReplay synthetic 10
+// Benchmarks that run in forked children merge the children's stacks into the same file.
+class SampleProfileCommandlet : public Commandlet
+{
+public:
+	SampleProfileCommandlet(const CommandletArguments* args) : Commandlet(args) { m_exitAfterExecuted = false; };
+	bool Execute();
+	static Commandlet* CreateCommand(const CommandletArguments* args) { return new SampleProfileCommandlet(args); };
+};
+
+
+bool SampleProfileCommandlet::Execute()
+{
+	const std::vector<std::string>& arguments = m_commandletArgs->arguments;
+	s_sampleProfilePath = arguments.size() > 0 ? arguments[0] : "samples.folded";
+	unsigned int frequency = arguments.size() > 1 ? (unsigned int)atoi(arguments[1].c_str()) : SAMPLING_DEFAULT_FREQUENCY;
+
+	if (!SamplingProfiler::Start(frequency))
+	{
+		printf("Can't start the sampling profiler\n");
+		return m_exitAfterExecuted;
+	}
+
+	// the children and the exit handler merge into the file , so start it empty
+	remove(s_sampleProfilePath.c_str());
+	SamplingProfiler::SetOutputPath(s_sampleProfilePath.c_str());
+
+	atexit(WriteSampleProfileAtExit);
+	return m_exitAfterExecuted;
+}
+
+
+static CommandletRegistration s_sampleProfileRegistration("SampleProfile", &SampleProfileCommandlet::CreateCommand);
+
+};
@@ -1,267 +1,418 @@
 #include "Clock.hpp"
 
 #include "Engine\Core\HenryFunctions.hpp"
+#include "Engine\Core\Timebase.hpp"
 
-#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
-#include <algorithm>
-#include <string> 
-#include <iostream>
+#include <string>
 
 
 namespace Henry
 {
 
-std::map< std::string , Clock* > Clock::s_clockMap;
-Clock* Clock::s_rootClock = nullptr;
-double Clock::s_secondsPerCount;
+DEFINE_POOLED_ALLOCATION(Alarm, 256)
 
-double IntializeTimeSystem(LARGE_INTEGER& out_initialTime)
+
+static unsigned long long GetAlarmTicks(double seconds)
 {
-	LARGE_INTEGER countsPerSecond;
-	QueryPerformanceFrequency( &countsPerSecond );
-	QueryPerformanceCounter( &out_initialTime );
-	return( 1.0 / static_cast< double >( countsPerSecond.QuadPart ) );
+	return seconds > 0.0 ? (unsigned long long)(seconds / ALARM_TICK_SECONDS + 0.000001) : 0;
 }
 
 
-Clock::Clock(const std::string& name , Clock* parentClock , float timeScale , double maxTimeStep) 
-	: m_name(name)
-	, m_parent(parentClock)
-	, m_timeScale(timeScale)
-	, m_lastTimeStep(0.0)
-	, m_pause(false)
-	, m_maxDeltaTimeStep(maxTimeStep)
-	, m_currentTimeSeconds(0.0)
-{
-	if(!m_parent)
-	{
-		if(s_clockMap.size() == 0 && !s_rootClock)
-		{
-			s_rootClock = this;
-			m_parent = nullptr;
-		}
-		else
-		{
-			m_parent = s_rootClock;
-			m_parent->AppendChild(this);
-		}
-	}
-	else
-	{
-		m_parent->AppendChild(this);
-	}
+// At least one tick , so an alarm never fires in the same step it was scheduled in.
+static unsigned long long GetAlarmPeriodTicks(double period)
+{
+	unsigned long long periodTicks = GetAlarmTicks(period);
+	if ((double)periodTicks * ALARM_TICK_SECONDS < period - 0.000000001)
+		++periodTicks;
+	return periodTicks != 0 ? periodTicks : 1;
+}
 
-	std::transform(m_name.begin(), m_name.end(), m_name.begin(), ::tolower);
-	int nameIndex = 0;
-	std::string checkName(m_name);
-	while(s_clockMap[checkName])
-	{
-		checkName = m_name + std::to_string((long double)nameIndex);
-		++nameIndex;
-	}
-	
-	m_name = checkName;
-	s_clockMap[m_name] = this;
+
+struct AlarmNameMatch
+{
+	AlarmNameMatch(const std::string& name) : m_name(name) {};
+	bool operator()(TimingWheelNode* node) const { return m_name == static_cast<Alarm*>(node)->m_name; };
+	const std::string& m_name;
+};
+
+MemoryResource* Clock::GetMemoryResource()
+{
+	static PoolMemoryResource s_clockResource("Clocks");
+	return &s_clockResource;
 }
 
+ResourceVector<Clock*> Clock::s_clocks( ResourceAllocator<Clock*>( Clock::GetMemoryResource() ) );
+ResourceVector<int> Clock::s_parents( ResourceAllocator<int>( Clock::GetMemoryResource() ) );
+ResourceVector<unsigned int> Clock::s_subtreeSizes( ResourceAllocator<unsigned int>( Clock::GetMemoryResource() ) );
+ResourceVector<float> Clock::s_timeScales( ResourceAllocator<float>( Clock::GetMemoryResource() ) );
+ResourceVector<double> Clock::s_maxTimeSteps( ResourceAllocator<double>( Clock::GetMemoryResource() ) );
+ResourceVector<unsigned char> Clock::s_paused( ResourceAllocator<unsigned char>( Clock::GetMemoryResource() ) );
+ResourceVector<double> Clock::s_times( ResourceAllocator<double>( Clock::GetMemoryResource() ) );
+ResourceVector<double> Clock::s_lastTimeSteps( ResourceAllocator<double>( Clock::GetMemoryResource() ) );
+ResourceVector<double> Clock::s_scaledTimeSteps( ResourceAllocator<double>( Clock::GetMemoryResource() ) );
+ResourceVector<ClockSlot> Clock::s_slots( ResourceAllocator<ClockSlot>( Clock::GetMemoryResource() ) );
+ResourceVector<unsigned int> Clock::s_freeSlots( ResourceAllocator<unsigned int>( Clock::GetMemoryResource() ) );
+ResourceVector<ClockHandle> Clock::s_alarmClocks( ResourceAllocator<ClockHandle>( Clock::GetMemoryResource() ) );
+ResourceVector<ClockPendingDestroy> Clock::s_pendingDestroys( ResourceAllocator<ClockPendingDestroy>( Clock::GetMemoryResource() ) );
+unsigned int Clock::s_firingDepth = 0;
+ClockNameIndex Clock::s_nameIndex( 16 , std::hash<std::string>() , std::equal_to<std::string>() , ClockNameIndex::allocator_type( Clock::GetMemoryResource() ) );
+ClockHandle Clock::s_rootClock;
+
+
+template <typename T>
+static void InsertValue(ResourceVector<T>& values, unsigned int index, const T& value)
+{
+	values.insert(values.begin() + index, value);
+}
 
-Clock::~Clock(void)
+
+template <typename T>
+static void EraseValues(ResourceVector<T>& values, unsigned int begin, unsigned int count)
 {
-	deleteVectorOfPointer(m_childClocks);
+	values.erase(values.begin() + begin, values.begin() + begin + count);
 }
 
 
-void Clock::AppendChild(Clock* clock)
+Clock::Clock(const std::string& name, ClockHandle handle, unsigned int denseIndex)
+	: m_name(name)
+	, m_handle(handle)
+	, m_denseIndex(denseIndex)
+	, m_firingAlarm(nullptr)
 {
-	m_childClocks.push_back(clock);
 }
 
 
-void Clock::RemoveClock(Clock* clock)
+Clock::~Clock()
 {
-	std::map<std::string,Clock*>::iterator it = s_clockMap.begin();
-	while(it != s_clockMap.end())
+	// FireAlarms still holds it , popped from the wheel
+	if(m_firingAlarm && m_firingAlarm->m_attachedClock == this)
+		m_firingAlarm->m_attachedClock = nullptr;
+
+	while(Alarm* alarm = static_cast<Alarm*>(m_alarms.PopAny()))
 	{
-		Clock* currentClock = it->second;
-		if(currentClock == clock)
-		{
-			s_clockMap.erase(it);
-			break;
-		}
-		++it;
+		alarm->m_attachedClock = nullptr;
+		delete alarm;
 	}
-
-	delete clock;
-	clock = nullptr;
 }
 
 
-void Clock::RemoveChild(Clock* clock)
+// No parent attaches the clock under the root clock , the first clock made becomes the root.
+// A stale parent handle makes nothing and returns an invalid handle.
+ClockHandle Clock::Create(const std::string& name, ClockHandle parent, float timeScale, double maxTimeStep, bool indexName)
 {
-	std::vector<Clock*>::iterator it = m_childClocks.begin();
-	while(it != m_childClocks.end())
+	Clock* parentClock = Get(parent);
+	if(!parentClock)
 	{
-		Clock* currentClock = *it;
-		if(currentClock == clock || !clock)
-		{
-			m_childClocks.erase(it);
-			RemoveClock(currentClock);
-			break;
-		}
-		++it;
+		if(parent.IsValid())
+			return ClockHandle();
+		parentClock = Get(s_rootClock);
+	}
+
+	int parentIndex = parentClock ? (int)parentClock->m_denseIndex : -1;
+	unsigned int denseIndex = parentClock ? parentClock->m_denseIndex + s_subtreeSizes[parentClock->m_denseIndex] : (unsigned int)s_clocks.size();
+
+	unsigned int slot;
+	if(!s_freeSlots.empty())
+	{
+		slot = s_freeSlots.back();
+		s_freeSlots.pop_back();
 	}
+	else
+	{
+		ClockSlot newSlot = { CLOCK_INVALID_INDEX , 1 };
+		slot = (unsigned int)s_slots.size();
+		s_slots.push_back(newSlot);
+	}
+
+	ClockHandle handle(slot, s_slots[slot].m_generation);
+	InsertValue(s_clocks, denseIndex, new Clock(name, handle, denseIndex));
+	InsertValue(s_parents, denseIndex, parentIndex);
+	InsertValue(s_subtreeSizes, denseIndex, 1u);
+	InsertValue(s_timeScales, denseIndex, timeScale);
+	InsertValue(s_maxTimeSteps, denseIndex, maxTimeStep);
+	InsertValue(s_paused, denseIndex, (unsigned char)0);
+	InsertValue(s_times, denseIndex, 0.0);
+	InsertValue(s_lastTimeSteps, denseIndex, 0.0);
+	InsertValue(s_scaledTimeSteps, denseIndex, 0.0);
+
+	for(size_t index = denseIndex + 1; index < s_parents.size(); ++index)
+	{
+		if(s_parents[index] >= (int)denseIndex)
+			++s_parents[index];
+	}
+	for(int ancestor = parentIndex; ancestor >= 0; ancestor = s_parents[ancestor])
+		++s_subtreeSizes[ancestor];
+	UpdateDenseIndices(denseIndex);
+
+	if(!parentClock)
+		s_rootClock = handle;
+	if(indexName)
+		s_nameIndex.insert(ClockNameIndex::value_type(name, handle));
+	return handle;
 }
 
 
-void Clock::Dispose(bool appendChildToParent /* = false */)
+// Destroys the clock and its subtree , or only the clock with its children moved up to its parent.
+// The alarms of every destroyed clock are deleted. Called from an alarm callback , the clock stays until
+// every alarm due in that advance has fired , so no clock is deleted under FireAlarms.
+void Clock::Destroy(ClockHandle handle, bool appendChildrenToParent /* = false */)
 {
-	if(appendChildToParent)
+	if(s_firingDepth != 0)
 	{
-		if(m_parent != nullptr)
-		{
-			std::vector<Clock*>::iterator it = m_childClocks.begin();
-			for( ; it != m_childClocks.end(); ++it)
-			{
-				Clock* currentClock = *it;
-				m_parent->AppendChild(currentClock);
-			}
+		ClockPendingDestroy pendingDestroy = { handle , appendChildrenToParent };
+		s_pendingDestroys.push_back(pendingDestroy);
+		return;
+	}
 
-			m_parent->RemoveChild(this);
-		}
-		else
+	Clock* clock = Get(handle);
+	if(!clock)
+		return;
+
+	unsigned int begin = clock->m_denseIndex;
+	int parentIndex = s_parents[begin];
+	unsigned int count = appendChildrenToParent ? 1 : s_subtreeSizes[begin];
+	if(appendChildrenToParent)
+	{
+		for(unsigned int index = begin + 1; index < begin + s_subtreeSizes[begin]; ++index)
 		{
-			//assert
+			if(s_parents[index] == (int)begin)
+				s_parents[index] = parentIndex;
 		}
 	}
-	else
+
+	for(unsigned int index = begin; index < begin + count; ++index)
 	{
-		if(m_parent)
-			m_parent->RemoveChild(this);
-		else if(this == s_rootClock)
-			s_rootClock = nullptr;
-		else
-		{
-			//assert
-		}
+		Clock* destroyed = s_clocks[index];
+		ClockSlot& slot = s_slots[destroyed->m_handle.m_slot];
+		slot.m_denseIndex = CLOCK_INVALID_INDEX;
+		++slot.m_generation;
+		s_freeSlots.push_back(destroyed->m_handle.m_slot);
+
+		ClockNameIndex::iterator it = s_nameIndex.find(destroyed->m_name);
+		if(it != s_nameIndex.end() && it->second == destroyed->m_handle)
+			s_nameIndex.erase(it);
+		if(destroyed->m_handle == s_rootClock)
+			s_rootClock = ClockHandle();
+		delete destroyed;
+	}
 
-		delete this;
+	EraseValues(s_clocks, begin, count);
+	EraseValues(s_parents, begin, count);
+	EraseValues(s_subtreeSizes, begin, count);
+	EraseValues(s_timeScales, begin, count);
+	EraseValues(s_maxTimeSteps, begin, count);
+	EraseValues(s_paused, begin, count);
+	EraseValues(s_times, begin, count);
+	EraseValues(s_lastTimeSteps, begin, count);
+	EraseValues(s_scaledTimeSteps, begin, count);
+
+	for(int ancestor = parentIndex; ancestor >= 0; ancestor = s_parents[ancestor])
+		s_subtreeSizes[ancestor] -= count;
+	for(size_t index = begin; index < s_parents.size(); ++index)
+	{
+		if(s_parents[index] >= (int)begin)
+			s_parents[index] -= count;
 	}
+	UpdateDenseIndices(begin);
 }
 
 
-double Clock::GetAbsoluteTimeSeconds()
+Clock* Clock::Get(ClockHandle handle)
 {
-	static LARGE_INTEGER initialTime;
-	static double secondsPerCount = IntializeTimeSystem( initialTime );
-	LARGE_INTEGER currentCount;
-	QueryPerformanceCounter( &currentCount );
-	LONGLONG elapsedCountsSinceInitialTime = currentCount.QuadPart - initialTime.QuadPart;
+	if(handle.m_slot >= s_slots.size())
+		return nullptr;
 
-	double currentSeconds = static_cast< double >( elapsedCountsSinceInitialTime ) * secondsPerCount;
-	return currentSeconds;
+	const ClockSlot& slot = s_slots[handle.m_slot];
+	if(slot.m_generation != handle.m_generation || slot.m_denseIndex == CLOCK_INVALID_INDEX)
+		return nullptr;
+	return s_clocks[slot.m_denseIndex];
 }
 
 
-void Clock::AdvanceTime(double deltaTime)
+ClockHandle Clock::Find(const std::string& name)
 {
-	if(m_pause)
-		return;
+	ClockNameIndex::const_iterator it = s_nameIndex.find(name);
+	return it != s_nameIndex.end() ? it->second : ClockHandle();
+}
 
-	if(deltaTime > m_maxDeltaTimeStep)
-		deltaTime = m_maxDeltaTimeStep;
 
-	std::vector<Clock*>::iterator clock_it = m_childClocks.begin();
-	for( ; clock_it != m_childClocks.end(); ++clock_it)
-	{
-		Clock* currentClock = *clock_it;
-		currentClock->AdvanceTime(deltaTime);
-	}
+ClockHandle Clock::GetParent() const
+{
+	int parentIndex = s_parents[m_denseIndex];
+	return parentIndex >= 0 ? s_clocks[parentIndex]->m_handle : ClockHandle();
+}
 
-	std::vector<Alarm*>::iterator alarm_it = m_alarms.begin();
-	while(alarm_it != m_alarms.end())
+
+void Clock::UpdateDenseIndices(unsigned int begin)
+{
+	for(unsigned int index = begin; index < s_clocks.size(); ++index)
 	{
-		Alarm* currentAlarm = *alarm_it;
-		currentAlarm->AdvanceTime(deltaTime);
-		if(currentAlarm->m_destroy)
-		{
-			alarm_it = m_alarms.erase(alarm_it);
-			delete currentAlarm;
-			currentAlarm = nullptr;
-		}
-		else
-			++alarm_it;
+		Clock* clock = s_clocks[index];
+		clock->m_denseIndex = index;
+		s_slots[clock->m_handle.m_slot].m_denseIndex = index;
 	}
+}
+
 
-	m_currentTimeSeconds += deltaTime * m_timeScale;
-	m_lastTimeStep = deltaTime;
+double Clock::GetAbsoluteTimeSeconds()
+{
+	return Timebase::GetSecondsSinceStart();
 }
 
 
-double Clock::GetTime()
+unsigned long long Clock::GetAbsoluteTimeTicks()
 {
-	return m_currentTimeSeconds;
+	return Timebase::GetTicks();
 }
 
 
-void Clock::Pause()
+// Advances every root clock , and so every clock , by deltaTime.
+void Clock::AdvanceAll(double deltaTime)
 {
-	m_pause = true;
+	AdvanceRange(0, (unsigned int)s_clocks.size(), deltaTime);
 }
 
 
-void Clock::UnPause()
+// Advances this clock and its subtree , the rest of the hierarchy doesn't move.
+void Clock::AdvanceTime(double deltaTime)
 {
-	m_pause = false;
+	AdvanceRange(m_denseIndex, m_denseIndex + s_subtreeSizes[m_denseIndex], deltaTime);
 }
 
 
-void Clock::AppendAlarm(Alarm* alarm)
+// Parents come before their children , so one pass in table order sees every parent's step first.
+// Alarms fire afterwards , a callback may then create or destroy clocks without breaking the pass.
+void Clock::AdvanceRange(unsigned int begin, unsigned int end, double deltaTime)
 {
-	alarm->m_attachedClock = this;
-	m_alarms.push_back(alarm);
+	size_t firstAlarmClock = s_alarmClocks.size();
+	for(unsigned int index = begin; index < end; ++index)
+	{
+		int parentIndex = s_parents[index];
+		double timeStep = parentIndex < (int)begin ? deltaTime : s_scaledTimeSteps[parentIndex];
+		if(s_paused[index])
+		{
+			s_scaledTimeSteps[index] = 0.0;
+			continue;
+		}
+
+		if(timeStep > s_maxTimeSteps[index])
+			timeStep = s_maxTimeSteps[index];
+
+		double scaledTimeStep = timeStep * s_timeScales[index];
+		s_times[index] += scaledTimeStep;
+		s_scaledTimeSteps[index] = scaledTimeStep;
+		s_lastTimeSteps[index] = timeStep;
+
+		if(s_clocks[index]->m_alarms.GetNumberOfNodes() != 0)
+			s_alarmClocks.push_back(s_clocks[index]->m_handle);
+	}
+
+	// indexed rather than iterated , a callback advancing clocks itself appends past the end and trims back
+	++s_firingDepth;
+	for(size_t alarmClock = firstAlarmClock; alarmClock < s_alarmClocks.size(); ++alarmClock)
+	{
+		Clock* clock = Get(s_alarmClocks[alarmClock]);
+		if(clock && clock->m_alarms.Advance(GetAlarmTicks(clock->GetTime())) != 0)
+			clock->FireAlarms();
+	}
+	s_alarmClocks.resize(firstAlarmClock);
+	--s_firingDepth;
+
+	if(s_firingDepth == 0 && !s_pendingDestroys.empty())
+	{
+		for(size_t pendingDestroy = 0; pendingDestroy < s_pendingDestroys.size(); ++pendingDestroy)
+			Destroy(s_pendingDestroys[pendingDestroy].m_handle, s_pendingDestroys[pendingDestroy].m_appendChildrenToParent);
+		s_pendingDestroys.clear();
+	}
 }
 
 
-void Clock::RemoveAlarm(const Alarm* alarm)
+// A callback may append or remove any alarm , itself included , an alarm it re-armed or took away is left alone.
+void Clock::FireAlarms()
 {
-	std::vector<Alarm*>::iterator it = m_alarms.begin();
-	while(it != m_alarms.end())
+	while(Alarm* alarm = static_cast<Alarm*>(m_alarms.PopExpired()))
 	{
-		Alarm* currentAlarm = *it;
-		if( alarm == currentAlarm )
+		unsigned long long expireTick = alarm->m_expireTick;
+		m_firingAlarm = alarm;
+		alarm->FireCallbackFunction();
+		m_firingAlarm = nullptr;
+		if(alarm->m_attachedClock != this || TimingWheel::IsScheduled(alarm))
+			continue;
+
+		if(alarm->m_repeat)
+		{
+			// periods missed by a long step are skipped rather than fired back to back
+			unsigned long long periodTicks = GetAlarmPeriodTicks(alarm->m_period);
+			unsigned long long nextTick = expireTick + periodTicks;
+			if(nextTick <= m_alarms.GetCurrentTick())
+				nextTick = m_alarms.GetCurrentTick() + periodTicks;
+			m_alarms.Schedule(alarm, nextTick);
+		}
+		else
 		{
-			m_alarms.erase(it);
-			break;
+			alarm->m_attachedClock = nullptr;
+			delete alarm;
 		}
-		++it;
 	}
 }
 
 
+// The clock owns the alarm from here , a one shot alarm is deleted after it fired.
+void Clock::AppendAlarm(Alarm* alarm)
+{
+	if(alarm->m_attachedClock && alarm->m_attachedClock != this)
+		alarm->m_attachedClock->RemoveAlarm(alarm);
+
+	// a wheel left empty wasn't advanced , catch it up to the clock first
+	if(m_alarms.GetNumberOfNodes() == 0)
+		m_alarms.Advance(GetAlarmTicks(GetTime()));
+
+	alarm->m_attachedClock = this;
+	m_alarms.Schedule(alarm, m_alarms.GetCurrentTick() + GetAlarmPeriodTicks(alarm->m_period));
+}
+
+
+// Hands the alarm back to the caller without deleting it.
+void Clock::RemoveAlarm(Alarm* alarm)
+{
+	if(alarm->m_attachedClock != this)
+		return;
+
+	m_alarms.Cancel(alarm);
+	alarm->m_attachedClock = nullptr;
+}
+
+
 Alarm* Clock::FindAlarm(const std::string& name)
 {
-	std::vector<Alarm*>::iterator it = m_alarms.begin();
-	while(it != m_alarms.end())
-	{
-		Alarm* currentAlarm = *it;
-		if(currentAlarm->m_name == name)
-			return currentAlarm;
+	return static_cast<Alarm*>(m_alarms.FindNode(AlarmNameMatch(name)));
+}
 
-		++it;
-	}
 
-	return nullptr;
+Alarm::~Alarm()
+{
+	if(m_attachedClock)
+		m_attachedClock->RemoveAlarm(this);
+}
+
+
+double Alarm::GetSecondsRemaining()
+{
+	if(!m_attachedClock)
+		return m_period;
+
+	double secondsRemaining = m_expireTick * ALARM_TICK_SECONDS - m_attachedClock->GetTime();
+	return secondsRemaining > 0.0 ? secondsRemaining : 0.0;
 }
 
 
-void Alarm::FireCallbackFunction()
+// Double quotes keep spaces inside one argument.
+static void SplitAlarmArguments(const std::string& rawArgs, std::vector<std::string>& argList)
 {
-	std::string rawArgs = m_args.m_rawArgString;
 	bool sectionStarted = true;
 	bool insideSection = false;
 	std::string temp;
-	for(size_t index = 0; index < m_args.m_rawArgString.length(); index++)
+	for(size_t index = 0; index < rawArgs.length(); index++)
 	{
 		if(rawArgs[index] == '\"' || (!insideSection && rawArgs[index] == ' '))
 		{
@@ -276,30 +427,53 @@ void Alarm::FireCallbackFunction()
 		{
 			if(temp.length() != 0)
 			{
-				m_args.m_argList.push_back(temp);
+				argList.push_back(temp);
 				temp.clear();
 			}
 
 			sectionStarted = !sectionStarted;
 		}
 	}
+}
 
-	m_callbackFunction( m_args );
+
+AlarmStringCall::AlarmStringCall(const std::string& name, AlarmCallbackFunc* function, const std::string& args)
+	: m_state(new State())
+{
+	m_state->m_name = name;
+	m_state->m_function = function;
+	m_state->m_args.m_rawArgString = args;
+	SplitAlarmArguments(args, m_state->m_args.m_argList);
 }
 
 
-void Alarm::AdvanceTime(double deltaSeconds)
+AlarmStringCall::~AlarmStringCall()
 {
-	m_currentTime += deltaSeconds;
-	if(m_currentTime >= m_period)
-	{
-		FireCallbackFunction();
-		if(m_repeat)
-			m_currentTime = 0.0;
-		else
-			m_destroy = true;
-	}
+	delete m_state;
+}
+
+
+void AlarmStringCall::operator()(Alarm&) const
+{
+	m_state->m_function(m_state->m_args);
+}
+
+
+Alarm::Alarm( const std::string& name , double period , AlarmCallbackFunc func , const std::string& args , bool repeat )
+	: m_period(period)
+	, m_repeat(repeat)
+	, m_attachedClock(nullptr)
+{
+	m_name = m_callback.Emplace<AlarmStringCall>(name, func, args).m_state->m_name.c_str();
 }
 
 
+Alarm::Alarm( const char* name , double period , AlarmCallbackFunc func , const char* args , bool repeat )
+	: m_period(period)
+	, m_repeat(repeat)
+	, m_attachedClock(nullptr)
+{
+	m_name = m_callback.Emplace<AlarmStringCall>(std::string(name), func, std::string(args)).m_state->m_name.c_str();
+}
+
 };
\ No newline at end of file
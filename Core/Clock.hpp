@@ -5,11 +5,50 @@
 
 #include <string>
 #include <vector>
-#include <map>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <unordered_map>
+
+#include "Engine\Memory\ObjectPool.hpp"
+#include "Engine\Memory\MemoryResource.hpp"
+#include "Engine\Core\TimingWheel.hpp"
 
 namespace Henry
 {
 
+class Clock;
+
+const unsigned int CLOCK_INVALID_INDEX = 0xffffffff;
+
+// Index into the clock table plus the generation of the slot , a handle kept after its clock was
+// destroyed stays stale even when the slot is reused.
+struct ClockHandle
+{
+	ClockHandle() : m_slot(CLOCK_INVALID_INDEX) , m_generation(0) {};
+	ClockHandle(unsigned int slot, unsigned int generation) : m_slot(slot) , m_generation(generation) {};
+	bool IsValid() const { return m_slot != CLOCK_INVALID_INDEX; };
+	bool operator==(const ClockHandle& other) const { return m_slot == other.m_slot && m_generation == other.m_generation; };
+	bool operator!=(const ClockHandle& other) const { return !(*this == other); };
+
+	unsigned int m_slot;
+	unsigned int m_generation;
+};
+
+struct ClockPendingDestroy
+{
+	ClockHandle m_handle;
+	bool m_appendChildrenToParent;
+};
+
+struct ClockSlot
+{
+	unsigned int m_denseIndex;		// CLOCK_INVALID_INDEX while the slot is free
+	unsigned int m_generation;
+};
+
+typedef std::unordered_map< std::string , ClockHandle , std::hash<std::string> , std::equal_to<std::string> , ResourceAllocator< std::pair< const std::string , ClockHandle > > > ClockNameIndex;
+
 struct AlarmCallbackArgs
 {
 	std::string m_rawArgString;
@@ -18,69 +57,203 @@ struct AlarmCallbackArgs
 
 typedef void(AlarmCallbackFunc)(const AlarmCallbackArgs& args);
 
+// Alarms run on their clock's time , scaled and stopped while paused , in steps of ALARM_TICK_SECONDS.
+const double ALARM_TICK_SECONDS = 0.001;
+const size_t ALARM_CALLBACK_STORAGE = 48;
+
+struct Alarm;
+
+// Type erased void(Alarm&) callable kept inside the alarm , a functor with its payload or a lambda.
+// Anything larger than ALARM_CALLBACK_STORAGE fails to compile instead of falling back to the heap.
+class AlarmCallback
+{
+public:
+	AlarmCallback() : m_invoke(nullptr) , m_destroy(nullptr) {};
+	~AlarmCallback() { Reset(); };
+
+	template <typename Callable>
+	void Set(const Callable& callable) { Emplace<Callable>(callable); };
+
+	template <typename Callable, typename... Args>
+	Callable& Emplace(Args&&... args)
+	{
+		static_assert(sizeof(Callable) <= ALARM_CALLBACK_STORAGE, "Alarm callback too large , keep the payload under ALARM_CALLBACK_STORAGE bytes");
+		static_assert(std::alignment_of<Callable>::value <= std::alignment_of<decltype(m_storage)>::value, "Alarm callback over aligned");
+		Reset();
+		Callable* callable = new (m_storage.m_bytes) Callable(std::forward<Args>(args)...);
+		m_invoke = &Invoke<Callable>;
+		m_destroy = &Destroy<Callable>;
+		return *callable;
+	};
+
+	void Reset()
+	{
+		if (m_destroy)
+			m_destroy(m_storage.m_bytes);
+		m_invoke = nullptr;
+		m_destroy = nullptr;
+	};
+
+	bool IsSet() const { return m_invoke != nullptr; };
+	void operator()(Alarm& alarm) { if (m_invoke) m_invoke(m_storage.m_bytes, alarm); };
+
+private:
+	AlarmCallback(const AlarmCallback&);
+	void operator=(const AlarmCallback&);
+
+	template <typename Callable>
+	static void Invoke(void* storage, Alarm& alarm) { (*static_cast<Callable*>(storage))(alarm); };
+	template <typename Callable>
+	static void Destroy(void* storage) { static_cast<Callable*>(storage)->~Callable(); };
+
+	void (*m_invoke)(void* storage, Alarm& alarm);
+	void (*m_destroy)(void* storage);
+	union
+	{
+		double m_alignDouble;
+		void* m_alignPointer;
+		unsigned char m_bytes[ALARM_CALLBACK_STORAGE];
+	} m_storage;
+};
+
+
+// A free function and the payload it is called with , for callbacks that don't warrant a functor :
+//		clock->AppendAlarm(new Alarm("resend", 0.2, BindAlarm(&ResendPacket, ResendInfo(connection, sequence)), true));
+template <typename Payload>
+struct AlarmFunctionCall
+{
+	AlarmFunctionCall(void (*function)(Alarm& alarm, const Payload& payload), const Payload& payload) : m_function(function) , m_payload(payload) {};
+	void operator()(Alarm& alarm) const { m_function(alarm, m_payload); };
+
+	void (*m_function)(Alarm& alarm, const Payload& payload);
+	Payload m_payload;
+};
+
+template <typename Payload>
+AlarmFunctionCall<Payload> BindAlarm(void (*function)(Alarm& alarm, const Payload& payload), const Payload& payload)
+{
+	return AlarmFunctionCall<Payload>(function, payload);
+}
+
+
+// Adapter for the string form , the arguments are split once when the alarm is made.
+struct AlarmStringCall
+{
+	AlarmStringCall(const std::string& name, AlarmCallbackFunc* function, const std::string& args);
+	~AlarmStringCall();
+	void operator()(Alarm& alarm) const;
+
+	struct State
+	{
+		std::string m_name;
+		AlarmCallbackFunc* m_function;
+		AlarmCallbackArgs m_args;
+	};
+	State* m_state;
+
+private:
+	AlarmStringCall(const AlarmStringCall&);
+	void operator=(const AlarmStringCall&);
+};
+
+
 class Clock;
-struct Alarm
+struct Alarm : public TimingWheelNode
 {
-	Alarm( std::string name , double period , AlarmCallbackFunc func , const std::string& args , bool repeat = false) 
-		: m_name(name) 
-		, m_period(period) 
-		, m_currentTime(0.0)
-		, m_repeat(repeat) 
-		, m_callbackFunction(func) 
-		, m_attachedClock(nullptr)
-		, m_destroy(false) { m_args.m_rawArgString = args; };
+	DECLARE_POOLED_ALLOCATION(Alarm)
 
-	std::string m_name;
+	// Nothing is allocated to schedule or fire these. The name isn't copied , a string literal usually.
+	template <typename Callable>
+	Alarm( const char* name , double period , const Callable& callable , bool repeat = false )
+		: m_name(name ? name : "")
+		, m_period(period)
+		, m_repeat(repeat)
+		, m_attachedClock(nullptr) { m_callback.Set(callable); };
+
+	Alarm( const std::string& name , double period , AlarmCallbackFunc func , const std::string& args , bool repeat = false );
+	Alarm( const char* name , double period , AlarmCallbackFunc func , const char* args , bool repeat = false );
+	~Alarm();
+
+	const char* m_name;
 	double m_period;
-	double m_currentTime;
 	bool m_repeat;
-	bool m_destroy;
-
-	AlarmCallbackFunc* m_callbackFunction;
-	AlarmCallbackArgs m_args;
 	Clock* m_attachedClock;
+	AlarmCallback m_callback;
 
-	double GerPercentRemaining(){ return m_currentTime / m_period; };
-	double GetSecondsRemaining(){ return m_period - m_currentTime; };
-	void FireCallbackFunction();
-	void AdvanceTime(double deltaSeconds);
+	double GerPercentRemaining(){ return m_period > 0.0 ? (m_period - GetSecondsRemaining()) / m_period : 1.0; };
+	double GetSecondsRemaining();
+	void FireCallbackFunction() { m_callback(*this); };
 };
 
 
+// Every clock lives in one table kept in depth first order , a clock's subtree is the range right after it.
+// The state touched every frame sits in parallel arrays , so advancing a hierarchy is one linear pass where
+// each child steps by its parent's scaled step : time scales multiply down the tree and pausing a clock stops
+// its whole subtree. Clocks are addressed by ClockHandle , the Clock object itself never moves and holds the
+// name and the alarms. Find only knows the clocks created with indexName , the first one with a name wins.
 class Clock
 {
 public:
-	Clock(const std::string& name = "root", Clock* parentClock = nullptr , float timeScale = 1.0f , double maxTimeStep = 1.0 );
-	~Clock(void);
-	double GetAbsoluteTimeSeconds();
-	double GetTime();
+	static ClockHandle Create(const std::string& name = "root", ClockHandle parent = ClockHandle(), float timeScale = 1.0f, double maxTimeStep = 1.0, bool indexName = true);
+	static void Destroy(ClockHandle handle, bool appendChildrenToParent = false);
+	static Clock* Get(ClockHandle handle);
+	static ClockHandle Find(const std::string& name);
+	static ClockHandle GetRootClock() { return s_rootClock; };
+	static size_t GetNumberOfClocks() { return s_clocks.size(); };
+	static void AdvanceAll(double deltaTime);
+	static MemoryResource* GetMemoryResource();
+	static double GetAbsoluteTimeSeconds();
+	static unsigned long long GetAbsoluteTimeTicks();
+
+	ClockHandle GetHandle() const { return m_handle; };
+	ClockHandle GetParent() const;
+	const std::string& GetName() const { return m_name; };
+	double GetTime() const { return s_times[m_denseIndex]; };
+	double GetLastTimeStep() const { return s_lastTimeSteps[m_denseIndex]; };
+	float GetTimeScale() const { return s_timeScales[m_denseIndex]; };
+	void SetTimeScale(float timeScale) { s_timeScales[m_denseIndex] = timeScale; };
+	double GetMaxTimeStep() const { return s_maxTimeSteps[m_denseIndex]; };
+	void SetMaxTimeStep(double maxTimeStep) { s_maxTimeSteps[m_denseIndex] = maxTimeStep; };
 	void AdvanceTime(double deltaTime);
-	void AppendChild(Clock* clock);
-	void RemoveChild(Clock* clock = nullptr);
+	void Pause() { s_paused[m_denseIndex] = 1; };
+	void UnPause() { s_paused[m_denseIndex] = 0; };
+	bool IsPaused() const { return s_paused[m_denseIndex] != 0; };
 	void AppendAlarm(Alarm* alarm);
-	void RemoveAlarm(const Alarm* _alarm);
-	static void RemoveClock(Clock* clock);
+	void RemoveAlarm(Alarm* alarm);
+	size_t GetNumberOfAlarms() const { return m_alarms.GetNumberOfNodes(); };
 	Alarm* FindAlarm(const std::string& name);
-	void Dispose(bool appendChildToParent = false);
-	void Pause();
-	void UnPause();
 
-public:
-	static std::map< std::string , Clock* > s_clockMap;
-	static Clock* s_rootClock;
-	static double s_secondsPerCount;
+private:
+	Clock(const std::string& name, ClockHandle handle, unsigned int denseIndex);
+	~Clock();
+	Clock(const Clock&);
+	void operator=(const Clock&);
+	void FireAlarms();
+	static void AdvanceRange(unsigned int begin, unsigned int end, double deltaTime);
+	static void UpdateDenseIndices(unsigned int begin);
 
 	std::string m_name;
-	std::vector<Clock*> m_childClocks;
-	std::vector<Alarm*> m_alarms;
-	Clock* m_parent;
-	float m_timeScale;
-	double m_lastTimeStep;
-	double m_maxDeltaTimeStep;
-	bool m_pause;
+	ClockHandle m_handle;
+	unsigned int m_denseIndex;
+	TimingWheel m_alarms;
+	Alarm* m_firingAlarm;
 
-private:
-	double m_currentTimeSeconds;
+	static ResourceVector<Clock*> s_clocks;
+	static ResourceVector<int> s_parents;				// dense index of the parent , -1 for a root
+	static ResourceVector<unsigned int> s_subtreeSizes;	// the clock included
+	static ResourceVector<float> s_timeScales;
+	static ResourceVector<double> s_maxTimeSteps;
+	static ResourceVector<unsigned char> s_paused;
+	static ResourceVector<double> s_times;
+	static ResourceVector<double> s_lastTimeSteps;
+	static ResourceVector<double> s_scaledTimeSteps;	// what the children step by
+	static ResourceVector<ClockSlot> s_slots;
+	static ResourceVector<unsigned int> s_freeSlots;
+	static ResourceVector<ClockHandle> s_alarmClocks;	// scratch for AdvanceRange
+	static ResourceVector<ClockPendingDestroy> s_pendingDestroys;
+	static unsigned int s_firingDepth;
+	static ClockNameIndex s_nameIndex;
+	static ClockHandle s_rootClock;
 };
 
 }
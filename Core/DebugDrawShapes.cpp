@@ -4,6 +4,13 @@
 namespace Henry
 {
 
+DEFINE_POOLED_ALLOCATION(DebugDrawPosition, 64)
+DEFINE_POOLED_ALLOCATION(DebugDrawLine, 64)
+DEFINE_POOLED_ALLOCATION(DebugDrawArrow, 64)
+DEFINE_POOLED_ALLOCATION(DebugDrawAABB, 64)
+DEFINE_POOLED_ALLOCATION(DebugDrawSphere, 64)
+
+
 void DebugDrawPosition::draw()
 {
 	Vertex_PosColor vertices[8];
@@ -4,6 +4,7 @@
 #define DEBUGDRAWSHAPES_HPP
 
 #include "VertexStruct.hpp"
+#include "Engine\Memory\ObjectPool.hpp"
 
 namespace Henry
 {
@@ -15,7 +16,7 @@ class DebugDrawShapes
 {
 public:
 	DebugDrawShapes(void) : m_durationSeconds(0.0f) , isDead(false){};
-	~DebugDrawShapes(void){};
+	virtual ~DebugDrawShapes(void){};
 	virtual void draw(){};
 	void update(double deltaSeconds) { m_durationSeconds -= deltaSeconds; if(m_durationSeconds <= 0.0f) isDead = true; };
 	bool isDead;
@@ -25,6 +26,8 @@ public:
 
 class DebugDrawPosition : public DebugDrawShapes
 {
+	DECLARE_POOLED_ALLOCATION(DebugDrawPosition)
+
 public:
 	DebugDrawPosition(Vec3f position,RGBA color,float radius,double duration = 0.0f) : m_position(position) , m_color(color) , m_radius(radius){ m_durationSeconds = duration; };
 	~DebugDrawPosition(){};
@@ -39,6 +42,8 @@ private:
 
 class DebugDrawLine : public DebugDrawShapes
 {
+	DECLARE_POOLED_ALLOCATION(DebugDrawLine)
+
 public:
 	DebugDrawLine(Vec3f startPos,Vec3f endPos,RGBA startColor,RGBA endColor,double duration = 0.0f) : m_startPos(startPos) , m_endPos(endPos) , m_startColor(startColor) , m_endColor(endColor) { m_durationSeconds = duration; };
 	~DebugDrawLine(){};
@@ -53,6 +58,8 @@ private:
 
 class DebugDrawArrow : public DebugDrawShapes
 {
+	DECLARE_POOLED_ALLOCATION(DebugDrawArrow)
+
 public:
 	DebugDrawArrow(Vec3f startPos,Vec3f endPos,RGBA startColor,RGBA endColor,double duration = 0.0f) : m_startPos(startPos) , m_endPos(endPos) , m_startColor(startColor) , m_endColor(endColor) { m_durationSeconds = duration; };
 	~DebugDrawArrow(){};
@@ -67,6 +74,8 @@ private:
 
 class DebugDrawAABB : public DebugDrawShapes
 {
+	DECLARE_POOLED_ALLOCATION(DebugDrawAABB)
+
 public:
 	DebugDrawAABB(Vec3f minPos, Vec3f maxPos, RGBA edgeColor, RGBA faceColor,double duration = 0.0f) : m_minPos(minPos) , m_maxPos(maxPos) , m_edgeColor(edgeColor) , m_faceColor(faceColor) { m_durationSeconds = duration; };
 	~DebugDrawAABB(){};
@@ -81,6 +90,8 @@ private:
 
 class DebugDrawSphere : public DebugDrawShapes
 {
+	DECLARE_POOLED_ALLOCATION(DebugDrawSphere)
+
 public:
 	DebugDrawSphere(Vec3f centerPos,RGBA color,float radius,double duration = 0.0f) : m_center(centerPos),m_color(color),m_radius(radius){ m_durationSeconds = duration; };
 	~DebugDrawSphere(){};
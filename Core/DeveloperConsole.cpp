@@ -1,5 +1,12 @@
 #include "Engine\Core\DeveloperConsole.hpp"
 #include "Engine\Renderer\OpenGLRenderer.hpp"
+#include "Engine\Memory\FrameArena.hpp"
+#include "Engine\Memory\MemoryAllocatePool.hpp"
+#include "Engine\Memory\MemoryResource.hpp"
+#include "Engine\Memory\AllocationTrace.hpp"
+#include "Engine\Core\Profiler.hpp"
+#include "Engine\Core\SamplingProfiler.hpp"
+#include "Engine\Core\Metrics.hpp"
 
 
 namespace Henry
@@ -30,6 +37,230 @@ static void Command_Clear()
 };
 
 
+static void Command_FrameArena()
+{
+	if(!_frameArena)
+	{
+		_console->DrawSentence("Frame arena is not created.",RGBA(1.0f,0.0f,0.0f,1.0f));
+		return;
+	}
+
+	char buffer[256];
+	sprintf_s(buffer, sizeof(buffer), "Last frame : %d allocations , %d heap fallbacks , %d bytes , high water %d / %d bytes",
+		(int)_frameArena->m_numberOfAllocationsLastFrame, (int)_frameArena->m_numberOfOverflowsLastFrame, (int)_frameArena->m_bytesAllocatedLastFrame,
+		(int)_frameArena->m_highWaterMark, (int)_frameArena->GetBytesPerFrame());
+	_console->DrawSentence(buffer,RGBA(1.0f,1.0f,1.0f,1.0f));
+};
+
+
+static void Command_MemorySnapshot(const CommandConsoleArgs& args)
+{
+	if(!_memoryAllocatePool)
+	{
+		_console->DrawSentence("Memory pool is not created.",RGBA(1.0f,0.0f,0.0f,1.0f));
+		return;
+	}
+
+	std::string path = args.m_argList.size() > 1 ? args.m_argList[1] : "memory_snapshot.json";
+	MemorySnapshotFormat format = MEMORY_SNAPSHOT_JSON;
+	if(args.m_argList.size() > 2 ? args.m_argList[2] == "csv" : path.find(".csv") != std::string::npos)
+		format = MEMORY_SNAPSHOT_CSV;
+
+	if(_memoryAllocatePool->WriteSnapshot(path.c_str(), format))
+		_console->DrawSentence(("Memory snapshot written to " + path).c_str(),RGBA(1.0f,1.0f,1.0f,1.0f));
+	else
+		_console->DrawSentence(("ERROR: Can't write " + path).c_str(),RGBA(1.0f,0.0f,0.0f,1.0f));
+};
+
+
+static void Command_MemoryResources()
+{
+	char buffer[256];
+	for(MemoryResource* resource = MemoryResource::GetFirstResource(); resource; resource = resource->GetNextResource())
+	{
+		sprintf_s(buffer, sizeof(buffer), "%s : %d live bytes , %d peak bytes , %d allocations",
+			resource->GetName(), (int)resource->GetLiveBytes(), (int)resource->GetPeakBytes(), (int)resource->GetTotalAllocations());
+		_console->DrawSentence(buffer,RGBA(1.0f,1.0f,1.0f,1.0f));
+	}
+};
+
+
+static void Command_AllocTrace(const CommandConsoleArgs& args)
+{
+	if(args.m_argList.size() > 1 && args.m_argList[1] == "stop")
+	{
+		char buffer[128];
+		sprintf_s(buffer, sizeof(buffer), "Allocation trace stopped , %d events recorded.", (int)AllocationTrace::GetNumberOfRecords());
+		AllocationTrace::Stop();
+		_console->DrawSentence(buffer,RGBA(1.0f,1.0f,1.0f,1.0f));
+		return;
+	}
+
+	if(args.m_argList.size() < 2 || args.m_argList[1] != "start")
+	{
+		_console->DrawSentence("ERROR: Wrong Arguments. Usage : <AllocTrace> <start|stop> <FilePath>",RGBA(1.0f,0.0f,0.0f,1.0f));
+		return;
+	}
+
+#if defined(HENRY_MEMORY_OVERRIDE_NEW)
+	std::string path = args.m_argList.size() > 2 ? args.m_argList[2] : "allocations.trace";
+	if(AllocationTrace::Start(path.c_str()))
+		_console->DrawSentence(("Recording allocations to " + path).c_str(),RGBA(1.0f,1.0f,1.0f,1.0f));
+	else
+		_console->DrawSentence(("ERROR: Can't record to " + path).c_str(),RGBA(1.0f,0.0f,0.0f,1.0f));
+#else
+	// nothing calls the recorder without the global new / delete hooks
+	_console->DrawSentence("ERROR: Allocation traces need a build with HENRY_MEMORY_OVERRIDE_NEW.",RGBA(1.0f,0.0f,0.0f,1.0f));
+#endif
+};
+
+
+static void Command_ProfileCapture(const CommandConsoleArgs& args)
+{
+	if(args.m_argList.size() > 1 && args.m_argList[1] == "stop")
+	{
+		char buffer[128];
+		sprintf_s(buffer, sizeof(buffer), "Profile capture stopped , %d events recorded.", (int)Profiler::GetNumberOfCapturedEvents());
+		if(Profiler::StopCapture())
+			_console->DrawSentence(buffer,RGBA(1.0f,1.0f,1.0f,1.0f));
+		else
+			_console->DrawSentence("ERROR: No profile capture written.",RGBA(1.0f,0.0f,0.0f,1.0f));
+		return;
+	}
+
+	int numberOfFrames = args.m_argList.size() > 1 ? atoi(args.m_argList[1].c_str()) : 300;
+	std::string path = args.m_argList.size() > 2 ? args.m_argList[2] : "profile.json";
+	int startAfterFrames = args.m_argList.size() > 3 ? atoi(args.m_argList[3].c_str()) : 0;
+	if(numberOfFrames < 0 || startAfterFrames < 0)
+	{
+		_console->DrawSentence("ERROR: Wrong Arguments. Usage : <ProfileCapture> <NumberOfFrames|stop> <FilePath> <StartAfterFrames>",RGBA(1.0f,0.0f,0.0f,1.0f));
+		return;
+	}
+
+	if(Profiler::StartCapture(path.c_str(), numberOfFrames, startAfterFrames))
+		_console->DrawSentence(("Capturing profile to " + path).c_str(),RGBA(1.0f,1.0f,1.0f,1.0f));
+	else
+		_console->DrawSentence("ERROR: A profile capture is already running.",RGBA(1.0f,0.0f,0.0f,1.0f));
+};
+
+
+static void Command_HitchDetector(const CommandConsoleArgs& args)
+{
+	if(args.m_argList.size() > 1 && args.m_argList[1] == "off")
+	{
+		Profiler::DisableHitchDetector();
+		_console->DrawSentence("Hitch detector off.",RGBA(1.0f,1.0f,1.0f,1.0f));
+		return;
+	}
+
+	double budgetMilliseconds = args.m_argList.size() > 1 ? atof(args.m_argList[1].c_str()) : 33.3;
+	int numberOfFrames = args.m_argList.size() > 2 ? atoi(args.m_argList[2].c_str()) : (int)PROFILE_HITCH_DEFAULT_FRAMES;
+	std::string prefix = args.m_argList.size() > 3 ? args.m_argList[3] : "hitch";
+	if(budgetMilliseconds <= 0.0 || numberOfFrames <= 0 || !Profiler::EnableHitchDetector(prefix.c_str(), numberOfFrames))
+	{
+		_console->DrawSentence("ERROR: Wrong Arguments. Usage : <HitchDetector> <BudgetMilliseconds|off> <NumberOfFrames> <FilePrefix>",RGBA(1.0f,0.0f,0.0f,1.0f));
+		return;
+	}
+
+	Profiler::SetFrameBudget(budgetMilliseconds * 0.001);
+	char buffer[384];
+	sprintf_s(buffer, sizeof(buffer), "Frames over %.2f ms write the last %d frames to %s_<frame>.json , %u written so far.", budgetMilliseconds, numberOfFrames, prefix.c_str(), Profiler::GetNumberOfHitches());
+	_console->DrawSentence(buffer,RGBA(1.0f,1.0f,1.0f,1.0f));
+};
+
+
+static void Command_ProfileCounters(const CommandConsoleArgs& args)
+{
+	bool enable = !(args.m_argList.size() > 1 && args.m_argList[1] == "off");
+	if(Profiler::EnableHardwareCounters(enable) == enable)
+		_console->DrawSentence(enable ? "Hardware counters on." : "Hardware counters off.",RGBA(1.0f,1.0f,1.0f,1.0f));
+	else
+		_console->DrawSentence("ERROR: Hardware counters are not available on this system.",RGBA(1.0f,0.0f,0.0f,1.0f));
+};
+
+
+static void Command_ProfileAllocations(const CommandConsoleArgs& args)
+{
+	bool enable = !(args.m_argList.size() > 1 && args.m_argList[1] == "off");
+	if(Profiler::EnableAllocationTracking(enable) == enable)
+		_console->DrawSentence(enable ? "Allocation tracking on." : "Allocation tracking off.",RGBA(1.0f,1.0f,1.0f,1.0f));
+	else
+		_console->DrawSentence("ERROR: Allocation tracking needs a build with HENRY_MEMORY_OVERRIDE_NEW.",RGBA(1.0f,0.0f,0.0f,1.0f));
+};
+
+
+static void Command_SampleProfile(const CommandConsoleArgs& args)
+{
+	if(args.m_argList.size() > 1 && args.m_argList[1] == "stop")
+	{
+		std::string path = args.m_argList.size() > 2 ? args.m_argList[2] : "samples.folded";
+		SamplingProfiler::Stop();
+		char buffer[256];
+		sprintf_s(buffer, sizeof(buffer), "%d samples , %d dropped , written to %s", (int)SamplingProfiler::GetNumberOfSamples(), (int)SamplingProfiler::GetNumberOfDroppedSamples(), path.c_str());
+		if(SamplingProfiler::WriteFoldedStacks(path.c_str()))
+			_console->DrawSentence(buffer,RGBA(1.0f,1.0f,1.0f,1.0f));
+		else
+			_console->DrawSentence(("ERROR: Can't write " + path).c_str(),RGBA(1.0f,0.0f,0.0f,1.0f));
+		return;
+	}
+
+	if(args.m_argList.size() < 2 || args.m_argList[1] != "start")
+	{
+		_console->DrawSentence("ERROR: Wrong Arguments. Usage : <SampleProfile> <start|stop> <Frequency|FilePath>",RGBA(1.0f,0.0f,0.0f,1.0f));
+		return;
+	}
+
+	int frequency = args.m_argList.size() > 2 ? atoi(args.m_argList[2].c_str()) : (int)SAMPLING_DEFAULT_FREQUENCY;
+	if(frequency > 0 && SamplingProfiler::Start(frequency))
+		_console->DrawSentence("Sampling profiler started.",RGBA(1.0f,1.0f,1.0f,1.0f));
+	else
+		_console->DrawSentence("ERROR: Can't start the sampling profiler.",RGBA(1.0f,0.0f,0.0f,1.0f));
+};
+
+
+static void Command_Metrics(const CommandConsoleArgs& args)
+{
+	if(args.m_argList.size() > 1 && args.m_argList[1] == "dump")
+	{
+		std::string path = args.m_argList.size() > 2 ? args.m_argList[2] : "metrics.json";
+		if(Metrics::WriteSnapshot(path.c_str()))
+			_console->DrawSentence(("Metrics appended to " + path).c_str(),RGBA(1.0f,1.0f,1.0f,1.0f));
+		else
+			_console->DrawSentence(("ERROR: Can't write " + path).c_str(),RGBA(1.0f,0.0f,0.0f,1.0f));
+		return;
+	}
+
+	if(args.m_argList.size() > 1 && args.m_argList[1] == "every")
+	{
+		int numberOfFrames = args.m_argList.size() > 2 ? atoi(args.m_argList[2].c_str()) : 0;
+		std::string path = args.m_argList.size() > 3 ? args.m_argList[3] : "metrics.json";
+		Metrics::SetDumpPeriod(path.c_str(), numberOfFrames > 0 ? numberOfFrames : 0);
+		_console->DrawSentence(numberOfFrames > 0 ? ("Dumping metrics to " + path).c_str() : "Periodic metrics dump stopped.",RGBA(1.0f,1.0f,1.0f,1.0f));
+		return;
+	}
+
+	if(args.m_argList.size() > 1)
+	{
+		_console->DrawSentence("ERROR: Wrong Arguments. Usage : <Metrics> <dump|every> <FilePath|NumberOfFrames> <FilePath>",RGBA(1.0f,0.0f,0.0f,1.0f));
+		return;
+	}
+
+	char buffer[256];
+	for(size_t metricId = 1; metricId < Metrics::GetNumberOfMetrics(); ++metricId)
+	{
+		const MetricDescriptor& metric = Metrics::GetMetric((unsigned int)metricId);
+		const MetricSnapshot& snapshot = Metrics::GetSnapshot((unsigned int)metricId);
+		if(metric.m_type == METRIC_HISTOGRAM)
+			sprintf_s(buffer, sizeof(buffer), "%s : %lld samples , mean %.1f , p50 %llu , p99 %llu , max %llu", metric.m_name, snapshot.m_value, snapshot.m_mean, snapshot.m_p50, snapshot.m_p99, snapshot.m_max);
+		else if(metric.m_type == METRIC_COUNTER)
+			sprintf_s(buffer, sizeof(buffer), "%s : %lld (+%lld this frame)", metric.m_name, snapshot.m_value, snapshot.m_deltaThisFrame);
+		else
+			sprintf_s(buffer, sizeof(buffer), "%s : %lld", metric.m_name, snapshot.m_value);
+		_console->DrawSentence(buffer,RGBA(1.0f,1.0f,1.0f,1.0f));
+	}
+};
+
+
 static void Command_Quit()
 {
 	//_isQuitting = true;
@@ -78,6 +309,36 @@ DeveloperConsole::DeveloperConsole(void)
 	
 	RegisteredCommand* clear = new RegisteredCommand("clear","Clear => Clear the console log.",Command_Clear);
 	m_registeredCmds["clear"] = clear;
+
+	RegisteredCommand* frameArena = new RegisteredCommand("frameArena","FrameArena => Show per frame transient allocations served without touching the heap.",Command_FrameArena);
+	m_registeredCmds["framearena"] = frameArena;
+
+	RegisteredCommand* memorySnapshot = new RegisteredCommand("memorySnapshot","MemorySnapshot => Dump allocation telemetry. Usage : <MemorySnapshot> <FilePath> <json|csv>",Command_MemorySnapshot);
+	m_registeredCmds["memorysnapshot"] = memorySnapshot;
+
+	RegisteredCommand* memoryResources = new RegisteredCommand("memoryResources","MemoryResources => Show bytes held by each container memory resource.",Command_MemoryResources);
+	m_registeredCmds["memoryresources"] = memoryResources;
+
+	RegisteredCommand* allocTrace = new RegisteredCommand("allocTrace","AllocTrace => Record global new/delete to a binary trace for the AllocationReplay benchmark. Usage : <AllocTrace> <start|stop> <FilePath>",Command_AllocTrace);
+	m_registeredCmds["alloctrace"] = allocTrace;
+
+	RegisteredCommand* profileCapture = new RegisteredCommand("profileCapture","ProfileCapture => Record profiler events to Chrome trace JSON , 0 frames records until stop. Usage : <ProfileCapture> <NumberOfFrames|stop> <FilePath> <StartAfterFrames>",Command_ProfileCapture);
+	m_registeredCmds["profilecapture"] = profileCapture;
+
+	RegisteredCommand* hitchDetector = new RegisteredCommand("hitchDetector","HitchDetector => Keep the last frames of profiler events and write them as Chrome trace JSON when a frame goes over budget. Usage : <HitchDetector> <BudgetMilliseconds|off> <NumberOfFrames> <FilePrefix>",Command_HitchDetector);
+	m_registeredCmds["hitchdetector"] = hitchDetector;
+
+	RegisteredCommand* profileCounters = new RegisteredCommand("profileCounters","ProfileCounters => Attach cycles , instructions , cache and branch misses to profiled scopes. Usage : <ProfileCounters> <on|off>",Command_ProfileCounters);
+	m_registeredCmds["profilecounters"] = profileCounters;
+
+	RegisteredCommand* profileAllocations = new RegisteredCommand("profileAllocations","ProfileAllocations => Count heap allocations and bytes in the profiled scope that made them. Usage : <ProfileAllocations> <on|off>",Command_ProfileAllocations);
+	m_registeredCmds["profileallocations"] = profileAllocations;
+
+	RegisteredCommand* sampleProfile = new RegisteredCommand("sampleProfile","SampleProfile => Sample call stacks of registered threads and write folded stacks for flame graphs. Usage : <SampleProfile> <start|stop> <Frequency|FilePath>",Command_SampleProfile);
+	m_registeredCmds["sampleprofile"] = sampleProfile;
+
+	RegisteredCommand* metrics = new RegisteredCommand("metrics","Metrics => Show the engine counters , gauges and histograms of the last frame , or write them as json lines. Usage : <Metrics> <dump|every> <FilePath|NumberOfFrames> <FilePath>",Command_Metrics);
+	m_registeredCmds["metrics"] = metrics;
 }
 
 
@@ -148,11 +409,11 @@ void DeveloperConsole::DrawSentence(const char* sentence , int lineNum , float f
 	if(font == nullptr)
 		font = m_defaultFont;
 
-	std::vector<Vertex_PCT> vertices;
+	FrameVector<Vertex_PCT> vertices;
 	size_t length = strlen(sentence);
 	vertices.reserve(length * 4);
 	float width = 0;
-	std::map<int,GlyphMetaData>::iterator it;
+	GlyphMap::iterator it;
 	for(size_t index = 0; index < length; index++)
 	{
 		it = font->m_glyphData.find(sentence[index]);
@@ -188,8 +449,11 @@ void DeveloperConsole::DrawSentence(const char* sentence , int lineNum , float f
 		m_widthTable.push_back(width);
 	}
 
+	if(vertices.empty())
+		return;
+
 	OpenGLRenderer::BindTexture(font->m_glyphSheet->m_textureID);
-	OpenGLRenderer::DrawVertexWithVertexArray2D(vertices,OpenGLRenderer::SHAPE_QUADS,m_screenSizes.x,m_screenSizes.y);
+	OpenGLRenderer::DrawVertexWithVertexArray2D(&vertices[0],(int)vertices.size(),OpenGLRenderer::SHAPE_QUADS,m_screenSizes.x,m_screenSizes.y);
 }
 
 
@@ -198,7 +462,7 @@ bool DeveloperConsole::PassCharToLog(char word)
 	if(word == '`')
 		return false;
 
-	std::map<int,GlyphMetaData>::iterator it;
+	GlyphMap::iterator it;
 	it =  m_defaultFont->m_glyphData.find( word );
 	if(it == m_defaultFont->m_glyphData.end())
 		return true;
@@ -0,0 +1,93 @@
+#include "FixedStepDriver.hpp"
+
+#include "Engine\Core\Timebase.hpp"
+
+#include <string.h>
+
+
+namespace Henry
+{
+
+FixedStepDriver::FixedStepDriver(ClockHandle sourceClock, double stepSeconds, unsigned int maxSubsteps)
+	: m_sourceClock(sourceClock)
+{
+	SetStepSeconds(stepSeconds);
+	SetMaxSubsteps(maxSubsteps);
+	Reset();
+}
+
+
+// Forgets the time piled up and the statistics , e.g. after a load.
+void FixedStepDriver::Reset()
+{
+	m_lastSourceTime = ReadSourceTime(m_lastReadFromClock);
+	m_accumulatedSeconds = 0.0;
+	m_simulationTime = 0.0;
+	m_numberOfSteps = 0;
+	m_substepsLastFrame = 0;
+	m_numberOfDroppedSteps = 0;
+	memset(m_stageTimings, 0, sizeof(m_stageTimings));
+}
+
+
+double FixedStepDriver::ReadSourceTime(bool& out_fromClock) const
+{
+	Clock* clock = Clock::Get(m_sourceClock);
+	out_fromClock = clock != nullptr;
+	return clock ? clock->GetTime() : Clock::GetAbsoluteTimeSeconds();
+}
+
+
+void FixedStepDriver::RunFrame(FixedStepSimulation& simulation)
+{
+	bool fromClock = false;
+	double sourceTime = ReadSourceTime(fromClock);
+	double frameSeconds = sourceTime - m_lastSourceTime;
+	m_lastSourceTime = sourceTime;
+
+	// the handle went stale , the two readings are on different time lines so this frame adds nothing
+	if (fromClock != m_lastReadFromClock)
+	{
+		m_lastReadFromClock = fromClock;
+		frameSeconds = 0.0;
+	}
+	if (frameSeconds > 0.0)
+		m_accumulatedSeconds += frameSeconds;
+
+	unsigned long long startTicks = Timebase::GetTicks();
+	m_substepsLastFrame = 0;
+	while (m_accumulatedSeconds >= m_stepSeconds - FIXED_STEP_TOLERANCE_SECONDS && m_substepsLastFrame < m_maxSubsteps)
+	{
+		simulation.Simulate(m_stepSeconds);
+		m_accumulatedSeconds -= m_stepSeconds;
+		m_simulationTime += m_stepSeconds;
+		++m_substepsLastFrame;
+	}
+	m_numberOfSteps += m_substepsLastFrame;
+
+	// over budget , drop the whole steps still owed and keep the fraction so the alpha stays smooth
+	if (m_accumulatedSeconds >= m_stepSeconds - FIXED_STEP_TOLERANCE_SECONDS)
+	{
+		unsigned long long droppedSteps = (unsigned long long)((m_accumulatedSeconds + FIXED_STEP_TOLERANCE_SECONDS) / m_stepSeconds);
+		m_accumulatedSeconds -= droppedSteps * m_stepSeconds;
+		m_numberOfDroppedSteps += droppedSteps;
+	}
+
+	unsigned long long renderTicks = Timebase::GetTicks();
+	RecordStage(FIXED_STEP_STAGE_SIMULATE, renderTicks - startTicks);
+
+	simulation.Render(GetAlpha());
+	RecordStage(FIXED_STEP_STAGE_RENDER, Timebase::GetTicks() - renderTicks);
+}
+
+
+void FixedStepDriver::RecordStage(FixedStepStage stage, unsigned long long ticks)
+{
+	FixedStepStageTiming& timing = m_stageTimings[stage];
+	timing.m_lastSeconds = Timebase::TicksToSeconds(ticks);
+	timing.m_averageSeconds += (timing.m_lastSeconds - timing.m_averageSeconds) * FIXED_STEP_TIMING_SMOOTHING;
+	if (timing.m_lastSeconds > timing.m_maxSeconds)
+		timing.m_maxSeconds = timing.m_lastSeconds;
+}
+
+};
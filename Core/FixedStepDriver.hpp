@@ -0,0 +1,84 @@
+#pragma once
+
+#ifndef FIXEDSTEPDRIVER_HPP
+#define FIXEDSTEPDRIVER_HPP
+
+#include "Engine\Core\Clock.hpp"
+
+namespace Henry
+{
+
+const double FIXED_STEP_DEFAULT_SECONDS = 1.0 / 60.0;
+const unsigned int FIXED_STEP_DEFAULT_MAX_SUBSTEPS = 4;
+const double FIXED_STEP_TIMING_SMOOTHING = 0.05;
+const double FIXED_STEP_TOLERANCE_SECONDS = 0.000000001;	// rounding left by summing frame times
+
+enum FixedStepStage { FIXED_STEP_STAGE_SIMULATE = 0 , FIXED_STEP_STAGE_RENDER , FIXED_STEP_STAGES };
+
+struct FixedStepStageTiming
+{
+	double m_lastSeconds;		// every substep of the last frame together for the simulate stage
+	double m_averageSeconds;	// exponential average , FIXED_STEP_TIMING_SMOOTHING per frame
+	double m_maxSeconds;
+};
+
+// What the driver runs. Render is left empty on a dedicated server.
+class FixedStepSimulation
+{
+public:
+	virtual ~FixedStepSimulation() {};
+	virtual void Simulate(double stepSeconds) = 0;
+	virtual void Render(double alpha) { (void)alpha; };
+};
+
+
+// Runs the simulation at a fixed step and the rendering once per frame , whatever the frame rate is.
+// The frame time comes from a clock , so its scale , pause and max step apply , or from the wall clock
+// when the handle is invalid. A source clock destroyed under the driver hands over to the wall clock
+// without a frame of its own. Time the simulation is behind piles up and is paid back in whole steps ,
+// at most maxSubsteps per frame , the rest is dropped so a simulation slower than real time can't take
+// ever more steps each frame. Render gets how far the leftover time is into the next step , to blend the
+// last two simulated states with :
+//		FixedStepDriver driver(Clock::Find("game"), 1.0 / 30.0);
+//		driver.RunFrame(world);			// after the clocks were advanced
+class FixedStepDriver
+{
+public:
+	FixedStepDriver(ClockHandle sourceClock = ClockHandle(), double stepSeconds = FIXED_STEP_DEFAULT_SECONDS, unsigned int maxSubsteps = FIXED_STEP_DEFAULT_MAX_SUBSTEPS);
+	void RunFrame(FixedStepSimulation& simulation);
+	void Reset();
+
+	void SetStepSeconds(double stepSeconds) { m_stepSeconds = stepSeconds > 0.0 ? stepSeconds : FIXED_STEP_DEFAULT_SECONDS; };
+	double GetStepSeconds() const { return m_stepSeconds; };
+	void SetMaxSubsteps(unsigned int maxSubsteps) { m_maxSubsteps = maxSubsteps != 0 ? maxSubsteps : 1; };
+	unsigned int GetMaxSubsteps() const { return m_maxSubsteps; };
+
+	double GetAlpha() const { return m_accumulatedSeconds > 0.0 ? m_accumulatedSeconds / m_stepSeconds : 0.0; };
+	double GetSimulationTime() const { return m_simulationTime; };
+	// time of the state Render shows , alpha of the way from the previous step to the current one
+	double GetInterpolatedTime() const { return m_simulationTime - (1.0 - GetAlpha()) * m_stepSeconds; };
+	unsigned long long GetNumberOfSteps() const { return m_numberOfSteps; };
+	unsigned int GetSubstepsLastFrame() const { return m_substepsLastFrame; };
+	unsigned long long GetNumberOfDroppedSteps() const { return m_numberOfDroppedSteps; };
+	const FixedStepStageTiming& GetStageTiming(FixedStepStage stage) const { return m_stageTimings[stage]; };
+
+private:
+	double ReadSourceTime(bool& out_fromClock) const;
+	void RecordStage(FixedStepStage stage, unsigned long long ticks);
+
+	ClockHandle m_sourceClock;
+	double m_stepSeconds;
+	unsigned int m_maxSubsteps;
+	double m_lastSourceTime;
+	bool m_lastReadFromClock;
+	double m_accumulatedSeconds;
+	double m_simulationTime;
+	unsigned long long m_numberOfSteps;
+	unsigned int m_substepsLastFrame;
+	unsigned long long m_numberOfDroppedSteps;
+	FixedStepStageTiming m_stageTimings[FIXED_STEP_STAGES];
+};
+
+};
+
+#endif
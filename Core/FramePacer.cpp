@@ -0,0 +1,194 @@
+#include "FramePacer.hpp"
+
+#include "Engine\Core\Timebase.hpp"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#else
+#include <errno.h>
+#include <time.h>
+#endif
+
+
+namespace Henry
+{
+
+static inline void SpinPause()
+{
+#if defined(_MSC_VER)
+	YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+
+FramePacer::FramePacer(double framesPerSecond)
+	: m_framesPerSecond(0.0)
+	, m_periodTicks(0)
+	, m_nextFrameTicks(0)
+	, m_spinSeconds(FRAME_PACER_DEFAULT_SPIN_SECONDS)
+	, m_meanOversleepSeconds(0.0)
+	, m_oversleepDeviationSeconds(0.0)
+	, m_timer(nullptr)
+	, m_raisedTimerResolution(false)
+{
+#if defined(_WIN32)
+	// the high resolution timer needs Windows 10 1803 , older ones get the regular timer , which like Sleep
+	// wakes on the 15.6 ms system tick unless the tick is raised to 1 ms while the pacer lives
+	m_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (!m_timer)
+	{
+		m_timer = CreateWaitableTimerW(nullptr, TRUE, nullptr);
+		m_raisedTimerResolution = timeBeginPeriod(1) == TIMERR_NOERROR;
+	}
+#endif
+	SetFrameRate(framesPerSecond);
+	ResetStats();
+}
+
+
+FramePacer::~FramePacer()
+{
+#if defined(_WIN32)
+	if (m_timer)
+		CloseHandle(m_timer);
+	if (m_raisedTimerResolution)
+		timeEndPeriod(1);
+#endif
+}
+
+
+void FramePacer::SetFrameRate(double framesPerSecond)
+{
+	m_framesPerSecond = framesPerSecond > 0.0 ? framesPerSecond : 0.0;
+	m_periodTicks = m_framesPerSecond > 0.0 ? Timebase::SecondsToTicks(1.0 / m_framesPerSecond) : 0;
+	m_nextFrameTicks = 0;
+}
+
+
+void FramePacer::ResetStats()
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+
+double FramePacer::GetErrorStandardDeviation() const
+{
+	return sqrt(m_stats.m_errorVariance);
+}
+
+
+void FramePacer::WaitForNextFrame()
+{
+	if (m_periodTicks == 0)
+		return;
+
+	unsigned long long nowTicks = Timebase::GetTicks();
+	if (m_nextFrameTicks == 0)
+	{
+		m_nextFrameTicks = nowTicks + m_periodTicks;
+	}
+	else if (nowTicks >= m_nextFrameTicks)
+	{
+		// the frame itself ran over , start right away and only drop the schedule when a whole period late
+		++m_stats.m_numberOfFrames;
+		++m_stats.m_numberOfMissedFrames;
+		m_nextFrameTicks = nowTicks - m_nextFrameTicks >= m_periodTicks ? nowTicks + m_periodTicks : m_nextFrameTicks + m_periodTicks;
+		return;
+	}
+
+	double sleepSeconds = Timebase::TicksToSeconds(m_nextFrameTicks - nowTicks) - m_spinSeconds;
+	if (sleepSeconds > 0.0)
+	{
+		SleepFor(sleepSeconds);
+		unsigned long long wakeTicks = Timebase::GetTicks();
+		double sleptSeconds = Timebase::TicksToSeconds(wakeTicks - nowTicks);
+		m_stats.m_sleptSeconds += sleptSeconds;
+		RecordOversleep(sleptSeconds - sleepSeconds);
+		nowTicks = wakeTicks;
+	}
+
+	unsigned long long spinStartTicks = nowTicks;
+	while (nowTicks < m_nextFrameTicks)
+	{
+		SpinPause();
+		nowTicks = Timebase::GetTicks();
+	}
+	m_stats.m_spunSeconds += Timebase::TicksToSeconds(nowTicks - spinStartTicks);
+
+	RecordError(Timebase::TicksToSeconds(nowTicks - m_nextFrameTicks));
+	m_nextFrameTicks += m_periodTicks;
+}
+
+
+void FramePacer::SleepFor(double seconds)
+{
+#if defined(_WIN32)
+	if (m_timer)
+	{
+		// relative due time in 100 ns units , an absolute one would follow the wall clock
+		LARGE_INTEGER dueTime;
+		dueTime.QuadPart = -(LONGLONG)(seconds * 10000000.0);
+		if (dueTime.QuadPart < 0 && SetWaitableTimer(m_timer, &dueTime, 0, nullptr, nullptr, FALSE))
+		{
+			WaitForSingleObject(m_timer, INFINITE);
+			return;
+		}
+	}
+	Sleep((DWORD)(seconds * 1000.0));
+#else
+	struct timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	long long nanoseconds = (long long)deadline.tv_nsec + (long long)(seconds * 1000000000.0);
+	deadline.tv_sec += (time_t)(nanoseconds / 1000000000);
+	deadline.tv_nsec = (long)(nanoseconds % 1000000000);
+
+	// an absolute deadline , so a signal that wakes us doesn't push it back
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+	{
+	}
+#endif
+}
+
+
+// Late wake ups raise the spin at once , it only comes back down as the averages do.
+void FramePacer::RecordOversleep(double oversleepSeconds)
+{
+	m_meanOversleepSeconds += (oversleepSeconds - m_meanOversleepSeconds) * FRAME_PACER_OVERSLEEP_SMOOTHING;
+	m_oversleepDeviationSeconds += (fabs(oversleepSeconds - m_meanOversleepSeconds) - m_oversleepDeviationSeconds) * FRAME_PACER_OVERSLEEP_SMOOTHING;
+
+	double spinSeconds = m_meanOversleepSeconds + m_oversleepDeviationSeconds * FRAME_PACER_OVERSLEEP_DEVIATIONS;
+	if (oversleepSeconds > spinSeconds)
+		spinSeconds = oversleepSeconds;
+	if (spinSeconds < FRAME_PACER_MIN_SPIN_SECONDS)
+		spinSeconds = FRAME_PACER_MIN_SPIN_SECONDS;
+	if (spinSeconds > FRAME_PACER_MAX_SPIN_SECONDS)
+		spinSeconds = FRAME_PACER_MAX_SPIN_SECONDS;
+	m_spinSeconds = spinSeconds;
+}
+
+
+// Running mean and variance , Welford's update.
+void FramePacer::RecordError(double errorSeconds)
+{
+	++m_stats.m_numberOfFrames;
+	unsigned long long numberOfSamples = m_stats.m_numberOfFrames - m_stats.m_numberOfMissedFrames;
+	double previousMean = m_stats.m_meanErrorSeconds;
+	m_stats.m_meanErrorSeconds += (errorSeconds - previousMean) / numberOfSamples;
+	double sumOfSquares = m_stats.m_errorVariance * (numberOfSamples - 1) + (errorSeconds - previousMean) * (errorSeconds - m_stats.m_meanErrorSeconds);
+	m_stats.m_errorVariance = sumOfSquares / numberOfSamples;
+	if (errorSeconds > m_stats.m_maxErrorSeconds)
+		m_stats.m_maxErrorSeconds = errorSeconds;
+}
+
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#ifndef FRAMEPACER_HPP
+#define FRAMEPACER_HPP
+
+namespace Henry
+{
+
+const double FRAME_PACER_DEFAULT_RATE = 60.0;
+const double FRAME_PACER_DEFAULT_SPIN_SECONDS = 0.0005;
+const double FRAME_PACER_MIN_SPIN_SECONDS = 0.0001;
+const double FRAME_PACER_MAX_SPIN_SECONDS = 0.004;
+const double FRAME_PACER_OVERSLEEP_SMOOTHING = 0.05;
+const double FRAME_PACER_OVERSLEEP_DEVIATIONS = 4.0;	// spin this many mean deviations past the mean oversleep
+
+// Pacing error is how late a frame started against its deadline , frames the caller itself ran past
+// the deadline with count as missed and are left out of the error.
+struct FramePacerStats
+{
+	unsigned long long m_numberOfFrames;
+	unsigned long long m_numberOfMissedFrames;
+	double m_meanErrorSeconds;
+	double m_errorVariance;
+	double m_maxErrorSeconds;
+	double m_sleptSeconds;
+	double m_spunSeconds;
+};
+
+
+// Holds the caller to a fixed frame rate without burning the core. Most of the slack is slept away ,
+// clock_nanosleep on an absolute CLOCK_MONOTONIC deadline or a high resolution waitable timer on
+// Windows , and only the last GetSpinSeconds are spun on the Timebase. The spin follows how late the
+// sleeps come back , the mean oversleep plus a few mean deviations. Deadlines are a whole number of
+// periods apart so the rate doesn't drift , a frame late by more than a period starts a new schedule :
+//		FramePacer pacer(60.0);
+//		while (running) { RunFrame(); pacer.WaitForNextFrame(); }
+class FramePacer
+{
+public:
+	FramePacer(double framesPerSecond = FRAME_PACER_DEFAULT_RATE);
+	~FramePacer();
+	void WaitForNextFrame();
+	void SetFrameRate(double framesPerSecond);
+	double GetFrameRate() const { return m_framesPerSecond; };
+	double GetSpinSeconds() const { return m_spinSeconds; };
+	double GetMeanOversleepSeconds() const { return m_meanOversleepSeconds; };
+	const FramePacerStats& GetStats() const { return m_stats; };
+	double GetErrorStandardDeviation() const;
+	void ResetStats();
+
+private:
+	FramePacer(const FramePacer&);
+	void operator=(const FramePacer&);
+	void SleepFor(double seconds);
+	void RecordOversleep(double oversleepSeconds);
+	void RecordError(double errorSeconds);
+
+	double m_framesPerSecond;				// 0 , nothing is paced
+	unsigned long long m_periodTicks;
+	unsigned long long m_nextFrameTicks;	// 0 , no schedule yet
+	double m_spinSeconds;
+	double m_meanOversleepSeconds;
+	double m_oversleepDeviationSeconds;
+	FramePacerStats m_stats;
+	void* m_timer;
+	bool m_raisedTimerResolution;			// timeBeginPeriod(1) is held for the regular timer
+};
+
+};
+
+#endif
@@ -1,6 +1,10 @@
 #include "Engine/Core/HenryFunctions.hpp"
 
+#if defined(_WIN32)
 #include <Windows.h>
+#endif
+#include <stdarg.h>
+#include <stdio.h>
 #include <iostream>
 
 namespace Henry
@@ -62,7 +66,7 @@ bool ComputeSurfaceTangentsAtVertex(	Vec3f& surfaceTangentAtVertex_out,
 
 void circleTable(double **sint,double **cost,const int n)
 {
-	float M_PI = 3.1415926f;
+	float pi = 3.1415926f;
 	int i;
 
 	/* Table size, the sign of n flips the circle direction */
@@ -71,7 +75,7 @@ void circleTable(double **sint,double **cost,const int n)
 
 	/* Determine the angle between samples */
 
-	const double angle = 2*M_PI/(double)n;
+	const double angle = 2*pi/(double)n;
 
 	/* Allocate memory for n samples, plus duplicate of first entry at the end */
 
@@ -109,7 +113,11 @@ void DebuggerPrintf( const char* messageFormat, ... )
 		char messageLiteral[ MESSAGE_MAX_LENGTH ];
 		va_list variableArgumentList;
 		va_start( variableArgumentList, messageFormat );
+#if defined(_MSC_VER)
 		vsnprintf_s( messageLiteral, MESSAGE_MAX_LENGTH, _TRUNCATE, messageFormat, variableArgumentList );
+#else
+		vsnprintf( messageLiteral, MESSAGE_MAX_LENGTH, messageFormat, variableArgumentList );
+#endif
 		va_end( variableArgumentList );
 		messageLiteral[ MESSAGE_MAX_LENGTH - 1 ] = '\0'; // In case vsnprintf overran (doesn't auto-terminate)
 
@@ -119,7 +127,9 @@ void DebuggerPrintf( const char* messageFormat, ... )
 // 			OutputDebugStringA( messageLiteral );
 // 		}
 // #endif
+#if defined(_WIN32)
 		OutputDebugStringA(messageLiteral);
+#endif
 		std::cout << messageLiteral;
 	}
 }
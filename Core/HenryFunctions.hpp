@@ -44,7 +44,7 @@ void DebuggerPrintf( const char* messageFormat, ... );
 template <class T>
 void deleteVectorOfPointer(std::vector<T*>& pointerVector)
 {
-	std::vector<T*>::iterator iter = pointerVector.begin();
+	typename std::vector<T*>::iterator iter = pointerVector.begin();
 	while(iter != pointerVector.end())
 	{
 		T* temp = *iter;
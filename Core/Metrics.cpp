@@ -0,0 +1,244 @@
+#include "Metrics.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <mutex>
+
+
+namespace Henry
+{
+
+MetricDescriptor Metrics::s_metrics[METRICS_MAX];
+std::atomic<size_t> Metrics::s_numberOfMetrics(0);
+std::atomic<unsigned int> Metrics::s_numberOfHistograms(0);
+MetricShard Metrics::s_shards[METRICS_SHARDS];
+std::atomic<long long> Metrics::s_gaugeValues[METRICS_MAX];
+std::atomic<unsigned int> Metrics::s_nextShard(0);
+thread_local int Metrics::s_threadShard = -1;
+MetricSnapshot Metrics::s_snapshots[METRICS_MAX];
+unsigned long long Metrics::s_frameNumber = 0;
+unsigned int Metrics::s_dumpPeriod = 0;
+char Metrics::s_dumpPath[260];
+
+
+static std::mutex& GetMetricLock()
+{
+	static std::mutex s_lock;
+	return s_lock;
+}
+
+
+// Metric 0 and histogram 0 soak up everything registered once the tables are full.
+unsigned int Metrics::Register(const char* name, MetricType type, MetricSampleFunction* sampleFunction)
+{
+	std::lock_guard<std::mutex> guard(GetMetricLock());
+	size_t numberOfMetrics = s_numberOfMetrics.load(std::memory_order_relaxed);
+	if (numberOfMetrics == 0)
+	{
+		s_metrics[0].m_name = "metrics.overflow";
+		s_metrics[0].m_type = METRIC_COUNTER;
+		s_metrics[0].m_histogramIndex = 0;
+		s_metrics[0].m_sampleFunction = nullptr;
+		s_numberOfHistograms.store(1, std::memory_order_relaxed);
+		numberOfMetrics = 1;
+	}
+
+	for (size_t index = 0; index < numberOfMetrics; ++index)
+	{
+		if (strcmp(s_metrics[index].m_name, name) == 0)
+			return (unsigned int)index;
+	}
+
+	unsigned int histogramIndex = 0;
+	if (type == METRIC_HISTOGRAM)
+	{
+		histogramIndex = s_numberOfHistograms.load(std::memory_order_relaxed);
+		if (histogramIndex >= METRICS_MAX_HISTOGRAMS)
+			return 0;
+		s_numberOfHistograms.store(histogramIndex + 1, std::memory_order_relaxed);
+	}
+
+	if (numberOfMetrics >= METRICS_MAX)
+		return 0;
+
+	s_metrics[numberOfMetrics].m_name = name;
+	s_metrics[numberOfMetrics].m_type = type;
+	s_metrics[numberOfMetrics].m_histogramIndex = histogramIndex;
+	s_metrics[numberOfMetrics].m_sampleFunction = sampleFunction;
+	s_numberOfMetrics.store(numberOfMetrics + 1, std::memory_order_release);
+	return (unsigned int)numberOfMetrics;
+}
+
+
+unsigned int Metrics::FindMetric(const char* name)
+{
+	size_t numberOfMetrics = GetNumberOfMetrics();
+	for (size_t index = 0; index < numberOfMetrics; ++index)
+	{
+		if (strcmp(s_metrics[index].m_name, name) == 0)
+			return (unsigned int)index;
+	}
+	return METRICS_INVALID_ID;
+}
+
+
+// Same layout as ProfileHistogram with 4 buckets per power of two , so values are within 25%.
+size_t Metrics::GetBucketIndex(unsigned long long value)
+{
+	if (value < METRICS_HISTOGRAM_LINEAR_BUCKETS)
+		return (size_t)value;
+
+	size_t exponent = 0;
+	while (value >= METRICS_HISTOGRAM_LINEAR_BUCKETS)
+	{
+		value >>= 1;
+		++exponent;
+	}
+
+	if (exponent > METRICS_HISTOGRAM_MAX_EXPONENT)
+		return METRICS_HISTOGRAM_BUCKETS - 1;
+	return METRICS_HISTOGRAM_LINEAR_BUCKETS + (exponent - 1) * METRICS_HISTOGRAM_SUB_BUCKETS + (size_t)value - METRICS_HISTOGRAM_SUB_BUCKETS;
+}
+
+
+// The upper edge of the bucket.
+unsigned long long Metrics::GetBucketValue(size_t bucketIndex)
+{
+	if (bucketIndex < METRICS_HISTOGRAM_LINEAR_BUCKETS)
+		return bucketIndex;
+
+	size_t exponent = (bucketIndex - METRICS_HISTOGRAM_LINEAR_BUCKETS) / METRICS_HISTOGRAM_SUB_BUCKETS + 1;
+	unsigned long long mantissa = (bucketIndex - METRICS_HISTOGRAM_LINEAR_BUCKETS) % METRICS_HISTOGRAM_SUB_BUCKETS + METRICS_HISTOGRAM_SUB_BUCKETS;
+	return ((mantissa + 1) << exponent) - 1;
+}
+
+
+static unsigned long long GetPercentile(const unsigned long long* bucketCounts, unsigned long long numberOfSamples, double percentile)
+{
+	unsigned long long rank = (unsigned long long)(percentile * 0.01 * numberOfSamples);
+	if (rank >= numberOfSamples)
+		rank = numberOfSamples - 1;
+
+	unsigned long long seen = 0;
+	for (size_t bucket = 0; bucket < METRICS_HISTOGRAM_BUCKETS; ++bucket)
+	{
+		seen += bucketCounts[bucket];
+		if (seen > rank)
+			return Metrics::GetBucketValue(bucket);
+	}
+	return Metrics::GetBucketValue(METRICS_HISTOGRAM_BUCKETS - 1);
+}
+
+
+// The live value of a counter or gauge , summed over the shards now rather than at the last EndFrame.
+long long Metrics::GetValue(unsigned int metricId)
+{
+	const MetricDescriptor& metric = s_metrics[metricId];
+	if (metric.m_sampleFunction)
+		return metric.m_sampleFunction();
+
+	long long value = metric.m_type == METRIC_GAUGE ? s_gaugeValues[metricId].load(std::memory_order_relaxed) : 0;
+	for (size_t shard = 0; shard < METRICS_SHARDS; ++shard)
+		value += s_shards[shard].m_values[metricId].load(std::memory_order_relaxed);
+	return value;
+}
+
+
+void Metrics::EndFrame()
+{
+	size_t numberOfMetrics = GetNumberOfMetrics();
+	unsigned long long bucketCounts[METRICS_HISTOGRAM_BUCKETS];
+	for (size_t metricId = 0; metricId < numberOfMetrics; ++metricId)
+	{
+		const MetricDescriptor& metric = s_metrics[metricId];
+		MetricSnapshot& snapshot = s_snapshots[metricId];
+		long long previousValue = snapshot.m_value;
+
+		if (metric.m_type == METRIC_HISTOGRAM)
+		{
+			unsigned long long numberOfSamples = 0;
+			long long sum = 0;
+			size_t highestBucket = 0;
+			for (size_t bucket = 0; bucket < METRICS_HISTOGRAM_BUCKETS; ++bucket)
+			{
+				bucketCounts[bucket] = 0;
+				for (size_t shard = 0; shard < METRICS_SHARDS; ++shard)
+					bucketCounts[bucket] += s_shards[shard].m_histogramBuckets[metric.m_histogramIndex][bucket].load(std::memory_order_relaxed);
+				numberOfSamples += bucketCounts[bucket];
+				if (bucketCounts[bucket] != 0)
+					highestBucket = bucket;
+			}
+			for (size_t shard = 0; shard < METRICS_SHARDS; ++shard)
+				sum += s_shards[shard].m_histogramSums[metric.m_histogramIndex].load(std::memory_order_relaxed);
+
+			snapshot.m_value = (long long)numberOfSamples;
+			snapshot.m_mean = numberOfSamples != 0 ? (double)sum / numberOfSamples : 0.0;
+			snapshot.m_p50 = numberOfSamples != 0 ? GetPercentile(bucketCounts, numberOfSamples, 50.0) : 0;
+			snapshot.m_p99 = numberOfSamples != 0 ? GetPercentile(bucketCounts, numberOfSamples, 99.0) : 0;
+			snapshot.m_max = numberOfSamples != 0 ? GetBucketValue(highestBucket) : 0;
+		}
+		else
+		{
+			snapshot.m_value = GetValue((unsigned int)metricId);
+		}
+
+		snapshot.m_deltaThisFrame = snapshot.m_value - previousValue;
+	}
+
+	++s_frameNumber;
+	if (s_dumpPeriod != 0 && s_frameNumber % s_dumpPeriod == 0)
+		WriteSnapshot(s_dumpPath, true);
+}
+
+
+// One json object per line , every dump of a run appends a line to the same file.
+bool Metrics::WriteSnapshot(const char* filePath, bool append)
+{
+	FILE* file = nullptr;
+#ifdef _MSC_VER
+	fopen_s(&file, filePath, append ? "a" : "w");
+#else
+	file = fopen(filePath, append ? "a" : "w");
+#endif
+	if (!file)
+		return false;
+
+	fprintf(file, "{ \"frame\" : %llu", s_frameNumber);
+	size_t numberOfMetrics = GetNumberOfMetrics();
+	for (size_t metricId = 1; metricId < numberOfMetrics; ++metricId)
+	{
+		const MetricDescriptor& metric = s_metrics[metricId];
+		const MetricSnapshot& snapshot = s_snapshots[metricId];
+		if (metric.m_type == METRIC_HISTOGRAM)
+			fprintf(file, ", \"%s\" : { \"count\" : %lld, \"delta\" : %lld, \"mean\" : %.3f, \"p50\" : %llu, \"p99\" : %llu, \"max\" : %llu }",
+				metric.m_name, snapshot.m_value, snapshot.m_deltaThisFrame, snapshot.m_mean, snapshot.m_p50, snapshot.m_p99, snapshot.m_max);
+		else if (metric.m_type == METRIC_COUNTER)
+			fprintf(file, ", \"%s\" : { \"total\" : %lld, \"delta\" : %lld }", metric.m_name, snapshot.m_value, snapshot.m_deltaThisFrame);
+		else
+			fprintf(file, ", \"%s\" : %lld", metric.m_name, snapshot.m_value);
+	}
+	if (s_snapshots[0].m_value != 0)
+		fprintf(file, ", \"%s\" : %lld", s_metrics[0].m_name, s_snapshots[0].m_value);
+	fprintf(file, " }\n");
+
+	fclose(file);
+	return true;
+}
+
+
+// 0 frames stops the periodic dump.
+void Metrics::SetDumpPeriod(const char* filePath, unsigned int numberOfFrames)
+{
+	s_dumpPeriod = 0;
+	if (numberOfFrames == 0 || !filePath)
+		return;
+
+	size_t length = strlen(filePath);
+	if (length >= sizeof(s_dumpPath))
+		length = sizeof(s_dumpPath) - 1;
+	memcpy(s_dumpPath, filePath, length);
+	s_dumpPath[length] = '\0';
+	s_dumpPeriod = numberOfFrames;
+}
+
+};
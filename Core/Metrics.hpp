@@ -0,0 +1,115 @@
+#pragma once
+
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <stddef.h>
+#include <atomic>
+
+namespace Henry
+{
+
+const size_t METRICS_MAX = 256;
+const size_t METRICS_MAX_HISTOGRAMS = 16;
+const size_t METRICS_SHARDS = 8;
+const size_t METRICS_HISTOGRAM_LINEAR_BUCKETS = 8;
+const size_t METRICS_HISTOGRAM_SUB_BUCKETS = 4;
+const size_t METRICS_HISTOGRAM_MAX_EXPONENT = 60;
+const size_t METRICS_HISTOGRAM_BUCKETS = METRICS_HISTOGRAM_LINEAR_BUCKETS + METRICS_HISTOGRAM_MAX_EXPONENT * METRICS_HISTOGRAM_SUB_BUCKETS;
+const unsigned int METRICS_INVALID_ID = 0xffffffff;
+
+enum MetricType { METRIC_COUNTER = 0 , METRIC_GAUGE , METRIC_HISTOGRAM };
+
+// Sampled gauges are read by EndFrame instead of being pushed , e.g. the size of a registry.
+typedef long long (MetricSampleFunction)();
+
+struct MetricDescriptor
+{
+	const char* m_name;
+	MetricType m_type;
+	unsigned int m_histogramIndex;
+	MetricSampleFunction* m_sampleFunction;
+};
+
+// What EndFrame saw , only touched by the thread that calls EndFrame.
+struct MetricSnapshot
+{
+	long long m_value;				// counter total , gauge value or histogram sample count
+	long long m_deltaThisFrame;		// counters and histograms , change since the previous snapshot
+	double m_mean;					// histograms only , over every sample so far
+	unsigned long long m_p50;
+	unsigned long long m_p99;
+	unsigned long long m_max;
+};
+
+// Every metric has one slot per shard and threads are spread over the shards , so writers on
+// different threads rarely touch the same cache line. EndFrame sums the shards.
+struct MetricShard
+{
+	std::atomic<long long> m_values[METRICS_MAX];
+	std::atomic<long long> m_histogramSums[METRICS_MAX_HISTOGRAMS];
+	std::atomic<unsigned int> m_histogramBuckets[METRICS_MAX_HISTOGRAMS][METRICS_HISTOGRAM_BUCKETS];
+};
+
+
+// Counters , gauges and histograms registered by name once and then updated through their id.
+// Keep the id in a static next to the code that updates it :
+//		static const unsigned int s_packetsSentMetric = Metrics::RegisterCounter("network.packetsSent");
+//		Metrics::Add(s_packetsSentMetric, 1);
+// Registering a name twice returns the same id. EndFrame , called once per frame by the main loop ,
+// takes the snapshot and writes it out every SetDumpPeriod frames.
+class Metrics
+{
+public:
+	static unsigned int RegisterCounter(const char* name) { return Register(name, METRIC_COUNTER, nullptr); };
+	static unsigned int RegisterGauge(const char* name, MetricSampleFunction* sampleFunction = nullptr) { return Register(name, METRIC_GAUGE, sampleFunction); };
+	static unsigned int RegisterHistogram(const char* name) { return Register(name, METRIC_HISTOGRAM, nullptr); };
+	static unsigned int FindMetric(const char* name);
+	static size_t GetNumberOfMetrics() { return s_numberOfMetrics.load(std::memory_order_acquire); };
+	static const MetricDescriptor& GetMetric(unsigned int metricId) { return s_metrics[metricId]; };
+
+	static inline void Add(unsigned int metricId, long long value) { GetThreadShard().m_values[metricId].fetch_add(value, std::memory_order_relaxed); };
+	static inline void Set(unsigned int metricId, long long value) { s_gaugeValues[metricId].store(value, std::memory_order_relaxed); };
+	static inline void Record(unsigned int metricId, unsigned long long value)
+	{
+		MetricShard& shard = GetThreadShard();
+		unsigned int histogramIndex = s_metrics[metricId].m_histogramIndex;
+		shard.m_histogramBuckets[histogramIndex][GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+		shard.m_histogramSums[histogramIndex].fetch_add((long long)value, std::memory_order_relaxed);
+	};
+
+	static void EndFrame();
+	static long long GetValue(unsigned int metricId);
+	static const MetricSnapshot& GetSnapshot(unsigned int metricId) { return s_snapshots[metricId]; };
+	static unsigned long long GetFrameNumber() { return s_frameNumber; };
+	static bool WriteSnapshot(const char* filePath, bool append = true);
+	static void SetDumpPeriod(const char* filePath, unsigned int numberOfFrames);
+
+	static size_t GetBucketIndex(unsigned long long value);
+	static unsigned long long GetBucketValue(size_t bucketIndex);
+
+private:
+	static unsigned int Register(const char* name, MetricType type, MetricSampleFunction* sampleFunction);
+	static inline MetricShard& GetThreadShard()
+	{
+		if (s_threadShard < 0)
+			s_threadShard = (int)(s_nextShard.fetch_add(1, std::memory_order_relaxed) % METRICS_SHARDS);
+		return s_shards[s_threadShard];
+	};
+
+	static MetricDescriptor s_metrics[METRICS_MAX];
+	static std::atomic<size_t> s_numberOfMetrics;
+	static std::atomic<unsigned int> s_numberOfHistograms;
+	static MetricShard s_shards[METRICS_SHARDS];
+	static std::atomic<long long> s_gaugeValues[METRICS_MAX];
+	static std::atomic<unsigned int> s_nextShard;
+	static thread_local int s_threadShard;
+	static MetricSnapshot s_snapshots[METRICS_MAX];
+	static unsigned long long s_frameNumber;
+	static unsigned int s_dumpPeriod;
+	static char s_dumpPath[260];
+};
+
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include "PerformanceCounters.hpp"
+
+#include <string.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace Henry
+{
+
+static const char* s_counterNames[PERFORMANCE_COUNTER_COUNT] = { "Cycles" , "Instructions" , "L1D Misses" , "LLC Misses" , "Branch Misses" };
+
+
+const char* PerformanceCounters::GetCounterName(PerformanceCounterType type)
+{
+	return s_counterNames[type];
+}
+
+
+#if defined(__linux__)
+
+struct PerformanceCounterGroup
+{
+	PerformanceCounterGroup();
+	~PerformanceCounterGroup();
+	bool Open();
+
+	int m_fileDescriptors[PERFORMANCE_COUNTER_COUNT];
+	int m_groupIndex[PERFORMANCE_COUNTER_COUNT];		// position in the group read , -1 when not opened
+	int m_numberOfOpenCounters;
+	bool m_tried;
+};
+
+
+PerformanceCounterGroup::PerformanceCounterGroup()
+	: m_numberOfOpenCounters(0)
+	, m_tried(false)
+{
+	for (int index = 0; index < PERFORMANCE_COUNTER_COUNT; ++index)
+	{
+		m_fileDescriptors[index] = -1;
+		m_groupIndex[index] = -1;
+	}
+}
+
+
+PerformanceCounterGroup::~PerformanceCounterGroup()
+{
+	for (int index = 0; index < PERFORMANCE_COUNTER_COUNT; ++index)
+	{
+		if (m_fileDescriptors[index] >= 0)
+			close(m_fileDescriptors[index]);
+	}
+}
+
+
+bool PerformanceCounterGroup::Open()
+{
+	m_tried = true;
+
+	static const unsigned int types[PERFORMANCE_COUNTER_COUNT] = { PERF_TYPE_HARDWARE , PERF_TYPE_HARDWARE , PERF_TYPE_HW_CACHE , PERF_TYPE_HARDWARE , PERF_TYPE_HARDWARE };
+	static const unsigned long long configs[PERFORMANCE_COUNTER_COUNT] =
+	{
+		PERF_COUNT_HW_CPU_CYCLES ,
+		PERF_COUNT_HW_INSTRUCTIONS ,
+		PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) ,
+		PERF_COUNT_HW_CACHE_MISSES ,
+		PERF_COUNT_HW_BRANCH_MISSES
+	};
+
+	for (int index = 0; index < PERFORMANCE_COUNTER_COUNT; ++index)
+	{
+		struct perf_event_attr attribute;
+		memset(&attribute, 0, sizeof(attribute));
+		attribute.size = sizeof(attribute);
+		attribute.type = types[index];
+		attribute.config = configs[index];
+		attribute.exclude_kernel = 1;
+		attribute.exclude_hv = 1;
+		attribute.read_format = PERF_FORMAT_GROUP;
+
+		int groupFileDescriptor = m_fileDescriptors[PERFORMANCE_COUNTER_CYCLES];
+		int fileDescriptor = (int)syscall(SYS_perf_event_open, &attribute, 0, -1, groupFileDescriptor, 0);
+		if (fileDescriptor < 0)
+		{
+			if (index == PERFORMANCE_COUNTER_CYCLES)
+				return false;
+			continue;
+		}
+
+		m_fileDescriptors[index] = fileDescriptor;
+		m_groupIndex[index] = m_numberOfOpenCounters++;
+	}
+
+	return true;
+}
+
+
+bool PerformanceCounters::Read(unsigned long long values[PERFORMANCE_COUNTER_COUNT])
+{
+	static thread_local PerformanceCounterGroup s_group;
+	if (!s_group.m_tried)
+		s_group.Open();
+
+	memset(values, 0, sizeof(unsigned long long) * PERFORMANCE_COUNTER_COUNT);
+	if (s_group.m_numberOfOpenCounters == 0)
+		return false;
+
+	// group read format : number of counters followed by each value in the order they were opened
+	unsigned long long buffer[1 + PERFORMANCE_COUNTER_COUNT];
+	if (read(s_group.m_fileDescriptors[PERFORMANCE_COUNTER_CYCLES], buffer, sizeof(buffer)) <= 0)
+		return false;
+
+	for (int index = 0; index < PERFORMANCE_COUNTER_COUNT; ++index)
+	{
+		if (s_group.m_groupIndex[index] >= 0 && (unsigned long long)s_group.m_groupIndex[index] < buffer[0])
+			values[index] = buffer[1 + s_group.m_groupIndex[index]];
+	}
+	return true;
+}
+
+#else
+
+bool PerformanceCounters::Read(unsigned long long values[PERFORMANCE_COUNTER_COUNT])
+{
+	memset(values, 0, sizeof(unsigned long long) * PERFORMANCE_COUNTER_COUNT);
+	return false;
+}
+
+#endif
+
+
+bool PerformanceCounters::IsSupported()
+{
+	unsigned long long values[PERFORMANCE_COUNTER_COUNT];
+	return Read(values);
+}
+
+};
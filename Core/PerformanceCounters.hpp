@@ -0,0 +1,35 @@
+#pragma once
+
+#ifndef PERFORMANCECOUNTERS_HPP
+#define PERFORMANCECOUNTERS_HPP
+
+
+namespace Henry
+{
+
+enum PerformanceCounterType
+{
+	PERFORMANCE_COUNTER_CYCLES = 0 ,
+	PERFORMANCE_COUNTER_INSTRUCTIONS ,
+	PERFORMANCE_COUNTER_L1D_MISSES ,
+	PERFORMANCE_COUNTER_LLC_MISSES ,
+	PERFORMANCE_COUNTER_BRANCH_MISSES ,
+	PERFORMANCE_COUNTER_COUNT
+};
+
+
+// Per thread hardware counters through perf_event_open , user space only. The counters of a thread are
+// opened as one group the first time it reads them and read together with a single syscall.
+// Counters the CPU or the kernel doesn't offer read as 0 , if cycles can't be opened the thread
+// has no counters at all and Read returns false. Other platforms always return false.
+class PerformanceCounters
+{
+public:
+	static bool Read(unsigned long long values[PERFORMANCE_COUNTER_COUNT]);
+	static bool IsSupported();
+	static const char* GetCounterName(PerformanceCounterType type);
+};
+
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "ProfileHistogram.hpp"
+
+#include <string.h>
+#include <math.h>
+
+
+namespace Henry
+{
+
+ProfileHistogram::ProfileHistogram()
+{
+	Clear();
+}
+
+
+void ProfileHistogram::Clear()
+{
+	memset(m_bucketCounts, 0, sizeof(m_bucketCounts));
+	m_nextSample = 0;
+	m_numberOfSamples = 0;
+}
+
+
+size_t ProfileHistogram::GetBucketIndex(unsigned long long nanoseconds)
+{
+	if (nanoseconds < PROFILE_HISTOGRAM_LINEAR_BUCKETS)
+		return (size_t)nanoseconds;
+
+	// shift until the value lands in [16,32) , each shift is one power of two
+	size_t exponent = 0;
+	while (nanoseconds >= PROFILE_HISTOGRAM_LINEAR_BUCKETS)
+	{
+		nanoseconds >>= 1;
+		++exponent;
+	}
+
+	if (exponent > PROFILE_HISTOGRAM_MAX_EXPONENT)
+		return PROFILE_HISTOGRAM_BUCKETS - 1;
+	return PROFILE_HISTOGRAM_LINEAR_BUCKETS + (exponent - 1) * PROFILE_HISTOGRAM_SUB_BUCKETS + (size_t)nanoseconds - PROFILE_HISTOGRAM_SUB_BUCKETS;
+}
+
+
+unsigned long long ProfileHistogram::GetBucketValue(size_t bucketIndex)
+{
+	if (bucketIndex < PROFILE_HISTOGRAM_LINEAR_BUCKETS)
+		return bucketIndex;
+
+	// highest value the bucket holds , so percentiles never under report
+	size_t relativeIndex = bucketIndex - PROFILE_HISTOGRAM_LINEAR_BUCKETS;
+	size_t exponent = relativeIndex / PROFILE_HISTOGRAM_SUB_BUCKETS + 1;
+	unsigned long long subBucket = relativeIndex % PROFILE_HISTOGRAM_SUB_BUCKETS + PROFILE_HISTOGRAM_SUB_BUCKETS;
+	return ((subBucket + 1) << exponent) - 1;
+}
+
+
+void ProfileHistogram::AddSample(unsigned long long nanoseconds)
+{
+	if (m_numberOfSamples == PROFILE_HISTOGRAM_WINDOW)
+		--m_bucketCounts[GetBucketIndex(m_samples[m_nextSample])];
+	else
+		++m_numberOfSamples;
+
+	m_samples[m_nextSample] = nanoseconds;
+	++m_bucketCounts[GetBucketIndex(nanoseconds)];
+	m_nextSample = (m_nextSample + 1) % PROFILE_HISTOGRAM_WINDOW;
+}
+
+
+unsigned long long ProfileHistogram::GetPercentile(double percentile) const
+{
+	if (m_numberOfSamples == 0)
+		return 0;
+
+	unsigned int rank = (unsigned int)ceil(percentile / 100.0 * m_numberOfSamples);
+	if (rank == 0)
+		rank = 1;
+
+	unsigned int count = 0;
+	for (size_t bucketIndex = 0; bucketIndex < PROFILE_HISTOGRAM_BUCKETS; ++bucketIndex)
+	{
+		count += m_bucketCounts[bucketIndex];
+		if (count >= rank)
+		{
+			unsigned long long value = GetBucketValue(bucketIndex);
+			unsigned long long maxValue = GetMax();
+			return value < maxValue ? value : maxValue;
+		}
+	}
+
+	return GetMax();
+}
+
+
+unsigned long long ProfileHistogram::GetMax() const
+{
+	unsigned long long maxValue = 0;
+	for (unsigned int index = 0; index < m_numberOfSamples; ++index)
+	{
+		if (m_samples[index] > maxValue)
+			maxValue = m_samples[index];
+	}
+	return maxValue;
+}
+
+
+unsigned int ProfileHistogram::GetNumberOfSamplesOver(unsigned long long nanoseconds) const
+{
+	unsigned int count = 0;
+	for (unsigned int index = 0; index < m_numberOfSamples; ++index)
+	{
+		if (m_samples[index] > nanoseconds)
+			++count;
+	}
+	return count;
+}
+
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#ifndef PROFILEHISTOGRAM_HPP
+#define PROFILEHISTOGRAM_HPP
+
+#include <stddef.h>
+
+
+namespace Henry
+{
+
+const size_t PROFILE_HISTOGRAM_WINDOW = 256;
+const size_t PROFILE_HISTOGRAM_LINEAR_BUCKETS = 32;
+const size_t PROFILE_HISTOGRAM_SUB_BUCKETS = 16;
+const size_t PROFILE_HISTOGRAM_MAX_EXPONENT = 40;
+const size_t PROFILE_HISTOGRAM_BUCKETS = PROFILE_HISTOGRAM_LINEAR_BUCKETS + PROFILE_HISTOGRAM_MAX_EXPONENT * PROFILE_HISTOGRAM_SUB_BUCKETS;
+
+
+// Log-linear (HDR style) histogram of the last PROFILE_HISTOGRAM_WINDOW samples , in nanoseconds.
+// Values below 32 get their own bucket , above that every power of two is split into 16 buckets
+// so percentiles are within about 6% of the real value. The oldest sample leaves the histogram
+// when a new one arrives.
+class ProfileHistogram
+{
+public:
+	ProfileHistogram();
+	void AddSample(unsigned long long nanoseconds);
+	unsigned long long GetPercentile(double percentile) const;
+	unsigned long long GetMax() const;
+	unsigned int GetNumberOfSamplesOver(unsigned long long nanoseconds) const;
+	unsigned int GetNumberOfSamples() const { return m_numberOfSamples; };
+	void Clear();
+
+	static size_t GetBucketIndex(unsigned long long nanoseconds);
+	static unsigned long long GetBucketValue(size_t bucketIndex);
+
+private:
+	unsigned long long m_samples[PROFILE_HISTOGRAM_WINDOW];
+	unsigned short m_bucketCounts[PROFILE_HISTOGRAM_BUCKETS];
+	unsigned int m_nextSample;
+	unsigned int m_numberOfSamples;
+};
+
+};
+
+#endif
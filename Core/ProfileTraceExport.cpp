@@ -0,0 +1,112 @@
+#include "ProfileTraceExport.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+
+namespace Henry
+{
+
+static void WriteJSONString(FILE* file, const char* text)
+{
+	fputc('"', file);
+	for ( ; *text; ++text)
+	{
+		unsigned char character = (unsigned char)*text;
+		if (character == '"' || character == '\\')
+			fprintf(file, "\\%c", character);
+		else if (character < 0x20)
+			fprintf(file, "\\u%04x", character);
+		else
+			fputc(character, file);
+	}
+	fputc('"', file);
+}
+
+
+void ProfileTraceExport::CollectThreads(std::vector<ProfileTraceThread>& out_threads)
+{
+	out_threads.clear();
+	for (size_t index = 0; index < Profiler::GetNumberOfThreads(); ++index)
+	{
+		const ProfileThreadTree* tree = Profiler::GetThreadTree(index);
+		if (!tree)
+			continue;
+
+		ProfileTraceThread thread;
+		thread.m_threadIndex = tree->m_buffer->m_threadIndex;
+		memcpy(thread.m_threadName, tree->m_buffer->m_threadName, sizeof(thread.m_threadName));
+		out_threads.push_back(thread);
+	}
+}
+
+
+bool ProfileTraceExport::WriteChromeTrace(const char* filePath, const std::vector<ProfileCaptureEvent>& events, unsigned long long beginTicks)
+{
+	std::vector<ProfileTraceThread> threads;
+	CollectThreads(threads);
+	return WriteChromeTrace(filePath, events, beginTicks, threads);
+}
+
+
+bool ProfileTraceExport::WriteChromeTrace(const char* filePath, const std::vector<ProfileCaptureEvent>& events, unsigned long long beginTicks, const std::vector<ProfileTraceThread>& threads)
+{
+	FILE* file = nullptr;
+#if defined(_MSC_VER)
+	fopen_s(&file, filePath, "w");
+#else
+	file = fopen(filePath, "w");
+#endif
+	if (file == nullptr)
+		return false;
+
+	fprintf(file, "{\n\"displayTimeUnit\": \"ms\",\n\"traceEvents\": [\n");
+	fprintf(file, "{ \"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": { \"name\": \"Engine\" } }");
+
+	for (size_t index = 0; index < threads.size(); ++index)
+	{
+		fprintf(file, ",\n{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": { \"name\": ", threads[index].m_threadIndex);
+		WriteJSONString(file, threads[index].m_threadName);
+		fprintf(file, " } }");
+	}
+
+	unsigned long long frameNumber = 0;
+	for (size_t index = 0; index < events.size(); ++index)
+	{
+		const ProfileCaptureEvent& captureEvent = events[index];
+		double timestamp = Profiler::TicksToSeconds(captureEvent.m_ticks - beginTicks) * 1000000.0;
+		if (captureEvent.m_ticks < beginTicks)
+			timestamp = 0.0;
+
+		switch (captureEvent.m_type)
+		{
+		case PROFILE_EVENT_BEGIN:
+		case PROFILE_EVENT_END:
+			fprintf(file, ",\n{ \"name\": ");
+			WriteJSONString(file, Profiler::GetScope(captureEvent.m_scopeId).m_name);
+			fprintf(file, ", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": 1, \"tid\": %u", captureEvent.m_type == PROFILE_EVENT_BEGIN ? 'B' : 'E', timestamp, captureEvent.m_threadIndex);
+			if (captureEvent.m_allocations != 0)
+				fprintf(file, ", \"args\": { \"allocations\": %u, \"allocatedBytes\": %.0f }", captureEvent.m_allocations, captureEvent.m_value);
+			fprintf(file, " }");
+			break;
+
+		case PROFILE_EVENT_COUNTER:
+			fprintf(file, ",\n{ \"name\": ");
+			WriteJSONString(file, Profiler::GetScope(captureEvent.m_scopeId).m_name);
+			fprintf(file, ", \"ph\": \"C\", \"ts\": %.3f, \"pid\": 1, \"args\": { \"value\": %.17g } }", timestamp, captureEvent.m_value);
+			break;
+
+		case PROFILE_EVENT_FRAME:
+			fprintf(file, ",\n{ \"name\": \"Frame %llu\", \"ph\": \"i\", \"s\": \"g\", \"ts\": %.3f, \"pid\": 1, \"tid\": %u }", frameNumber++, timestamp, captureEvent.m_threadIndex);
+			fprintf(file, ",\n{ \"name\": \"Frame Time (ms)\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": 1, \"args\": { \"value\": %.4f } }", timestamp, captureEvent.m_value);
+			break;
+		}
+	}
+
+	fprintf(file, "\n]\n}\n");
+	bool success = ferror(file) == 0;
+	fclose(file);
+	return success;
+}
+
+};
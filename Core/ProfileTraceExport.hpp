@@ -0,0 +1,35 @@
+#pragma once
+
+#ifndef PROFILETRACEEXPORT_HPP
+#define PROFILETRACEEXPORT_HPP
+
+#include <vector>
+
+#include "Engine\Core\Profiler.hpp"
+
+
+namespace Henry
+{
+
+struct ProfileTraceThread
+{
+	unsigned int m_threadIndex;
+	char m_threadName[PROFILE_THREAD_NAME_SIZE];
+};
+
+
+// Writes profiler captures in the Chrome trace_event JSON format , loads in chrome://tracing and ui.perfetto.dev.
+// Scopes become begin / end pairs on their thread , frames become global instant events plus a frame time
+// counter , PROFILE_COUNTER values become counter tracks. Tracked allocations become args of the scope's slice.
+// Writing off the frame thread takes the thread names collected on it , the scope names are never removed.
+class ProfileTraceExport
+{
+public:
+	static void CollectThreads(std::vector<ProfileTraceThread>& out_threads);
+	static bool WriteChromeTrace(const char* filePath, const std::vector<ProfileCaptureEvent>& events, unsigned long long beginTicks);
+	static bool WriteChromeTrace(const char* filePath, const std::vector<ProfileCaptureEvent>& events, unsigned long long beginTicks, const std::vector<ProfileTraceThread>& threads);
+};
+
+};
+
+#endif
@@ -0,0 +1,840 @@
+#include "Profiler.hpp"
+#include "Engine\Core\ProfileTraceExport.hpp"
+#include "Engine\Core\Metrics.hpp"
+#include "Engine\Memory\MemoryAllocatePool.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <map>
+#include <string>
+
+
+namespace Henry
+{
+
+ProfileScopeDescriptor Profiler::s_scopes[PROFILE_MAX_SCOPES] = { { "Frame" , "" , 0 } };
+std::atomic<size_t> Profiler::s_numberOfScopes(1);
+std::atomic<ProfileThreadBuffer*> Profiler::s_firstBuffer(nullptr);
+std::atomic<unsigned int> Profiler::s_numberOfBuffers(0);
+thread_local ProfileThreadBuffer* Profiler::s_threadBuffer = nullptr;
+thread_local ProfileThreadAllocations Profiler::s_threadAllocations = { 0 , 0 };
+std::vector<ProfileThreadTree*> Profiler::s_threadTrees;
+unsigned long long Profiler::s_frameBeginTicks = 0;
+unsigned long long Profiler::s_lastFrameTicks = 0;
+unsigned long long Profiler::s_frameNumber = 0;
+double Profiler::s_counterValues[PROFILE_MAX_SCOPES];
+ProfileHistogram* Profiler::s_scopeHistograms[PROFILE_MAX_SCOPES];
+double Profiler::s_scopeBudgets[PROFILE_MAX_SCOPES];
+unsigned long long Profiler::s_scopeTicksThisFrame[PROFILE_MAX_SCOPES];
+std::vector<unsigned int> Profiler::s_scopesThisFrame;
+std::vector<ProfileCaptureEvent> Profiler::s_captureEvents;
+char Profiler::s_capturePath[260];
+unsigned long long Profiler::s_captureBeginTicks = 0;
+unsigned int Profiler::s_captureFramesLeft = 0;
+unsigned int Profiler::s_captureDelayFrames = 0;
+bool Profiler::s_capturePending = false;
+bool Profiler::s_capturing = false;
+std::vector<ProfileHistoryFrame> Profiler::s_history;
+size_t Profiler::s_historyIndex = 0;
+size_t Profiler::s_historyFramesRecorded = 0;
+std::vector<unsigned int> Profiler::s_historyMetricScopes;
+std::vector<long long> Profiler::s_historyMetricTotals;
+char Profiler::s_hitchPrefix[260];
+char Profiler::s_lastHitchPath[280];
+unsigned long long Profiler::s_nextHitchFrame = 0;
+unsigned int Profiler::s_numberOfHitches = 0;
+bool Profiler::s_hardwareCounters = false;
+bool Profiler::s_allocationTracking = false;
+bool Profiler::s_enabled = true;
+
+
+struct ProfileHitchJob
+{
+	char m_path[280];
+	unsigned long long m_beginTicks;
+	std::vector<ProfileCaptureEvent> m_events;
+	std::vector<ProfileTraceThread> m_threads;
+};
+
+
+// Writes hitch windows on its own thread , started by the first hitch and joined by Shutdown.
+class ProfileHitchWriter
+{
+public:
+	ProfileHitchWriter() : m_quit(false) {};
+	~ProfileHitchWriter() { Shutdown(); };
+	void Submit(ProfileHitchJob* job);
+	void Shutdown();
+
+private:
+	void Run();
+
+	std::mutex m_lock;
+	std::condition_variable m_wake;
+	std::vector<ProfileHitchJob*> m_queue;
+	std::thread m_thread;
+	bool m_quit;
+};
+
+
+void ProfileHitchWriter::Submit(ProfileHitchJob* job)
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	m_queue.push_back(job);
+	if (!m_thread.joinable())
+	{
+		m_quit = false;
+		m_thread = std::thread(&ProfileHitchWriter::Run, this);
+	}
+	m_wake.notify_one();
+}
+
+
+// finishes what is queued before the thread exits
+void ProfileHitchWriter::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		if (!m_thread.joinable())
+			return;
+		m_quit = true;
+		m_wake.notify_one();
+	}
+	m_thread.join();
+}
+
+
+void ProfileHitchWriter::Run()
+{
+	std::unique_lock<std::mutex> guard(m_lock);
+	for (;;)
+	{
+		while (m_queue.empty() && !m_quit)
+			m_wake.wait(guard);
+		if (m_queue.empty())
+			break;
+
+		ProfileHitchJob* job = m_queue.front();
+		m_queue.erase(m_queue.begin());
+		guard.unlock();
+		ProfileTraceExport::WriteChromeTrace(job->m_path, job->m_events, job->m_beginTicks, job->m_threads);
+		delete job;
+		guard.lock();
+	}
+}
+
+
+static ProfileHitchWriter s_hitchWriter;
+
+
+static std::mutex& GetScopeLock()
+{
+	static std::mutex s_lock;
+	return s_lock;
+}
+
+
+// gives the ring back when its thread exits , the next new thread picks it up once it is drained
+struct ProfileThreadBufferOwner
+{
+	ProfileThreadBufferOwner() : m_buffer(nullptr) {};
+	~ProfileThreadBufferOwner() { if (m_buffer) m_buffer->m_inUse.store(false, std::memory_order_release); };
+	ProfileThreadBuffer* m_buffer;
+};
+
+
+unsigned int Profiler::RegisterScope(const char* name, const char* file, int line)
+{
+	std::lock_guard<std::mutex> guard(GetScopeLock());
+	size_t scopeId = s_numberOfScopes.load(std::memory_order_relaxed);
+	if (scopeId >= PROFILE_MAX_SCOPES)
+		return PROFILE_ROOT_SCOPE;
+
+	s_scopes[scopeId].m_name = name;
+	s_scopes[scopeId].m_file = file;
+	s_scopes[scopeId].m_line = line;
+	s_numberOfScopes.store(scopeId + 1, std::memory_order_release);
+	return (unsigned int)scopeId;
+}
+
+
+unsigned int Profiler::RegisterDynamicScope(const char* name)
+{
+	static std::map<std::string, unsigned int> s_dynamicScopes;
+	std::lock_guard<std::mutex> guard(GetScopeLock());
+	std::map<std::string, unsigned int>::iterator found = s_dynamicScopes.find(name);
+	if (found != s_dynamicScopes.end())
+		return found->second;
+
+	size_t scopeId = s_numberOfScopes.load(std::memory_order_relaxed);
+	if (scopeId >= PROFILE_MAX_SCOPES)
+		return PROFILE_ROOT_SCOPE;
+
+	// the map key keeps the name alive for the descriptor
+	found = s_dynamicScopes.insert(std::make_pair(std::string(name), (unsigned int)scopeId)).first;
+	s_scopes[scopeId].m_name = found->first.c_str();
+	s_scopes[scopeId].m_file = "";
+	s_scopes[scopeId].m_line = 0;
+	s_numberOfScopes.store(scopeId + 1, std::memory_order_release);
+	return (unsigned int)scopeId;
+}
+
+
+ProfileThreadBuffer* Profiler::CreateThreadBuffer()
+{
+	static thread_local ProfileThreadBufferOwner s_owner;
+
+	ProfileThreadBuffer* buffer = nullptr;
+	for (ProfileThreadBuffer* candidate = s_firstBuffer.load(std::memory_order_acquire); candidate; candidate = candidate->m_next)
+	{
+		bool expected = false;
+		if (candidate->m_readIndex.load(std::memory_order_acquire) == candidate->m_writeIndex.load(std::memory_order_relaxed)
+			&& candidate->m_inUse.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+		{
+			buffer = candidate;
+			break;
+		}
+	}
+
+	if (buffer == nullptr)
+	{
+		buffer = new ProfileThreadBuffer();
+		buffer->m_writeIndex.store(0, std::memory_order_relaxed);
+		buffer->m_readIndex.store(0, std::memory_order_relaxed);
+		buffer->m_droppedEvents.store(0, std::memory_order_relaxed);
+		buffer->m_inUse.store(true, std::memory_order_relaxed);
+		buffer->m_threadIndex = s_numberOfBuffers.fetch_add(1, std::memory_order_relaxed);
+		buffer->m_next = s_firstBuffer.load(std::memory_order_relaxed);
+		while (!s_firstBuffer.compare_exchange_weak(buffer->m_next, buffer, std::memory_order_release, std::memory_order_relaxed))
+		{
+		}
+	}
+
+#if defined(_MSC_VER)
+	sprintf_s(buffer->m_threadName, sizeof(buffer->m_threadName), "Thread %u", buffer->m_threadIndex);
+#else
+	snprintf(buffer->m_threadName, sizeof(buffer->m_threadName), "Thread %u", buffer->m_threadIndex);
+#endif
+	s_owner.m_buffer = buffer;
+	s_threadBuffer = buffer;
+	return buffer;
+}
+
+
+unsigned int Profiler::FindScope(const char* name)
+{
+	size_t numberOfScopes = GetNumberOfScopes();
+	for (size_t scopeId = 0; scopeId < numberOfScopes; ++scopeId)
+	{
+		if (strcmp(s_scopes[scopeId].m_name, name) == 0)
+			return (unsigned int)scopeId;
+	}
+	return PROFILE_ROOT_SCOPE;
+}
+
+
+void Profiler::SetThreadName(const char* name)
+{
+	ProfileThreadBuffer* buffer = s_threadBuffer ? s_threadBuffer : CreateThreadBuffer();
+	size_t length = strlen(name);
+	if (length >= PROFILE_THREAD_NAME_SIZE)
+		length = PROFILE_THREAD_NAME_SIZE - 1;
+	memcpy(buffer->m_threadName, name, length);
+	buffer->m_threadName[length] = '\0';
+}
+
+
+// Slow path of BeginScope / EndScope while hardware counters are on , the counter values follow the
+// event in the ring. Threads without counters push a plain event.
+void Profiler::PushEventWithCounters(unsigned int scopeId, ProfileEventType type)
+{
+	if (!s_enabled)
+		return;
+
+	ProfileThreadBuffer* buffer = s_threadBuffer;
+	if (buffer == nullptr)
+		buffer = CreateThreadBuffer();
+	if (s_threadAllocations.m_count != 0)
+		PushAllocations(buffer);
+
+	size_t writeIndex = buffer->m_writeIndex.load(std::memory_order_relaxed);
+	if (writeIndex + 1 + PROFILE_HARDWARE_COUNTER_SLOTS - buffer->m_readIndex.load(std::memory_order_acquire) > PROFILE_RING_CAPACITY)
+	{
+		buffer->m_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	// the counter reads stay outside of the scope's wall time
+	unsigned long long counters[PROFILE_HARDWARE_COUNTER_SLOTS * 2] = { 0 };
+	unsigned long long ticks;
+	bool hasCounters;
+	if (type == PROFILE_EVENT_BEGIN)
+	{
+		hasCounters = PerformanceCounters::Read(counters);
+		ticks = GetTicks();
+	}
+	else
+	{
+		ticks = GetTicks();
+		hasCounters = PerformanceCounters::Read(counters);
+	}
+
+	ProfileEvent& profileEvent = buffer->m_events[writeIndex & (PROFILE_RING_CAPACITY - 1)];
+	profileEvent.m_ticks = ticks;
+	profileEvent.m_scopeId = scopeId;
+	profileEvent.m_type = hasCounters ? ((unsigned int)type | PROFILE_EVENT_HARDWARE_COUNTERS) : (unsigned int)type;
+	if (hasCounters)
+	{
+		for (size_t slot = 0; slot < PROFILE_HARDWARE_COUNTER_SLOTS; ++slot)
+			memcpy(&buffer->m_events[(writeIndex + 1 + slot) & (PROFILE_RING_CAPACITY - 1)], &counters[slot * 2], sizeof(ProfileEvent));
+	}
+	buffer->m_writeIndex.store(writeIndex + (hasCounters ? 1 + PROFILE_HARDWARE_COUNTER_SLOTS : 1), std::memory_order_release);
+}
+
+
+// The count goes in m_scopeId and the bytes in m_ticks. With the ring full they stay pending until the next event.
+void Profiler::PushAllocations(ProfileThreadBuffer* buffer)
+{
+	size_t writeIndex = buffer->m_writeIndex.load(std::memory_order_relaxed);
+	if (writeIndex - buffer->m_readIndex.load(std::memory_order_acquire) >= PROFILE_RING_CAPACITY)
+		return;
+
+	ProfileEvent& profileEvent = buffer->m_events[writeIndex & (PROFILE_RING_CAPACITY - 1)];
+	profileEvent.m_ticks = s_threadAllocations.m_bytes;
+	profileEvent.m_scopeId = s_threadAllocations.m_count;
+	profileEvent.m_type = PROFILE_EVENT_ALLOCATIONS;
+	buffer->m_writeIndex.store(writeIndex + 1, std::memory_order_release);
+	s_threadAllocations.m_count = 0;
+	s_threadAllocations.m_bytes = 0;
+}
+
+
+bool Profiler::EnableHardwareCounters(bool enable)
+{
+	if (enable && !PerformanceCounters::IsSupported())
+		enable = false;
+
+	s_hardwareCounters = enable;
+	return enable;
+}
+
+
+int Profiler::FindOrAddChild(ProfileThreadTree& tree, int parent, unsigned int scopeId)
+{
+	int lastChild = -1;
+	for (int child = tree.m_nodes[parent].m_firstChild; child >= 0; child = tree.m_nodes[child].m_nextSibling)
+	{
+		if (tree.m_nodes[child].m_scopeId == scopeId)
+			return child;
+		lastChild = child;
+	}
+
+	ProfileNode node;
+	memset(&node, 0, sizeof(node));
+	node.m_scopeId = scopeId;
+	node.m_parent = parent;
+	node.m_firstChild = -1;
+	node.m_nextSibling = -1;
+	node.m_depth = tree.m_nodes[parent].m_depth + 1;
+
+	int index = (int)tree.m_nodes.size();
+	tree.m_nodes.push_back(node);
+	if (lastChild >= 0)
+		tree.m_nodes[lastChild].m_nextSibling = index;
+	else
+		tree.m_nodes[parent].m_firstChild = index;
+	return index;
+}
+
+
+void Profiler::DrainThreadBuffer(ProfileThreadTree& tree)
+{
+	ProfileThreadBuffer* buffer = tree.m_buffer;
+	size_t readIndex = buffer->m_readIndex.load(std::memory_order_relaxed);
+	size_t writeIndex = buffer->m_writeIndex.load(std::memory_order_acquire);
+
+	for ( ; readIndex != writeIndex; ++readIndex)
+	{
+		const ProfileEvent& profileEvent = buffer->m_events[readIndex & (PROFILE_RING_CAPACITY - 1)];
+		if (profileEvent.m_type == PROFILE_EVENT_COUNTER)
+		{
+			++readIndex;
+			double value;
+			memcpy(&value, &buffer->m_events[readIndex & (PROFILE_RING_CAPACITY - 1)].m_ticks, sizeof(value));
+			s_counterValues[profileEvent.m_scopeId] = value;
+			if (s_capturing)
+				CaptureEvent(profileEvent.m_ticks, profileEvent.m_scopeId, PROFILE_EVENT_COUNTER, buffer->m_threadIndex, value);
+			if (!s_history.empty())
+				RecordHistoryEvent(profileEvent.m_ticks, profileEvent.m_scopeId, PROFILE_EVENT_COUNTER, buffer->m_threadIndex, value);
+			continue;
+		}
+
+		if (profileEvent.m_type == PROFILE_EVENT_ALLOCATIONS)
+		{
+			ProfileNode& node = tree.m_nodes[tree.m_openScopes.empty() ? 0 : tree.m_openScopes.back().m_node];
+			node.m_allocationsThisFrame += profileEvent.m_scopeId;
+			node.m_allocatedBytesThisFrame += profileEvent.m_ticks;
+			if (!tree.m_openScopes.empty())
+			{
+				tree.m_openScopes.back().m_allocations += profileEvent.m_scopeId;
+				tree.m_openScopes.back().m_allocatedBytes += profileEvent.m_ticks;
+			}
+			continue;
+		}
+
+		ProfileEventType type = (ProfileEventType)(profileEvent.m_type & ~PROFILE_EVENT_HARDWARE_COUNTERS);
+		bool hasCounters = (profileEvent.m_type & PROFILE_EVENT_HARDWARE_COUNTERS) != 0;
+		unsigned long long counters[PROFILE_HARDWARE_COUNTER_SLOTS * 2];
+		if (hasCounters)
+		{
+			for (size_t slot = 0; slot < PROFILE_HARDWARE_COUNTER_SLOTS; ++slot)
+				memcpy(&counters[slot * 2], &buffer->m_events[(readIndex + 1 + slot) & (PROFILE_RING_CAPACITY - 1)], sizeof(ProfileEvent));
+			readIndex += PROFILE_HARDWARE_COUNTER_SLOTS;
+		}
+
+		unsigned int allocations = 0;
+		double allocatedBytes = 0.0;
+		if (type == PROFILE_EVENT_END && !tree.m_openScopes.empty() && tree.m_openScopes.back().m_scopeId == profileEvent.m_scopeId)
+		{
+			allocations = tree.m_openScopes.back().m_allocations;
+			allocatedBytes = (double)tree.m_openScopes.back().m_allocatedBytes;
+		}
+
+		if (s_capturing)
+			CaptureEvent(profileEvent.m_ticks, profileEvent.m_scopeId, type, buffer->m_threadIndex, allocatedBytes, allocations);
+		if (!s_history.empty())
+			RecordHistoryEvent(profileEvent.m_ticks, profileEvent.m_scopeId, type, buffer->m_threadIndex, allocatedBytes, allocations);
+
+		if (type == PROFILE_EVENT_BEGIN)
+		{
+			int parent = tree.m_openScopes.empty() ? 0 : tree.m_openScopes.back().m_node;
+			ProfileOpenScope openScope;
+			openScope.m_node = FindOrAddChild(tree, parent, profileEvent.m_scopeId);
+			openScope.m_scopeId = profileEvent.m_scopeId;
+			openScope.m_beginTicks = profileEvent.m_ticks;
+			openScope.m_hasCounters = hasCounters;
+			openScope.m_allocations = 0;
+			openScope.m_allocatedBytes = 0;
+			if (hasCounters)
+				memcpy(openScope.m_beginCounters, counters, sizeof(openScope.m_beginCounters));
+			tree.m_openScopes.push_back(openScope);
+			continue;
+		}
+
+		// an end without its begin means events were dropped , close scopes until it matches
+		size_t depth = tree.m_openScopes.size();
+		while (depth > 0 && tree.m_openScopes[depth - 1].m_scopeId != profileEvent.m_scopeId)
+			--depth;
+		if (depth == 0)
+			continue;
+
+		tree.m_openScopes.resize(depth);
+		const ProfileOpenScope& openScope = tree.m_openScopes.back();
+		ProfileNode& node = tree.m_nodes[openScope.m_node];
+		++node.m_callsThisFrame;
+		node.m_ticksThisFrame += profileEvent.m_ticks - openScope.m_beginTicks;
+		if (hasCounters && openScope.m_hasCounters)
+		{
+			++node.m_counterCallsThisFrame;
+			for (int counter = 0; counter < PERFORMANCE_COUNTER_COUNT; ++counter)
+				node.m_countersThisFrame[counter] += counters[counter] - openScope.m_beginCounters[counter];
+		}
+		tree.m_openScopes.pop_back();
+	}
+
+	buffer->m_readIndex.store(readIndex, std::memory_order_release);
+}
+
+
+void Profiler::EndFrame()
+{
+	unsigned long long frameEndTicks = GetTicks();
+	if (s_frameBeginTicks != 0)
+		s_lastFrameTicks = frameEndTicks - s_frameBeginTicks;
+	s_frameBeginTicks = frameEndTicks;
+	++s_frameNumber;
+
+	// the pool's allocations per second are taken over the last frame
+	if (_memoryAllocatePool && s_lastFrameTicks != 0)
+		_memoryAllocatePool->m_telemetry.UpdateRates(TicksToSeconds(s_lastFrameTicks));
+
+	// a thread registering now counts itself before it links its buffer , so size from the buffer seen
+	for (ProfileThreadBuffer* buffer = s_firstBuffer.load(std::memory_order_acquire); buffer; buffer = buffer->m_next)
+	{
+		if (buffer->m_threadIndex >= s_threadTrees.size())
+			s_threadTrees.resize(buffer->m_threadIndex + 1, nullptr);
+
+		ProfileThreadTree*& tree = s_threadTrees[buffer->m_threadIndex];
+		if (tree == nullptr)
+		{
+			tree = new ProfileThreadTree();
+			tree->m_buffer = buffer;
+			tree->m_droppedEventsLastFrame = 0;
+			ProfileNode root;
+			memset(&root, 0, sizeof(root));
+			root.m_scopeId = PROFILE_ROOT_SCOPE;
+			root.m_parent = -1;
+			root.m_firstChild = -1;
+			root.m_nextSibling = -1;
+			tree->m_nodes.push_back(root);
+		}
+
+		DrainThreadBuffer(*tree);
+		tree->m_droppedEventsLastFrame = buffer->m_droppedEvents.exchange(0, std::memory_order_relaxed);
+
+		for (size_t index = 0; index < tree->m_nodes.size(); ++index)
+		{
+			ProfileNode& node = tree->m_nodes[index];
+			if (node.m_callsThisFrame && index != 0)
+			{
+				if (s_scopeTicksThisFrame[node.m_scopeId] == 0)
+					s_scopesThisFrame.push_back(node.m_scopeId);
+				s_scopeTicksThisFrame[node.m_scopeId] += node.m_ticksThisFrame;
+			}
+
+			node.m_callsLastFrame = node.m_callsThisFrame;
+			node.m_counterCallsLastFrame = node.m_counterCallsThisFrame;
+			memcpy(node.m_countersLastFrame, node.m_countersThisFrame, sizeof(node.m_countersLastFrame));
+			memset(node.m_countersThisFrame, 0, sizeof(node.m_countersThisFrame));
+			node.m_counterCallsThisFrame = 0;
+			node.m_allocationsLastFrame = node.m_allocationsThisFrame;
+			node.m_allocatedBytesLastFrame = node.m_allocatedBytesThisFrame;
+			node.m_allocationsThisFrame = 0;
+			node.m_allocatedBytesThisFrame = 0;
+			node.m_ticksLastFrame = node.m_ticksThisFrame;
+			node.m_totalCalls += node.m_callsThisFrame;
+			node.m_totalTicks += node.m_ticksThisFrame;
+			if (node.m_callsThisFrame)
+				++node.m_framesActive;
+			node.m_callsThisFrame = 0;
+			node.m_ticksThisFrame = 0;
+		}
+
+		tree->m_nodes[0].m_ticksLastFrame = s_lastFrameTicks;
+	}
+
+	UpdateScopeHistograms();
+
+	if (s_capturing)
+	{
+		CaptureEvent(frameEndTicks, PROFILE_ROOT_SCOPE, PROFILE_EVENT_FRAME, 0, TicksToSeconds(s_lastFrameTicks) * 1000.0);
+		if (s_captureFramesLeft != 0 && --s_captureFramesLeft == 0)
+			FinishCapture();
+	}
+	else if (s_capturePending && s_captureDelayFrames-- == 0)
+	{
+		// scopes already open when the capture starts get a begin at the first frame marker
+		s_capturePending = false;
+		s_capturing = true;
+		s_captureBeginTicks = frameEndTicks;
+		s_captureEvents.clear();
+		CaptureOpenScopes(PROFILE_EVENT_BEGIN, frameEndTicks);
+		CaptureEvent(frameEndTicks, PROFILE_ROOT_SCOPE, PROFILE_EVENT_FRAME, 0, TicksToSeconds(s_lastFrameTicks) * 1000.0);
+	}
+
+	if (!s_history.empty())
+		EndHistoryFrame(frameEndTicks);
+}
+
+
+void Profiler::UpdateScopeHistograms()
+{
+	if (s_lastFrameTicks != 0)
+	{
+		s_scopeTicksThisFrame[PROFILE_ROOT_SCOPE] = s_lastFrameTicks;
+		s_scopesThisFrame.push_back(PROFILE_ROOT_SCOPE);
+	}
+
+	for (size_t index = 0; index < s_scopesThisFrame.size(); ++index)
+	{
+		unsigned int scopeId = s_scopesThisFrame[index];
+		if (s_scopeHistograms[scopeId] == nullptr)
+			s_scopeHistograms[scopeId] = new ProfileHistogram();
+
+		s_scopeHistograms[scopeId]->AddSample((unsigned long long)(TicksToSeconds(s_scopeTicksThisFrame[scopeId]) * 1000000000.0));
+		s_scopeTicksThisFrame[scopeId] = 0;
+	}
+	s_scopesThisFrame.clear();
+}
+
+
+bool Profiler::GetScopeStatistics(unsigned int scopeId, ProfileScopeStatistics& statistics)
+{
+	const ProfileHistogram* histogram = s_scopeHistograms[scopeId];
+	if (histogram == nullptr || histogram->GetNumberOfSamples() == 0)
+		return false;
+
+	statistics.m_numberOfSamples = histogram->GetNumberOfSamples();
+	statistics.m_p50 = histogram->GetPercentile(50.0) * 0.000000001;
+	statistics.m_p95 = histogram->GetPercentile(95.0) * 0.000000001;
+	statistics.m_p99 = histogram->GetPercentile(99.0) * 0.000000001;
+	statistics.m_max = histogram->GetMax() * 0.000000001;
+	statistics.m_budget = s_scopeBudgets[scopeId];
+	statistics.m_numberOfFramesOverBudget = statistics.m_budget > 0.0 ? histogram->GetNumberOfSamplesOver((unsigned long long)(statistics.m_budget * 1000000000.0)) : 0;
+	return true;
+}
+
+
+bool Profiler::StartCapture(const char* filePath, unsigned int numberOfFrames, unsigned int startAfterFrames)
+{
+	if (IsCapturing() || strlen(filePath) >= sizeof(s_capturePath))
+		return false;
+
+	memcpy(s_capturePath, filePath, strlen(filePath) + 1);
+	s_captureFramesLeft = numberOfFrames;
+	s_captureDelayFrames = startAfterFrames;
+	s_capturePending = true;
+	return true;
+}
+
+
+bool Profiler::StopCapture()
+{
+	if (s_capturePending)
+	{
+		s_capturePending = false;
+		return false;
+	}
+
+	if (!s_capturing)
+		return false;
+
+	for (size_t index = 0; index < s_threadTrees.size(); ++index)
+	{
+		if (s_threadTrees[index])
+			DrainThreadBuffer(*s_threadTrees[index]);
+	}
+	return FinishCapture();
+}
+
+
+void Profiler::CaptureEvent(unsigned long long ticks, unsigned int scopeId, ProfileEventType type, unsigned int threadIndex, double value, unsigned int allocations)
+{
+	if (s_captureEvents.size() >= PROFILE_CAPTURE_MAX_EVENTS)
+		return;
+
+	ProfileCaptureEvent captureEvent;
+	captureEvent.m_ticks = ticks;
+	captureEvent.m_scopeId = scopeId;
+	captureEvent.m_type = (unsigned short)type;
+	captureEvent.m_threadIndex = (unsigned short)threadIndex;
+	captureEvent.m_value = value;
+	captureEvent.m_allocations = allocations;
+	s_captureEvents.push_back(captureEvent);
+}
+
+
+void Profiler::CaptureOpenScopes(ProfileEventType type, unsigned long long ticks)
+{
+	for (size_t index = 0; index < s_threadTrees.size(); ++index)
+	{
+		ProfileThreadTree* tree = s_threadTrees[index];
+		if (tree == nullptr)
+			continue;
+
+		size_t numberOfOpenScopes = tree->m_openScopes.size();
+		for (size_t depth = 0; depth < numberOfOpenScopes; ++depth)
+		{
+			const ProfileOpenScope& openScope = tree->m_openScopes[type == PROFILE_EVENT_BEGIN ? depth : numberOfOpenScopes - 1 - depth];
+			CaptureEvent(ticks, openScope.m_scopeId, type, tree->m_buffer->m_threadIndex, 0.0);
+		}
+	}
+}
+
+
+bool Profiler::FinishCapture()
+{
+	CaptureOpenScopes(PROFILE_EVENT_END, GetTicks());
+	s_capturing = false;
+
+	bool success = ProfileTraceExport::WriteChromeTrace(s_capturePath, s_captureEvents, s_captureBeginTicks);
+	std::vector<ProfileCaptureEvent>().swap(s_captureEvents);
+	return success;
+}
+
+
+bool Profiler::EnableHitchDetector(const char* filePrefix, unsigned int numberOfFrames)
+{
+	if (numberOfFrames == 0 || numberOfFrames > PROFILE_HITCH_MAX_FRAMES || strlen(filePrefix) >= sizeof(s_hitchPrefix))
+		return false;
+
+	memcpy(s_hitchPrefix, filePrefix, strlen(filePrefix) + 1);
+	s_history.resize(numberOfFrames);
+	for (size_t index = 0; index < s_history.size(); ++index)
+	{
+		s_history[index].m_events.clear();
+		s_history[index].m_openScopes.clear();
+	}
+
+	s_historyIndex = 0;
+	s_historyFramesRecorded = 0;
+	s_history[0].m_beginTicks = GetTicks();
+	s_nextHitchFrame = s_frameNumber + 1;
+	return true;
+}
+
+
+void Profiler::DisableHitchDetector()
+{
+	s_hitchWriter.Shutdown();
+	std::vector<ProfileHistoryFrame>().swap(s_history);
+	std::vector<unsigned int>().swap(s_historyMetricScopes);
+	std::vector<long long>().swap(s_historyMetricTotals);
+}
+
+
+void Profiler::RecordHistoryEvent(unsigned long long ticks, unsigned int scopeId, ProfileEventType type, unsigned int threadIndex, double value, unsigned int allocations)
+{
+	std::vector<ProfileCaptureEvent>& events = s_history[s_historyIndex].m_events;
+	if (events.size() >= PROFILE_HITCH_MAX_EVENTS_PER_FRAME)
+		return;
+
+	ProfileCaptureEvent captureEvent;
+	captureEvent.m_ticks = ticks;
+	captureEvent.m_scopeId = scopeId;
+	captureEvent.m_type = (unsigned short)type;
+	captureEvent.m_threadIndex = (unsigned short)threadIndex;
+	captureEvent.m_value = value;
+	captureEvent.m_allocations = allocations;
+	events.push_back(captureEvent);
+}
+
+
+// Closes the current history frame with the metrics and the frame marker , writes the window out when the
+// frame went over budget , then moves on to the oldest slot and starts it with the scopes still open.
+void Profiler::EndHistoryFrame(unsigned long long frameEndTicks)
+{
+	size_t numberOfMetrics = Metrics::GetNumberOfMetrics();
+	while (s_historyMetricScopes.size() < numberOfMetrics)
+	{
+		unsigned int metricId = (unsigned int)s_historyMetricScopes.size();
+		const MetricDescriptor& metric = Metrics::GetMetric(metricId);
+		bool recorded = metricId != 0 && metric.m_type != METRIC_HISTOGRAM;		// 0 is the overflow slot
+		s_historyMetricScopes.push_back(recorded ? RegisterDynamicScope(metric.m_name) : PROFILE_ROOT_SCOPE);
+		s_historyMetricTotals.push_back(recorded ? Metrics::GetValue(metricId) : 0);
+	}
+
+	// counters show their change over the frame , gauges their value , both from the start of the frame
+	ProfileHistoryFrame& frame = s_history[s_historyIndex];
+	for (size_t metricId = 0; metricId < numberOfMetrics; ++metricId)
+	{
+		if (s_historyMetricScopes[metricId] == PROFILE_ROOT_SCOPE)
+			continue;
+
+		long long value = Metrics::GetValue((unsigned int)metricId);
+		if (Metrics::GetMetric((unsigned int)metricId).m_type == METRIC_COUNTER)
+		{
+			long long total = value;
+			value -= s_historyMetricTotals[metricId];
+			s_historyMetricTotals[metricId] = total;
+		}
+		RecordHistoryEvent(frame.m_beginTicks, s_historyMetricScopes[metricId], PROFILE_EVENT_COUNTER, 0, (double)value);
+	}
+	RecordHistoryEvent(frameEndTicks, PROFILE_ROOT_SCOPE, PROFILE_EVENT_FRAME, 0, TicksToSeconds(s_lastFrameTicks) * 1000.0);
+	++s_historyFramesRecorded;
+
+	double budget = s_scopeBudgets[PROFILE_ROOT_SCOPE];
+	if (budget > 0.0 && s_frameNumber >= s_nextHitchFrame && TicksToSeconds(s_lastFrameTicks) > budget)
+	{
+		QueueHitch(frameEndTicks);
+		s_nextHitchFrame = s_frameNumber + s_history.size();
+	}
+
+	s_historyIndex = (s_historyIndex + 1) % s_history.size();
+	ProfileHistoryFrame& nextFrame = s_history[s_historyIndex];
+	nextFrame.m_beginTicks = frameEndTicks;
+	nextFrame.m_events.clear();
+	nextFrame.m_openScopes.clear();
+	for (size_t index = 0; index < s_threadTrees.size(); ++index)
+	{
+		ProfileThreadTree* tree = s_threadTrees[index];
+		if (tree == nullptr)
+			continue;
+
+		for (size_t depth = 0; depth < tree->m_openScopes.size(); ++depth)
+		{
+			ProfileCaptureEvent captureEvent;
+			captureEvent.m_ticks = frameEndTicks;
+			captureEvent.m_scopeId = tree->m_openScopes[depth].m_scopeId;
+			captureEvent.m_type = PROFILE_EVENT_BEGIN;
+			captureEvent.m_threadIndex = (unsigned short)tree->m_buffer->m_threadIndex;
+			captureEvent.m_value = 0.0;
+			captureEvent.m_allocations = 0;
+			nextFrame.m_openScopes.push_back(captureEvent);
+		}
+	}
+}
+
+
+// Copies the window and the thread names , the file is written by the hitch writer thread.
+void Profiler::QueueHitch(unsigned long long frameEndTicks)
+{
+	size_t numberOfSlots = s_history.size();
+	size_t numberOfFrames = s_historyFramesRecorded < numberOfSlots ? s_historyFramesRecorded : numberOfSlots;
+	size_t oldest = (s_historyIndex + numberOfSlots + 1 - numberOfFrames) % numberOfSlots;
+
+	ProfileHitchJob* job = new ProfileHitchJob();
+	job->m_beginTicks = s_history[oldest].m_beginTicks;
+	job->m_events.assign(s_history[oldest].m_openScopes.begin(), s_history[oldest].m_openScopes.end());
+	for (size_t frame = 0; frame < numberOfFrames; ++frame)
+	{
+		const std::vector<ProfileCaptureEvent>& events = s_history[(oldest + frame) % numberOfSlots].m_events;
+		job->m_events.insert(job->m_events.end(), events.begin(), events.end());
+	}
+
+	for (size_t index = 0; index < s_threadTrees.size(); ++index)
+	{
+		ProfileThreadTree* tree = s_threadTrees[index];
+		if (tree == nullptr)
+			continue;
+
+		for (size_t depth = tree->m_openScopes.size(); depth > 0; --depth)
+		{
+			ProfileCaptureEvent captureEvent;
+			captureEvent.m_ticks = frameEndTicks;
+			captureEvent.m_scopeId = tree->m_openScopes[depth - 1].m_scopeId;
+			captureEvent.m_type = PROFILE_EVENT_END;
+			captureEvent.m_threadIndex = (unsigned short)tree->m_buffer->m_threadIndex;
+			captureEvent.m_value = 0.0;
+			captureEvent.m_allocations = 0;
+			job->m_events.push_back(captureEvent);
+		}
+	}
+	ProfileTraceExport::CollectThreads(job->m_threads);
+
+#if defined(_MSC_VER)
+	sprintf_s(s_lastHitchPath, sizeof(s_lastHitchPath), "%s_%llu.json", s_hitchPrefix, s_frameNumber);
+#else
+	snprintf(s_lastHitchPath, sizeof(s_lastHitchPath), "%s_%llu.json", s_hitchPrefix, s_frameNumber);
+#endif
+	memcpy(job->m_path, s_lastHitchPath, sizeof(job->m_path));
+	++s_numberOfHitches;
+	s_hitchWriter.Submit(job);
+}
+
+
+void Profiler::Reset()
+{
+	for (size_t index = 0; index < s_threadTrees.size(); ++index)
+	{
+		ProfileThreadTree* tree = s_threadTrees[index];
+		if (tree == nullptr)
+			continue;
+
+		DrainThreadBuffer(*tree);
+		tree->m_nodes.resize(1);
+		tree->m_nodes[0].m_firstChild = -1;
+		tree->m_openScopes.clear();
+	}
+
+	for (size_t scopeId = 0; scopeId < PROFILE_MAX_SCOPES; ++scopeId)
+	{
+		if (s_scopeHistograms[scopeId])
+			s_scopeHistograms[scopeId]->Clear();
+	}
+}
+
+};
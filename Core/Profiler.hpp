@@ -0,0 +1,376 @@
+#pragma once
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include <vector>
+
+#include "Engine\Core\ProfileHistogram.hpp"
+#include "Engine\Core\PerformanceCounters.hpp"
+#include "Engine\Core\Timebase.hpp"
+
+#ifndef UNUSED
+#define UNUSED(x) (void)(x);
+#endif
+
+
+namespace Henry
+{
+
+const size_t PROFILE_MAX_SCOPES = 4096;
+const size_t PROFILE_RING_CAPACITY = 1 << 16;		// events per thread , must be a power of two
+const size_t PROFILE_THREAD_NAME_SIZE = 32;
+const size_t PROFILE_CAPTURE_MAX_EVENTS = 1 << 22;
+const unsigned int PROFILE_ROOT_SCOPE = 0;
+const unsigned int PROFILE_HITCH_DEFAULT_FRAMES = 8;
+const unsigned int PROFILE_HITCH_MAX_FRAMES = 240;
+const size_t PROFILE_HITCH_MAX_EVENTS_PER_FRAME = 1 << 16;
+
+// a counter event is followed by one more slot holding its value
+enum ProfileEventType { PROFILE_EVENT_BEGIN = 0 , PROFILE_EVENT_END , PROFILE_EVENT_COUNTER , PROFILE_EVENT_FRAME , PROFILE_EVENT_ALLOCATIONS };
+
+// a begin / end with this bit set is followed by the hardware counter values , two per slot
+const unsigned int PROFILE_EVENT_HARDWARE_COUNTERS = 0x100;
+const size_t PROFILE_HARDWARE_COUNTER_SLOTS = (PERFORMANCE_COUNTER_COUNT + 1) / 2;
+
+
+// One per PROFILE_SCOPE site , registered the first time the site runs.
+struct ProfileScopeDescriptor
+{
+	const char* m_name;
+	const char* m_file;
+	int m_line;
+};
+
+
+struct ProfileEvent
+{
+	unsigned long long m_ticks;
+	unsigned int m_scopeId;
+	unsigned int m_type;
+};
+
+
+// Single producer single consumer ring , the owning thread writes and the collector reads.
+// When the collector falls behind new events are dropped and counted rather than blocking the thread.
+struct ProfileThreadBuffer
+{
+	ProfileEvent m_events[PROFILE_RING_CAPACITY];
+	std::atomic<size_t> m_writeIndex;
+	std::atomic<size_t> m_readIndex;
+	std::atomic<size_t> m_droppedEvents;
+	std::atomic<bool> m_inUse;
+	unsigned int m_threadIndex;
+	char m_threadName[PROFILE_THREAD_NAME_SIZE];
+	ProfileThreadBuffer* m_next;
+};
+
+
+// Aggregated call tree node , one per distinct path of scopes on a thread.
+struct ProfileNode
+{
+	unsigned int m_scopeId;
+	int m_parent;
+	int m_firstChild;
+	int m_nextSibling;
+	int m_depth;
+	unsigned int m_callsThisFrame;
+	unsigned long long m_ticksThisFrame;
+	unsigned int m_callsLastFrame;
+	unsigned long long m_ticksLastFrame;
+	unsigned long long m_totalCalls;
+	unsigned long long m_totalTicks;
+	unsigned int m_framesActive;
+	unsigned int m_counterCallsThisFrame;
+	unsigned int m_counterCallsLastFrame;
+	unsigned long long m_countersThisFrame[PERFORMANCE_COUNTER_COUNT];
+	unsigned long long m_countersLastFrame[PERFORMANCE_COUNTER_COUNT];
+	unsigned int m_allocationsThisFrame;			// made directly in the scope , not in its children
+	unsigned long long m_allocatedBytesThisFrame;
+	unsigned int m_allocationsLastFrame;
+	unsigned long long m_allocatedBytesLastFrame;
+};
+
+
+// Allocations made on a thread since its last scope event , they belong to the scope open at that point.
+struct ProfileThreadAllocations
+{
+	unsigned int m_count;
+	unsigned long long m_bytes;
+};
+
+
+// Raw event kept while a capture is running , frame events carry the frame time in milliseconds.
+// End events carry the allocations made directly in the scope , m_value holds their bytes.
+struct ProfileCaptureEvent
+{
+	unsigned long long m_ticks;
+	unsigned int m_scopeId;
+	unsigned short m_type;
+	unsigned short m_threadIndex;
+	double m_value;
+	unsigned int m_allocations;
+};
+
+
+// One frame kept by the hitch detector , the vectors are reused when the slot comes around again.
+struct ProfileHistoryFrame
+{
+	unsigned long long m_beginTicks;
+	std::vector<ProfileCaptureEvent> m_openScopes;		// begins of the scopes that were open when the frame started
+	std::vector<ProfileCaptureEvent> m_events;
+};
+
+
+// Rolling statistics of a scope's time per frame , over the frames of the window it ran in.
+struct ProfileScopeStatistics
+{
+	unsigned int m_numberOfSamples;
+	double m_p50;
+	double m_p95;
+	double m_p99;
+	double m_max;
+	double m_budget;
+	unsigned int m_numberOfFramesOverBudget;
+};
+
+
+struct ProfileOpenScope
+{
+	int m_node;
+	unsigned int m_scopeId;
+	unsigned long long m_beginTicks;
+	bool m_hasCounters;
+	unsigned long long m_beginCounters[PERFORMANCE_COUNTER_COUNT];
+	unsigned int m_allocations;
+	unsigned long long m_allocatedBytes;
+};
+
+
+struct ProfileThreadTree
+{
+	ProfileThreadBuffer* m_buffer;
+	std::vector<ProfileNode> m_nodes;				// node 0 is the thread root
+	std::vector<ProfileOpenScope> m_openScopes;
+	size_t m_droppedEventsLastFrame;
+};
+
+
+// Instrumenting profiler. PROFILE_SCOPE pushes a begin and an end event with a raw tick count into
+// the calling thread's ring , nothing is allocated or locked on that path once the thread's ring exists.
+// EndFrame , called once per frame by the main loop , drains every ring and folds the events into a
+// call tree per thread , the finished frame stays readable until the next EndFrame.
+class Profiler
+{
+public:
+	static unsigned int RegisterScope(const char* name, const char* file, int line);
+	static unsigned int RegisterDynamicScope(const char* name);
+	static const ProfileScopeDescriptor& GetScope(unsigned int scopeId) { return s_scopes[scopeId]; };
+	static size_t GetNumberOfScopes() { return s_numberOfScopes.load(std::memory_order_acquire); };
+	static unsigned int FindScope(const char* name);
+	static void SetThreadName(const char* name);
+
+	static inline unsigned long long GetTicks() { return Timebase::GetTicks(); };
+	static double TicksToSeconds(unsigned long long ticks) { return Timebase::TicksToSeconds(ticks); };
+	static inline void BeginScope(unsigned int scopeId) { if (s_hardwareCounters) PushEventWithCounters(scopeId, PROFILE_EVENT_BEGIN); else PushEvent(scopeId, PROFILE_EVENT_BEGIN); };
+	static inline void EndScope(unsigned int scopeId) { if (s_hardwareCounters) PushEventWithCounters(scopeId, PROFILE_EVENT_END); else PushEvent(scopeId, PROFILE_EVENT_END); };
+	static inline void SetCounter(unsigned int counterId, double value) { PushCounter(counterId, value); };
+	static double GetCounterValue(unsigned int counterId) { return s_counterValues[counterId]; };
+
+	static void EndFrame();
+	static void Reset();
+	static size_t GetNumberOfThreads() { return s_threadTrees.size(); };
+	static const ProfileThreadTree* GetThreadTree(size_t index) { return s_threadTrees[index]; };	// null until the thread's buffer was drained once
+	static unsigned long long GetLastFrameTicks() { return s_lastFrameTicks; };
+	static unsigned long long GetFrameNumber() { return s_frameNumber; };
+
+	// Time per frame of every scope , summed over threads and call paths , goes into a rolling histogram.
+	// PROFILE_ROOT_SCOPE holds the frame time itself. A budget of 0 turns over budget counting off.
+	static void SetScopeBudget(unsigned int scopeId, double budgetSeconds) { s_scopeBudgets[scopeId] = budgetSeconds; };
+	static void SetFrameBudget(double budgetSeconds) { s_scopeBudgets[PROFILE_ROOT_SCOPE] = budgetSeconds; };
+	static bool GetScopeStatistics(unsigned int scopeId, ProfileScopeStatistics& statistics);
+	static const ProfileHistogram* GetScopeHistogram(unsigned int scopeId) { return s_scopeHistograms[scopeId]; };
+
+	// Records every event for numberOfFrames frames , starting startAfterFrames frames from now , then writes
+	// them to filePath as Chrome trace_event JSON. numberOfFrames 0 keeps recording until StopCapture.
+	static bool StartCapture(const char* filePath, unsigned int numberOfFrames, unsigned int startAfterFrames = 0);
+	static bool StopCapture();
+	static bool IsCapturing() { return s_capturePending || s_capturing; };
+	static size_t GetNumberOfCapturedEvents() { return s_captureEvents.size(); };
+
+	// Keeps the events of the last numberOfFrames frames , plus the per frame change of every metric counter
+	// and the value of every gauge. A frame longer than the frame budget writes that window as a Chrome trace
+	// to <filePrefix>_<frame>.json , after which a full window has to pass before the next one is written.
+	// EndFrame only copies the window , a worker thread writes it. Disabling waits for queued writes.
+	static bool EnableHitchDetector(const char* filePrefix, unsigned int numberOfFrames = PROFILE_HITCH_DEFAULT_FRAMES);
+	static void DisableHitchDetector();
+	static bool IsHitchDetectorEnabled() { return !s_history.empty(); };
+	static unsigned int GetNumberOfHitches() { return s_numberOfHitches; };
+	static const char* GetLastHitchPath() { return s_lastHitchPath; };
+
+public:
+	static bool s_enabled;
+
+	// Off by default , every scope then costs two extra syscalls. Returns false when the calling
+	// thread can't open the counters , in which case they stay off.
+	static bool EnableHardwareCounters(bool enable);
+	static bool AreHardwareCountersEnabled() { return s_hardwareCounters; };
+
+	// Off by default. The global allocator calls RecordAllocation , the count and bytes go to the scope
+	// open on the calling thread and show up next to its time in the call tree and in captures.
+	// Only the HENRY_MEMORY_OVERRIDE_NEW hooks call it , without them tracking stays off and this returns false.
+	static bool EnableAllocationTracking(bool enable)
+	{
+#if defined(HENRY_MEMORY_OVERRIDE_NEW)
+		s_allocationTracking = enable;
+#else
+		UNUSED(enable);
+		s_allocationTracking = false;
+#endif
+		return s_allocationTracking;
+	};
+	static bool IsAllocationTrackingEnabled() { return s_allocationTracking; };
+	static inline void RecordAllocation(size_t sizeInBytes)
+	{
+		if (!s_allocationTracking)
+			return;
+
+		++s_threadAllocations.m_count;
+		s_threadAllocations.m_bytes += sizeInBytes;
+	};
+
+private:
+	static inline void PushEvent(unsigned int scopeId, ProfileEventType type)
+	{
+		if (!s_enabled)
+			return;
+
+		ProfileThreadBuffer* buffer = s_threadBuffer;
+		if (buffer == nullptr)
+			buffer = CreateThreadBuffer();
+		if (s_threadAllocations.m_count != 0)
+			PushAllocations(buffer);
+
+		size_t writeIndex = buffer->m_writeIndex.load(std::memory_order_relaxed);
+		if (writeIndex - buffer->m_readIndex.load(std::memory_order_acquire) >= PROFILE_RING_CAPACITY)
+		{
+			buffer->m_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		ProfileEvent& profileEvent = buffer->m_events[writeIndex & (PROFILE_RING_CAPACITY - 1)];
+		profileEvent.m_ticks = GetTicks();
+		profileEvent.m_scopeId = scopeId;
+		profileEvent.m_type = type;
+		buffer->m_writeIndex.store(writeIndex + 1, std::memory_order_release);
+	};
+
+	static inline void PushCounter(unsigned int counterId, double value)
+	{
+		if (!s_enabled)
+			return;
+
+		ProfileThreadBuffer* buffer = s_threadBuffer;
+		if (buffer == nullptr)
+			buffer = CreateThreadBuffer();
+
+		size_t writeIndex = buffer->m_writeIndex.load(std::memory_order_relaxed);
+		if (writeIndex + 2 - buffer->m_readIndex.load(std::memory_order_acquire) > PROFILE_RING_CAPACITY)
+		{
+			buffer->m_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		ProfileEvent& profileEvent = buffer->m_events[writeIndex & (PROFILE_RING_CAPACITY - 1)];
+		profileEvent.m_ticks = GetTicks();
+		profileEvent.m_scopeId = counterId;
+		profileEvent.m_type = PROFILE_EVENT_COUNTER;
+		memcpy(&buffer->m_events[(writeIndex + 1) & (PROFILE_RING_CAPACITY - 1)].m_ticks, &value, sizeof(value));
+		buffer->m_writeIndex.store(writeIndex + 2, std::memory_order_release);
+	};
+
+	static void PushEventWithCounters(unsigned int scopeId, ProfileEventType type);
+	static void PushAllocations(ProfileThreadBuffer* buffer);
+	static ProfileThreadBuffer* CreateThreadBuffer();
+	static void DrainThreadBuffer(ProfileThreadTree& tree);
+	static int FindOrAddChild(ProfileThreadTree& tree, int parent, unsigned int scopeId);
+	static void CaptureOpenScopes(ProfileEventType type, unsigned long long ticks);
+	static void CaptureEvent(unsigned long long ticks, unsigned int scopeId, ProfileEventType type, unsigned int threadIndex, double value, unsigned int allocations = 0);
+	static bool FinishCapture();
+	static void UpdateScopeHistograms();
+	static void RecordHistoryEvent(unsigned long long ticks, unsigned int scopeId, ProfileEventType type, unsigned int threadIndex, double value, unsigned int allocations = 0);
+	static void EndHistoryFrame(unsigned long long frameEndTicks);
+	static void QueueHitch(unsigned long long frameEndTicks);
+
+	static ProfileScopeDescriptor s_scopes[PROFILE_MAX_SCOPES];
+	static std::atomic<size_t> s_numberOfScopes;
+	static std::atomic<ProfileThreadBuffer*> s_firstBuffer;
+	static std::atomic<unsigned int> s_numberOfBuffers;
+	static thread_local ProfileThreadBuffer* s_threadBuffer;
+	static thread_local ProfileThreadAllocations s_threadAllocations;
+	static std::vector<ProfileThreadTree*> s_threadTrees;
+	static unsigned long long s_frameBeginTicks;
+	static unsigned long long s_lastFrameTicks;
+	static unsigned long long s_frameNumber;
+	static double s_counterValues[PROFILE_MAX_SCOPES];
+	static ProfileHistogram* s_scopeHistograms[PROFILE_MAX_SCOPES];
+	static double s_scopeBudgets[PROFILE_MAX_SCOPES];
+	static unsigned long long s_scopeTicksThisFrame[PROFILE_MAX_SCOPES];
+	static std::vector<unsigned int> s_scopesThisFrame;
+	static std::vector<ProfileCaptureEvent> s_captureEvents;
+	static char s_capturePath[260];
+	static unsigned long long s_captureBeginTicks;
+	static unsigned int s_captureFramesLeft;
+	static unsigned int s_captureDelayFrames;
+	static bool s_capturePending;
+	static bool s_capturing;
+	static std::vector<ProfileHistoryFrame> s_history;
+	static size_t s_historyIndex;
+	static size_t s_historyFramesRecorded;
+	static std::vector<unsigned int> s_historyMetricScopes;
+	static std::vector<long long> s_historyMetricTotals;
+	static char s_hitchPrefix[260];
+	static char s_lastHitchPath[280];
+	static unsigned long long s_nextHitchFrame;
+	static unsigned int s_numberOfHitches;
+	static bool s_hardwareCounters;
+	static bool s_allocationTracking;
+};
+
+
+class ProfileScope
+{
+public:
+	ProfileScope(unsigned int scopeId) : m_scopeId(scopeId) { Profiler::BeginScope(scopeId); };
+	~ProfileScope() { Profiler::EndScope(m_scopeId); };
+
+private:
+	unsigned int m_scopeId;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if defined(HENRY_DISABLE_PROFILER)
+#define PROFILE_SCOPE(name)
+#else
+#define PROFILE_SCOPE(name) \
+	static const unsigned int PROFILE_CONCAT(s_profileScope, __LINE__) = Henry::Profiler::RegisterScope(name, __FILE__, __LINE__); \
+	Henry::ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(s_profileScope, __LINE__))
+#endif
+
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+
+#if defined(HENRY_DISABLE_PROFILER)
+#define PROFILE_COUNTER(name, value)
+#else
+#define PROFILE_COUNTER(name, value) \
+	do { static const unsigned int s_profileCounter = Henry::Profiler::RegisterScope(name, __FILE__, __LINE__); Henry::Profiler::SetCounter(s_profileCounter, (double)(value)); } while (0)
+#endif
+
+};
+
+#endif
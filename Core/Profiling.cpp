@@ -2,112 +2,69 @@
 
 #include "Engine\Renderer\OpenGLRenderer.hpp"
 #include "Engine\Core\HenryFunctions.hpp"
-#include "Engine\Core\Time.hpp"
 
 
 namespace Henry
 {
 
-std::stack<Profiling*> Profiling::s_profilingStack;
-std::map<std::string,Profiling*> Profiling::s_profilingMap;
+const int PROFILING_MAX_DEPTH = 64;
+const size_t PROFILING_SCOPE_CACHE_SIZE = 256;		// power of two
+
 bool Profiling::s_display = true;
 
-Profiling::Profiling(const std::string& name) 
-	: m_name(name)
-	, m_layer(0)
-	, m_stopTime(-1.0)
-	, m_frameCount(0)
-	, m_lifeTime(0.0)
-	, m_parent(nullptr)
+struct ProfilingStack
 {
-	m_startTime = GetCurrentTimeSeconds();
-}
+	unsigned int m_scopeIds[PROFILING_MAX_DEPTH];
+	int m_depth;
+};
 
+static thread_local ProfilingStack s_profilingStack;
 
-Profiling::~Profiling(void)
-{
-}
+// Per thread , direct mapped on the name's hash. 0 is the root scope and means empty , a hit is
+// checked against the registered name so collisions only cost a registry lookup.
+static thread_local unsigned int s_scopeCache[PROFILING_SCOPE_CACHE_SIZE];
 
 
-void Profiling::Start(const std::string& name)
+static unsigned int FindCachedScope(const std::string& name)
 {
-	Profiling* _profiling;
-
-	if(s_profilingMap[name])
-	{
-		_profiling = s_profilingMap[name];
-		_profiling->m_startTime = GetCurrentTimeSeconds();
-		_profiling->m_stopTime = -1.0;
-	}
-	else
-	{
-		_profiling = new Profiling(name);
+	size_t hash = 2166136261u;
+	for (size_t index = 0; index < name.size(); ++index)
+		hash = (hash ^ (unsigned char)name[index]) * 16777619u;
 
-		if(s_profilingStack.size() != 0)
-		{
-			s_profilingStack.top()->AppendProfiling(_profiling);
-		}
+	unsigned int& cachedScopeId = s_scopeCache[hash & (PROFILING_SCOPE_CACHE_SIZE - 1)];
+	if (cachedScopeId != PROFILE_ROOT_SCOPE && name == Profiler::GetScope(cachedScopeId).m_name)
+		return cachedScopeId;
 
-		s_profilingMap[name] = _profiling;
-	}
-
-	++_profiling->m_frameCount;
-	s_profilingStack.push(_profiling);
+	cachedScopeId = Profiler::RegisterDynamicScope(name.c_str());
+	return cachedScopeId;
 }
 
 
-void Profiling::Stop()
+// Only the first Start of a name on each thread takes the registry lock.
+void Profiling::Start(const std::string& name)
 {
-	Profiling* _profiling = s_profilingStack.top();
-	s_profilingStack.pop();
-	_profiling->m_stopTime = GetCurrentTimeSeconds();
-	_profiling->m_lifeTime += _profiling->GetElapsedTime();
+	unsigned int scopeId = FindCachedScope(name);
+	if (s_profilingStack.m_depth < PROFILING_MAX_DEPTH)
+		s_profilingStack.m_scopeIds[s_profilingStack.m_depth] = scopeId;
+	++s_profilingStack.m_depth;
+	Profiler::BeginScope(scopeId);
 }
 
 
-double Profiling::GetElapsedTime()
+void Profiling::Stop()
 {
-	if(m_stopTime != -1.0)
-		return m_stopTime - m_startTime;
-	return GetCurrentTimeSeconds() - m_startTime;
-}
-
+	if (s_profilingStack.m_depth == 0)
+		return;
 
-void Profiling::AppendProfiling(Profiling* _profiling)
-{
-	_profiling->m_parent = this;
-	_profiling->m_layer = m_layer + 1;
-	m_subProfiling.push_back(_profiling);
+	--s_profilingStack.m_depth;
+	if (s_profilingStack.m_depth < PROFILING_MAX_DEPTH)
+		Profiler::EndScope(s_profilingStack.m_scopeIds[s_profilingStack.m_depth]);
 }
 
 
 void Profiling::RemoveAllProfiling()
 {
-	std::map<std::string,Profiling*>::iterator it = s_profilingMap.begin();
-	while( it != s_profilingMap.end() )
-	{
-		Profiling* currentProfiling = it->second;
-		it = s_profilingMap.erase(it);
-		delete currentProfiling;
-		currentProfiling = nullptr;
-	}
-}
-
-
-double Profiling::GetAverageTime()
-{
-	return m_lifeTime / m_frameCount;
-}
-
-
-double Profiling::GetPercentage()
-{
-	if(m_layer != 0 && m_parent)
-	{
-		return GetElapsedTime() / m_parent->GetElapsedTime();
-	}
-
-	return 1.0;
+	Profiler::Reset();
 }
 
 
@@ -117,20 +74,73 @@ void Profiling::Render(BitmapFont* font)
 		return;
 
 	Vec2f position( 0.0f , 850.0f );
-	std::map<std::string,Profiling*>::iterator it = s_profilingMap.begin();
-	while( it != s_profilingMap.end() )
+	double frameTime = Profiler::TicksToSeconds(Profiler::GetLastFrameTicks());
+	for (size_t threadIndex = 0; threadIndex < Profiler::GetNumberOfThreads(); ++threadIndex)
 	{
-		Profiling* _profiling = it->second;
-		position.x = 650.0f + _profiling->m_layer * 50.0f;
-
-		std::string msg;
-		msg = _profiling->m_name + " -> %.4lf%% , Total Time : %lf , Average Time : %lf" ;
-		font->Draw( msg.c_str() , position , 30 , RGBA() , OpenGLRenderer::WINDOW_SIZE , _profiling->GetPercentage() , _profiling->GetElapsedTime() , _profiling->GetAverageTime() );
+		const ProfileThreadTree* threadTree = Profiler::GetThreadTree(threadIndex);
+		if (!threadTree || threadTree->m_nodes[0].m_firstChild < 0)
+			continue;
+
+		const ProfileThreadTree& tree = *threadTree;
+
+		ProfileScopeStatistics statistics;
+		memset(&statistics, 0, sizeof(statistics));
+		Profiler::GetScopeStatistics(PROFILE_ROOT_SCOPE, statistics);
+		position.x = 650.0f;
+		font->Draw( "%s -> Frame : %.3lf ms , p50 : %.3lf ms , p99 : %.3lf ms , Max : %.3lf ms , Over Budget : %d , Dropped : %d" , position , 30 , RGBA() , OpenGLRenderer::WINDOW_SIZE ,
+			tree.m_buffer->m_threadName , frameTime * 1000.0 , statistics.m_p50 * 1000.0 , statistics.m_p99 * 1000.0 , statistics.m_max * 1000.0 , (int)statistics.m_numberOfFramesOverBudget , (int)tree.m_droppedEventsLastFrame );
 		position += Vec2f( 0.0f, -50.0f );
 
-		++it;
+		// depth first , children follow their parent
+		int nodeIndex = tree.m_nodes[0].m_firstChild;
+		while (nodeIndex > 0)
+		{
+			const ProfileNode& node = tree.m_nodes[nodeIndex];
+			const ProfileNode& parent = tree.m_nodes[node.m_parent];
+			double elapsedTime = Profiler::TicksToSeconds(node.m_ticksLastFrame);
+			double parentTime = Profiler::TicksToSeconds(parent.m_ticksLastFrame);
+			double averageTime = node.m_framesActive ? Profiler::TicksToSeconds(node.m_totalTicks) / node.m_framesActive : 0.0;
+			double percentage = parentTime > 0.0 ? elapsedTime / parentTime * 100.0 : 100.0;
+			memset(&statistics, 0, sizeof(statistics));
+			Profiler::GetScopeStatistics(node.m_scopeId, statistics);
+
+			position.x = 650.0f + node.m_depth * 50.0f;
+			std::string msg;
+			msg = std::string(Profiler::GetScope(node.m_scopeId).m_name) + " -> %.4lf%% , Time : %.3lf ms , Calls : %d , Average Time : %.3lf ms , p95 : %.3lf ms , p99 : %.3lf ms , Max : %.3lf ms , Over Budget : %d" ;
+			font->Draw( msg.c_str() , position , 30 , RGBA() , OpenGLRenderer::WINDOW_SIZE , percentage , elapsedTime * 1000.0 , (int)node.m_callsLastFrame , averageTime * 1000.0 ,
+				statistics.m_p95 * 1000.0 , statistics.m_p99 * 1000.0 , statistics.m_max * 1000.0 , (int)statistics.m_numberOfFramesOverBudget );
+			position += Vec2f( 0.0f, -50.0f );
+
+			if (node.m_counterCallsLastFrame)
+			{
+				const unsigned long long* counters = node.m_countersLastFrame;
+				double calls = (double)node.m_counterCallsLastFrame;
+				double instructionsPerCycle = counters[PERFORMANCE_COUNTER_CYCLES] ? (double)counters[PERFORMANCE_COUNTER_INSTRUCTIONS] / counters[PERFORMANCE_COUNTER_CYCLES] : 0.0;
+				font->Draw( "IPC : %.2lf , L1D Misses / Call : %.1lf , LLC Misses / Call : %.1lf , Branch Misses / Call : %.1lf" , position , 30 , RGBA() , OpenGLRenderer::WINDOW_SIZE , instructionsPerCycle ,
+					counters[PERFORMANCE_COUNTER_L1D_MISSES] / calls , counters[PERFORMANCE_COUNTER_LLC_MISSES] / calls , counters[PERFORMANCE_COUNTER_BRANCH_MISSES] / calls );
+				position += Vec2f( 0.0f, -50.0f );
+			}
+
+			if (node.m_allocationsLastFrame)
+			{
+				font->Draw( "Allocations : %d , Allocated : %.1lf KB , Bytes / Allocation : %.0lf" , position , 30 , RGBA() , OpenGLRenderer::WINDOW_SIZE , (int)node.m_allocationsLastFrame ,
+					node.m_allocatedBytesLastFrame / 1024.0 , (double)node.m_allocatedBytesLastFrame / node.m_allocationsLastFrame );
+				position += Vec2f( 0.0f, -50.0f );
+			}
+
+			if (node.m_firstChild > 0)
+			{
+				nodeIndex = node.m_firstChild;
+				continue;
+			}
+
+			while (nodeIndex > 0 && tree.m_nodes[nodeIndex].m_nextSibling < 0)
+				nodeIndex = tree.m_nodes[nodeIndex].m_parent;
+			if (nodeIndex > 0)
+				nodeIndex = tree.m_nodes[nodeIndex].m_nextSibling;
+		}
 	}
 }
 
 
-};
\ No newline at end of file
+};
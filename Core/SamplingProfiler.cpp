@@ -0,0 +1,491 @@
+#include "SamplingProfiler.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+
+#if defined(__linux__)
+#include <cxxabi.h>
+#include <errno.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+#endif
+
+
+namespace Henry
+{
+
+ProfileSample* SamplingProfiler::s_samples = nullptr;
+std::atomic<size_t> SamplingProfiler::s_numberOfSamples(0);
+std::atomic<size_t> SamplingProfiler::s_numberOfDroppedSamples(0);
+unsigned int SamplingProfiler::s_frequency = SAMPLING_DEFAULT_FREQUENCY;
+bool SamplingProfiler::s_running = false;
+char SamplingProfiler::s_outputPath[260] = { 0 };
+
+
+size_t SamplingProfiler::GetNumberOfSamples()
+{
+	size_t numberOfSamples = s_numberOfSamples.load(std::memory_order_acquire);
+	return numberOfSamples < SAMPLING_MAX_SAMPLES ? numberOfSamples : SAMPLING_MAX_SAMPLES;
+}
+
+
+#if defined(__linux__)
+
+struct SamplingThread
+{
+	bool m_used;
+	bool m_hasTimer;
+	timer_t m_timer;
+	uintptr_t m_stackHigh;		// 0 when unknown , only the interrupted pc is sampled then
+	char m_name[SAMPLING_THREAD_NAME_SIZE];
+};
+
+static SamplingThread s_threads[SAMPLING_MAX_THREADS];
+static thread_local int s_samplingThreadIndex = -1;
+
+
+static std::mutex& GetThreadLock()
+{
+	static std::mutex s_lock;
+	return s_lock;
+}
+
+
+// frees the thread's slot and timer when it exits
+struct SamplingThreadOwner
+{
+	SamplingThreadOwner() : m_threadIndex(-1) {};
+	~SamplingThreadOwner()
+	{
+		if (m_threadIndex < 0)
+			return;
+
+		std::lock_guard<std::mutex> guard(GetThreadLock());
+		if (s_threads[m_threadIndex].m_hasTimer)
+			timer_delete(s_threads[m_threadIndex].m_timer);
+		s_threads[m_threadIndex].m_hasTimer = false;
+		s_threads[m_threadIndex].m_used = false;
+		s_samplingThreadIndex = -1;
+	};
+	int m_threadIndex;
+};
+
+
+// Starts from the registers the signal interrupted , so none of the handler's own frames are walked
+// whether or not anything got inlined. Every frame pointer is checked to be aligned , above the
+// previous one and under the top of the thread's stack before it is read , a bad one ends the walk.
+static __attribute__((noinline)) size_t WalkFramePointers(const ucontext_t* context, uintptr_t stackHigh, void** frames, size_t maxFrames)
+{
+#if defined(__x86_64__)
+	void* programCounter = (void*)context->uc_mcontext.gregs[REG_RIP];
+	uintptr_t framePointer = (uintptr_t)context->uc_mcontext.gregs[REG_RBP];
+	uintptr_t stackPointer = (uintptr_t)context->uc_mcontext.gregs[REG_RSP];
+#elif defined(__i386__)
+	void* programCounter = (void*)context->uc_mcontext.gregs[REG_EIP];
+	uintptr_t framePointer = (uintptr_t)context->uc_mcontext.gregs[REG_EBP];
+	uintptr_t stackPointer = (uintptr_t)context->uc_mcontext.gregs[REG_ESP];
+#elif defined(__aarch64__)
+	void* programCounter = (void*)context->uc_mcontext.pc;
+	uintptr_t framePointer = (uintptr_t)context->uc_mcontext.regs[29];
+	uintptr_t stackPointer = (uintptr_t)context->uc_mcontext.sp;
+#else
+	(void)context;
+	(void)stackHigh;
+	(void)frames;
+	(void)maxFrames;
+	return 0;
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+	size_t numberOfFrames = 0;
+	frames[numberOfFrames++] = programCounter;
+
+	// each frame holds the caller's frame pointer and then the return address
+	uintptr_t lowestFramePointer = stackPointer;
+	while (numberOfFrames < maxFrames && framePointer >= lowestFramePointer && framePointer % sizeof(void*) == 0
+		&& framePointer + 2 * sizeof(void*) <= stackHigh)
+	{
+		const uintptr_t* frame = (const uintptr_t*)framePointer;
+		if (frame[1] == 0)
+			break;
+
+		frames[numberOfFrames++] = (void*)frame[1];
+		lowestFramePointer = framePointer + 2 * sizeof(void*);
+		framePointer = frame[0];
+	}
+	return numberOfFrames;
+#endif
+}
+
+
+void SamplingProfiler::RecordSample(void* signalContext)
+{
+	size_t sampleIndex = s_numberOfSamples.fetch_add(1, std::memory_order_relaxed);
+	if (sampleIndex >= SAMPLING_MAX_SAMPLES)
+	{
+		s_numberOfDroppedSamples.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	ProfileSample& sample = s_samples[sampleIndex];
+	sample.m_numberOfFrames = (unsigned int)WalkFramePointers((const ucontext_t*)signalContext, s_threads[s_samplingThreadIndex].m_stackHigh, sample.m_frames, SAMPLING_MAX_FRAMES);
+	sample.m_threadIndex = (unsigned int)s_samplingThreadIndex;
+	sample.m_ready.store(1, std::memory_order_release);
+}
+
+
+static void SamplingSignalHandler(int signalNumber, siginfo_t* info, void* context)
+{
+	(void)signalNumber;
+	(void)info;
+
+	if (s_samplingThreadIndex < 0)
+		return;
+
+	int savedErrno = errno;
+	SamplingProfiler::RecordSample(context);
+	errno = savedErrno;
+}
+
+
+void SamplingProfiler::ArmThreadTimer(size_t threadIndex, unsigned int frequency)
+{
+	if (!s_threads[threadIndex].m_hasTimer)
+		return;
+
+	long long interval = frequency ? 1000000000ll / frequency : 0;
+	struct itimerspec timerSpec;
+	timerSpec.it_interval.tv_sec = (time_t)(interval / 1000000000ll);
+	timerSpec.it_interval.tv_nsec = (long)(interval % 1000000000ll);
+	timerSpec.it_value = timerSpec.it_interval;
+	timer_settime(s_threads[threadIndex].m_timer, 0, &timerSpec, nullptr);
+}
+
+
+// Counts only the calling thread's CPU time and signals only that thread.
+bool SamplingProfiler::CreateThreadTimer(size_t threadIndex)
+{
+	SamplingThread& thread = s_threads[threadIndex];
+	struct sigevent signalEvent;
+	memset(&signalEvent, 0, sizeof(signalEvent));
+	signalEvent.sigev_notify = SIGEV_THREAD_ID;
+	signalEvent.sigev_signo = SIGPROF;
+	signalEvent.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+	thread.m_hasTimer = timer_create(CLOCK_THREAD_CPUTIME_ID, &signalEvent, &thread.m_timer) == 0;
+	return thread.m_hasTimer;
+}
+
+
+// The child of a fork inherits neither the timers nor the other threads , only the forking thread
+// is sampled again and the child starts with no samples of its own.
+void SamplingProfiler::RestartInChild()
+{
+	if (!s_running)
+		return;
+
+	// another thread of the parent may have held the lock at the fork
+	new (&GetThreadLock()) std::mutex();
+	for (size_t threadIndex = 0; threadIndex < SAMPLING_MAX_THREADS; ++threadIndex)
+	{
+		s_threads[threadIndex].m_hasTimer = false;
+		if ((int)threadIndex != s_samplingThreadIndex)
+			s_threads[threadIndex].m_used = false;
+	}
+
+	for (size_t sampleIndex = 0; sampleIndex < SAMPLING_MAX_SAMPLES; ++sampleIndex)
+		s_samples[sampleIndex].m_ready.store(0, std::memory_order_relaxed);
+	s_numberOfSamples.store(0, std::memory_order_release);
+	s_numberOfDroppedSamples.store(0, std::memory_order_relaxed);
+
+	if (s_samplingThreadIndex >= 0 && CreateThreadTimer(s_samplingThreadIndex))
+		ArmThreadTimer(s_samplingThreadIndex, s_frequency);
+}
+
+
+// Stops a forked child's sampling and merges its stacks into the output file , call it before _exit.
+void SamplingProfiler::FinishChildProcess()
+{
+	if (!s_running)
+		return;
+
+	Stop();
+	if (s_outputPath[0] != '\0')
+		WriteFoldedStacks(s_outputPath, true);
+}
+
+
+void SamplingProfiler::SetOutputPath(const char* filePath)
+{
+	snprintf(s_outputPath, sizeof(s_outputPath), "%s", filePath ? filePath : "");
+}
+
+
+bool SamplingProfiler::RegisterCurrentThread(const char* name)
+{
+	static thread_local SamplingThreadOwner s_owner;
+	std::lock_guard<std::mutex> guard(GetThreadLock());
+	if (s_owner.m_threadIndex < 0)
+	{
+		for (size_t threadIndex = 0; threadIndex < SAMPLING_MAX_THREADS; ++threadIndex)
+		{
+			if (!s_threads[threadIndex].m_used)
+			{
+				s_owner.m_threadIndex = (int)threadIndex;
+				break;
+			}
+		}
+		if (s_owner.m_threadIndex < 0)
+			return false;
+
+		SamplingThread& thread = s_threads[s_owner.m_threadIndex];
+		thread.m_used = true;
+		snprintf(thread.m_name, sizeof(thread.m_name), "Thread %d", s_owner.m_threadIndex);
+
+		// the stack bounds are read here , the handler can't ask for them
+		thread.m_stackHigh = 0;
+		pthread_attr_t attributes;
+		if (pthread_getattr_np(pthread_self(), &attributes) == 0)
+		{
+			void* stackLow = nullptr;
+			size_t stackSize = 0;
+			if (pthread_attr_getstack(&attributes, &stackLow, &stackSize) == 0)
+				thread.m_stackHigh = (uintptr_t)stackLow + stackSize;
+			pthread_attr_destroy(&attributes);
+		}
+
+		CreateThreadTimer(s_owner.m_threadIndex);
+		s_samplingThreadIndex = s_owner.m_threadIndex;
+	}
+
+	SamplingThread& thread = s_threads[s_owner.m_threadIndex];
+	if (name)
+		snprintf(thread.m_name, sizeof(thread.m_name), "%s", name);
+	if (s_running)
+		ArmThreadTimer(s_owner.m_threadIndex, s_frequency);
+	return thread.m_hasTimer;
+}
+
+
+bool SamplingProfiler::Start(unsigned int frequency)
+{
+	if (s_running || frequency == 0)
+		return false;
+
+	if (s_samples == nullptr)
+	{
+		s_samples = (ProfileSample*)malloc(sizeof(ProfileSample) * SAMPLING_MAX_SAMPLES);
+		if (s_samples == nullptr)
+			return false;
+	}
+
+	static bool s_forkHandlerInstalled = false;
+	if (!s_forkHandlerInstalled)
+		s_forkHandlerInstalled = pthread_atfork(nullptr, nullptr, &SamplingProfiler::RestartInChild) == 0;
+
+	for (size_t sampleIndex = 0; sampleIndex < SAMPLING_MAX_SAMPLES; ++sampleIndex)
+		s_samples[sampleIndex].m_ready.store(0, std::memory_order_relaxed);
+	s_numberOfSamples.store(0, std::memory_order_release);
+	s_numberOfDroppedSamples.store(0, std::memory_order_relaxed);
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_sigaction = SamplingSignalHandler;
+	action.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	if (sigaction(SIGPROF, &action, nullptr) != 0)
+		return false;
+
+	s_frequency = frequency;
+	s_running = true;
+	RegisterCurrentThread();
+
+	std::lock_guard<std::mutex> guard(GetThreadLock());
+	for (size_t threadIndex = 0; threadIndex < SAMPLING_MAX_THREADS; ++threadIndex)
+	{
+		if (s_threads[threadIndex].m_used)
+			ArmThreadTimer(threadIndex, frequency);
+	}
+	return true;
+}
+
+
+void SamplingProfiler::Stop()
+{
+	if (!s_running)
+		return;
+
+	std::lock_guard<std::mutex> guard(GetThreadLock());
+	for (size_t threadIndex = 0; threadIndex < SAMPLING_MAX_THREADS; ++threadIndex)
+	{
+		if (s_threads[threadIndex].m_used)
+			ArmThreadTimer(threadIndex, 0);
+	}
+	s_running = false;
+}
+
+
+static const std::string& SymbolizeFrame(std::map<void*, std::string>& symbols, void* address)
+{
+	std::map<void*, std::string>::iterator found = symbols.find(address);
+	if (found != symbols.end())
+		return found->second;
+
+	char buffer[256];
+	Dl_info info;
+	if (dladdr(address, &info) && info.dli_sname)
+	{
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+		snprintf(buffer, sizeof(buffer), "%s", status == 0 && demangled ? demangled : info.dli_sname);
+		free(demangled);
+	}
+	else if (dladdr(address, &info) && info.dli_fname)
+	{
+		const char* moduleName = strrchr(info.dli_fname, '/');
+		snprintf(buffer, sizeof(buffer), "%s+0x%llx", moduleName ? moduleName + 1 : info.dli_fname, (unsigned long long)((char*)address - (char*)info.dli_fbase));
+	}
+	else
+	{
+		snprintf(buffer, sizeof(buffer), "0x%llx", (unsigned long long)(size_t)address);
+	}
+
+	// folded stacks use ';' between frames and ' ' before the count
+	for (char* character = buffer; *character; ++character)
+	{
+		if (*character == ';')
+			*character = ':';
+		else if (*character == '\n')
+			*character = ' ';
+	}
+	return symbols[address] = buffer;
+}
+
+
+// Adds the "stack count" lines already in the file , for merging the stacks of forked children.
+static void ReadFoldedStacks(const char* filePath, std::map<std::string, unsigned int>& stacks)
+{
+	FILE* file = fopen(filePath, "r");
+	if (file == nullptr)
+		return;
+
+	std::string line;
+	int character;
+	while ((character = fgetc(file)) != EOF)
+	{
+		if (character != '\n')
+		{
+			line += (char)character;
+			continue;
+		}
+
+		size_t countStart = line.rfind(' ');
+		if (countStart != std::string::npos)
+			stacks[line.substr(0, countStart)] += (unsigned int)strtoul(line.c_str() + countStart + 1, nullptr, 10);
+		line.clear();
+	}
+	fclose(file);
+}
+
+
+// merge keeps the stacks already in the file and adds these to them.
+bool SamplingProfiler::WriteFoldedStacks(const char* filePath, bool merge)
+{
+	if (s_samples == nullptr)
+		return false;
+
+	std::map<void*, std::string> symbols;
+	std::map<std::string, unsigned int> stacks;
+	if (merge)
+		ReadFoldedStacks(filePath, stacks);
+
+	FILE* file = fopen(filePath, "w");
+	if (file == nullptr)
+		return false;
+
+	size_t numberOfSamples = GetNumberOfSamples();
+	for (size_t sampleIndex = 0; sampleIndex < numberOfSamples; ++sampleIndex)
+	{
+		const ProfileSample& sample = s_samples[sampleIndex];
+		if (!sample.m_ready.load(std::memory_order_acquire))
+			continue;
+
+		// root first , return addresses step back into the call instruction so they resolve to the caller's line
+		std::string stack = s_threads[sample.m_threadIndex].m_name;
+		for (int frame = (int)sample.m_numberOfFrames - 1; frame >= 0; --frame)
+		{
+			void* address = frame == 0 ? sample.m_frames[frame] : (char*)sample.m_frames[frame] - 1;
+			stack += ';';
+			stack += SymbolizeFrame(symbols, address);
+		}
+		++stacks[stack];
+	}
+
+	for (std::map<std::string, unsigned int>::iterator it = stacks.begin(); it != stacks.end(); ++it)
+		fprintf(file, "%s %u\n", it->first.c_str(), it->second);
+
+	bool success = ferror(file) == 0;
+	fclose(file);
+	return success;
+}
+
+#else
+
+bool SamplingProfiler::Start(unsigned int frequency)
+{
+	(void)frequency;
+	return false;
+}
+
+
+void SamplingProfiler::Stop()
+{
+}
+
+
+bool SamplingProfiler::RegisterCurrentThread(const char* name)
+{
+	(void)name;
+	return false;
+}
+
+
+bool SamplingProfiler::WriteFoldedStacks(const char* filePath, bool merge)
+{
+	(void)filePath;
+	(void)merge;
+	return false;
+}
+
+
+void SamplingProfiler::SetOutputPath(const char* filePath)
+{
+#if defined(_MSC_VER)
+	sprintf_s(s_outputPath, sizeof(s_outputPath), "%s", filePath ? filePath : "");
+#else
+	snprintf(s_outputPath, sizeof(s_outputPath), "%s", filePath ? filePath : "");
+#endif
+}
+
+
+void SamplingProfiler::FinishChildProcess()
+{
+}
+
+#endif
+
+};
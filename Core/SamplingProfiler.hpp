@@ -0,0 +1,69 @@
+#pragma once
+
+#ifndef SAMPLINGPROFILER_HPP
+#define SAMPLINGPROFILER_HPP
+
+#include <stddef.h>
+#include <atomic>
+
+
+namespace Henry
+{
+
+const size_t SAMPLING_MAX_FRAMES = 64;
+const size_t SAMPLING_MAX_SAMPLES = 1 << 14;
+const size_t SAMPLING_MAX_THREADS = 64;
+const size_t SAMPLING_THREAD_NAME_SIZE = 32;
+const unsigned int SAMPLING_DEFAULT_FREQUENCY = 997;		// prime , so sampling doesn't lock step with frame rate timers
+
+
+struct ProfileSample
+{
+	std::atomic<unsigned int> m_ready;
+	unsigned int m_threadIndex;
+	unsigned int m_numberOfFrames;
+	void* m_frames[SAMPLING_MAX_FRAMES];
+};
+
+
+// Statistical profiler for code nobody instrumented. Every registered thread gets a timer on its own
+// CPU time that raises SIGPROF , the handler walks the frame pointers of the interrupted call stack
+// into a preallocated buffer with a single atomic increment , nothing it calls takes a lock or
+// allocates. Build with -fno-omit-frame-pointer , a frame without one ends its stack early.
+// Stacks are symbolized only when they are written out , as folded stacks for flamegraph.pl /
+// speedscope. Frames without an exported symbol are written as module+offset for addr2line , link
+// with -rdynamic to get names for the executable's own functions. Threads other than the one calling
+// Start have to call RegisterCurrentThread. A forked child keeps sampling its forking thread , it
+// calls FinishChildProcess before _exit to merge its stacks into the SetOutputPath file.
+// Linux only , Start returns false elsewhere.
+class SamplingProfiler
+{
+public:
+	static bool Start(unsigned int frequency = SAMPLING_DEFAULT_FREQUENCY);
+	static void Stop();
+	static bool IsRunning() { return s_running; };
+	static bool RegisterCurrentThread(const char* name = nullptr);
+	static bool WriteFoldedStacks(const char* filePath, bool merge = false);
+	static void SetOutputPath(const char* filePath);
+	static const char* GetOutputPath() { return s_outputPath; };
+	static void FinishChildProcess();
+	static size_t GetNumberOfSamples();
+	static size_t GetNumberOfDroppedSamples() { return s_numberOfDroppedSamples.load(std::memory_order_relaxed); };
+	static void RecordSample(void* signalContext);
+
+private:
+	static void ArmThreadTimer(size_t threadIndex, unsigned int frequency);
+	static bool CreateThreadTimer(size_t threadIndex);
+	static void RestartInChild();
+
+	static ProfileSample* s_samples;
+	static std::atomic<size_t> s_numberOfSamples;
+	static std::atomic<size_t> s_numberOfDroppedSamples;
+	static unsigned int s_frequency;
+	static bool s_running;
+	static char s_outputPath[260];
+};
+
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include "Timebase.hpp"
+
+#include <math.h>
+#include <mutex>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+#if HENRY_TIMEBASE_HAS_TSC && !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+
+
+namespace Henry
+{
+
+const double TIMEBASE_CALIBRATION_SECONDS = 0.01;
+const double TIMEBASE_MAX_CALIBRATION_ERROR = 0.002;		// both calibration windows have to agree within 0.2%
+
+std::atomic<TimebaseSource> Timebase::s_source(TIMEBASE_UNINITIALIZED);
+double Timebase::s_ticksPerSecond = 0.0;
+double Timebase::s_secondsPerTick = 0.0;
+unsigned long long Timebase::s_startTicks = 0;
+
+
+static unsigned long long ReadReferenceClock()
+{
+#if defined(_WIN32)
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter( &counter );
+	return (unsigned long long)counter.QuadPart;
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec * 1000000000ull + (unsigned long long)now.tv_nsec;
+#endif
+}
+
+
+static double GetReferenceTicksPerSecond()
+{
+#if defined(_WIN32)
+	LARGE_INTEGER countsPerSecond;
+	QueryPerformanceFrequency( &countsPerSecond );
+	return (double)countsPerSecond.QuadPart;
+#else
+	return 1000000000.0;
+#endif
+}
+
+
+// Also the path GetTicks takes before the first calibration.
+unsigned long long Timebase::GetReferenceTicks()
+{
+	if (s_source.load(std::memory_order_acquire) == TIMEBASE_UNINITIALIZED)
+	{
+		Initialize();
+		if (s_source.load(std::memory_order_acquire) == TIMEBASE_TSC)
+			return GetTicks();
+	}
+	return ReadReferenceClock();
+}
+
+
+#if HENRY_TIMEBASE_HAS_TSC
+
+static bool HasInvariantTSC()
+{
+	unsigned int registers[4] = { 0 };
+#if defined(_MSC_VER)
+	__cpuid((int*)registers, 0x80000000);
+	if (registers[0] < 0x80000007)
+		return false;
+	__cpuid((int*)registers, 0x80000007);
+#else
+	if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007)
+		return false;
+	__get_cpuid(0x80000007, &registers[0], &registers[1], &registers[2], &registers[3]);
+#endif
+	return (registers[3] & (1 << 8)) != 0;
+}
+
+
+// TSC ticks per reference tick over one window , the TSC read is bracketed by two reference reads
+static double MeasureTSCRate(double referenceTicksPerSecond)
+{
+	unsigned long long referenceBegin = ReadReferenceClock();
+	unsigned long long tscBegin = __rdtsc();
+	unsigned long long referenceBeginAfter = ReadReferenceClock();
+
+	unsigned long long referenceTarget = referenceBegin + (unsigned long long)(TIMEBASE_CALIBRATION_SECONDS * referenceTicksPerSecond);
+	unsigned long long referenceEnd;
+	while ((referenceEnd = ReadReferenceClock()) < referenceTarget)
+	{
+	}
+	unsigned long long tscEnd = __rdtsc();
+	unsigned long long referenceEndAfter = ReadReferenceClock();
+
+	double referenceElapsed = ((double)referenceEnd + referenceEndAfter) * 0.5 - ((double)referenceBegin + referenceBeginAfter) * 0.5;
+	if (referenceElapsed <= 0.0 || tscEnd <= tscBegin)
+		return 0.0;
+	return (double)(tscEnd - tscBegin) / referenceElapsed * referenceTicksPerSecond;
+}
+
+#endif
+
+
+void Timebase::Initialize()
+{
+	static std::mutex s_lock;
+	std::lock_guard<std::mutex> guard(s_lock);
+	if (s_source.load(std::memory_order_acquire) != TIMEBASE_UNINITIALIZED)
+		return;
+
+	double referenceTicksPerSecond = GetReferenceTicksPerSecond();
+	TimebaseSource source = TIMEBASE_REFERENCE_CLOCK;
+	double ticksPerSecond = referenceTicksPerSecond;
+
+#if HENRY_TIMEBASE_HAS_TSC
+	if (HasInvariantTSC())
+	{
+		double firstRate = MeasureTSCRate(referenceTicksPerSecond);
+		double secondRate = MeasureTSCRate(referenceTicksPerSecond);
+		if (firstRate > 1.0e8 && fabs(firstRate - secondRate) <= firstRate * TIMEBASE_MAX_CALIBRATION_ERROR)
+		{
+			source = TIMEBASE_TSC;
+			ticksPerSecond = (firstRate + secondRate) * 0.5;
+		}
+	}
+#endif
+
+	s_ticksPerSecond = ticksPerSecond;
+	s_secondsPerTick = 1.0 / ticksPerSecond;
+#if HENRY_TIMEBASE_HAS_TSC
+	s_startTicks = source == TIMEBASE_TSC ? __rdtsc() : ReadReferenceClock();
+#else
+	s_startTicks = ReadReferenceClock();
+#endif
+	s_source.store(source, std::memory_order_release);
+}
+
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#ifndef TIMEBASE_HPP
+#define TIMEBASE_HPP
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define HENRY_TIMEBASE_HAS_TSC 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#else
+#define HENRY_TIMEBASE_HAS_TSC 0
+#endif
+
+#include <atomic>
+
+
+namespace Henry
+{
+
+enum TimebaseSource { TIMEBASE_UNINITIALIZED = 0 , TIMEBASE_TSC , TIMEBASE_REFERENCE_CLOCK };
+
+
+// The engine's one tick counter. Reads the invariant TSC when the CPU has one and it agrees with the
+// OS monotonic clock (QueryPerformanceCounter / CLOCK_MONOTONIC) during calibration , otherwise reads
+// that clock directly. Hot paths keep raw ticks and convert to seconds only when they report.
+// Calibration runs on the first call and takes about 20 ms.
+class Timebase
+{
+public:
+	static inline unsigned long long GetTicks()
+	{
+#if HENRY_TIMEBASE_HAS_TSC
+		if (s_source.load(std::memory_order_acquire) == TIMEBASE_TSC)
+			return __rdtsc();
+#endif
+		return GetReferenceTicks();
+	};
+
+	static double TicksToSeconds(unsigned long long ticks) { return (double)ticks * GetSecondsPerTick(); };
+	static unsigned long long SecondsToTicks(double seconds) { return (unsigned long long)(seconds * GetTicksPerSecond()); };
+	static double GetSecondsPerTick() { if (s_source.load(std::memory_order_acquire) == TIMEBASE_UNINITIALIZED) Initialize(); return s_secondsPerTick; };
+	static double GetTicksPerSecond() { if (s_source.load(std::memory_order_acquire) == TIMEBASE_UNINITIALIZED) Initialize(); return s_ticksPerSecond; };
+	static double GetSecondsSinceStart() { unsigned long long ticks = GetTicks(); return TicksToSeconds(ticks - s_startTicks); };
+	static TimebaseSource GetSource() { if (s_source.load(std::memory_order_acquire) == TIMEBASE_UNINITIALIZED) Initialize(); return s_source.load(std::memory_order_acquire); };
+	static void Initialize();
+
+private:
+	static unsigned long long GetReferenceTicks();
+
+	static std::atomic<TimebaseSource> s_source;		// stored last , with release , once the rest is set
+	static double s_ticksPerSecond;
+	static double s_secondsPerTick;
+	static unsigned long long s_startTicks;
+};
+
+};
+
+#endif
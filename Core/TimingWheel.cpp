@@ -0,0 +1,222 @@
+#include "TimingWheel.hpp"
+
+#include <string.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+namespace Henry
+{
+
+static inline int FindFirstSetBit(unsigned int word)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, word);
+	return (int)index;
+#else
+	return __builtin_ctz(word);
+#endif
+}
+
+
+TimingWheel::TimingWheel()
+	: m_expired(nullptr)
+	, m_expiredTail(&m_expired)
+	, m_currentTick(0)
+	, m_numberOfNodes(0)
+{
+	memset(m_slots, 0, sizeof(m_slots));
+	memset(m_occupied, 0, sizeof(m_occupied));
+}
+
+
+void TimingWheel::Schedule(TimingWheelNode* node, unsigned long long expireTick)
+{
+	if (IsScheduled(node))
+		Cancel(node);
+
+	node->m_expireTick = expireTick;
+	++m_numberOfNodes;
+	Place(node);
+}
+
+
+void TimingWheel::Cancel(TimingWheelNode* node)
+{
+	if (!IsScheduled(node))
+		return;
+
+	*node->m_prevNext = node->m_next;
+	if (node->m_next)
+	{
+		node->m_next->m_prevNext = node->m_prevNext;
+	}
+	else if (m_expiredTail == &node->m_next)
+	{
+		m_expiredTail = node->m_prevNext;
+	}
+	else if (node->m_prevNext >= &m_slots[0][0] && node->m_prevNext < &m_slots[0][0] + TIMING_WHEEL_LEVELS * TIMING_WHEEL_SLOTS)
+	{
+		// it was alone in its slot
+		size_t index = node->m_prevNext - &m_slots[0][0];
+		m_occupied[index / TIMING_WHEEL_SLOTS][(index % TIMING_WHEEL_SLOTS) / 32] &= ~(1u << (index % 32));
+	}
+
+	node->m_next = nullptr;
+	node->m_prevNext = nullptr;
+	--m_numberOfNodes;
+}
+
+
+// Returns how many nodes were moved to the expired list.
+size_t TimingWheel::Advance(unsigned long long tick)
+{
+	// nothing to cascade , an empty wheel jumps straight there
+	if (m_numberOfNodes == 0)
+	{
+		if (m_currentTick < tick)
+			m_currentTick = tick;
+		return 0;
+	}
+
+	size_t numberOfExpired = 0;
+	while (m_currentTick < tick)
+	{
+		// jump to the next occupied level 0 slot , or to the next level boundary when there is none
+		unsigned long long nextTick = m_currentTick + 1;
+		if ((nextTick & TIMING_WHEEL_SLOT_MASK) != 0)
+		{
+			size_t slot = FindOccupiedSlot(0, (size_t)(nextTick & TIMING_WHEEL_SLOT_MASK));
+			nextTick = (nextTick & ~(unsigned long long)TIMING_WHEEL_SLOT_MASK) + slot;
+			if (nextTick > tick)
+			{
+				m_currentTick = tick;
+				break;
+			}
+		}
+
+		m_currentTick = nextTick;
+		if ((nextTick & TIMING_WHEEL_SLOT_MASK) == 0)
+		{
+			for (size_t level = 1; level < TIMING_WHEEL_LEVELS; ++level)
+			{
+				size_t slot = (size_t)(nextTick >> (TIMING_WHEEL_SLOT_BITS * level)) & TIMING_WHEEL_SLOT_MASK;
+				numberOfExpired += Cascade(level, slot);
+				if (slot != 0)
+					break;
+			}
+		}
+
+		numberOfExpired += Cascade(0, (size_t)(nextTick & TIMING_WHEEL_SLOT_MASK));
+	}
+
+	return numberOfExpired;
+}
+
+
+TimingWheelNode* TimingWheel::PopExpired()
+{
+	TimingWheelNode* node = m_expired;
+	if (node)
+		Cancel(node);
+	return node;
+}
+
+
+// Expired nodes first , then whatever sits in the lowest occupied slot. For tearing a wheel down.
+TimingWheelNode* TimingWheel::PopAny()
+{
+	if (m_expired)
+		return PopExpired();
+
+	for (size_t level = 0; level < TIMING_WHEEL_LEVELS; ++level)
+	{
+		size_t slot = FindOccupiedSlot(level, 0);
+		if (slot != TIMING_WHEEL_SLOTS)
+		{
+			TimingWheelNode* node = m_slots[level][slot];
+			Cancel(node);
+			return node;
+		}
+	}
+	return nullptr;
+}
+
+
+// Level 0 when the expire tick only differs from the current tick in its lowest 8 bits , level 1 when
+// it differs up to bit 15 and so on. Ticks already reached go to the next tick.
+// The top level takes everything less than a full turn away , its slots are read off the absolute tick
+// like the others , so an expiry across a 2^32 boundary lands in a slot the next turn reaches in time.
+void TimingWheel::Place(TimingWheelNode* node)
+{
+	unsigned long long placeTick = node->m_expireTick > m_currentTick ? node->m_expireTick : m_currentTick + 1;
+	size_t level = 0;
+	while (level < TIMING_WHEEL_LEVELS - 1 && (placeTick >> (TIMING_WHEEL_SLOT_BITS * (level + 1))) != (m_currentTick >> (TIMING_WHEEL_SLOT_BITS * (level + 1))))
+		++level;
+
+	// out of range , park it in the last slot of the top level to come around
+	if (placeTick - m_currentTick >= TIMING_WHEEL_RANGE)
+		placeTick = m_currentTick + ((unsigned long long)TIMING_WHEEL_SLOT_MASK << (TIMING_WHEEL_SLOT_BITS * level));
+
+	size_t slot = (size_t)(placeTick >> (TIMING_WHEEL_SLOT_BITS * level)) & TIMING_WHEEL_SLOT_MASK;
+	m_occupied[level][slot / 32] |= 1u << (slot % 32);
+	Link(&m_slots[level][slot], node);
+}
+
+
+void TimingWheel::Link(TimingWheelNode** head, TimingWheelNode* node)
+{
+	node->m_next = *head;
+	if (node->m_next)
+		node->m_next->m_prevNext = &node->m_next;
+	*head = node;
+	node->m_prevNext = head;
+}
+
+
+// Empties a slot , what is due joins the expired list in slot order and the rest moves down a level.
+size_t TimingWheel::Cascade(size_t level, size_t slot)
+{
+	size_t numberOfExpired = 0;
+	TimingWheelNode* node = m_slots[level][slot];
+	m_slots[level][slot] = nullptr;
+	m_occupied[level][slot / 32] &= ~(1u << (slot % 32));
+
+	while (node)
+	{
+		TimingWheelNode* next = node->m_next;
+		if (node->m_expireTick <= m_currentTick)
+		{
+			node->m_next = nullptr;
+			node->m_prevNext = m_expiredTail;
+			*m_expiredTail = node;
+			m_expiredTail = &node->m_next;
+			++numberOfExpired;
+		}
+		else
+		{
+			Place(node);
+		}
+		node = next;
+	}
+	return numberOfExpired;
+}
+
+
+// TIMING_WHEEL_SLOTS when no slot from fromSlot on is occupied.
+size_t TimingWheel::FindOccupiedSlot(size_t level, size_t fromSlot) const
+{
+	size_t word = fromSlot / 32;
+	unsigned int bits = m_occupied[level][word] & (~0u << (fromSlot % 32));
+	while (bits == 0)
+	{
+		if (++word == TIMING_WHEEL_BITMAP_WORDS)
+			return TIMING_WHEEL_SLOTS;
+		bits = m_occupied[level][word];
+	}
+	return word * 32 + FindFirstSetBit(bits);
+}
+
+};
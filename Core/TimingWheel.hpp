@@ -0,0 +1,89 @@
+#pragma once
+
+#ifndef TIMINGWHEEL_HPP
+#define TIMINGWHEEL_HPP
+
+#include <stddef.h>
+
+namespace Henry
+{
+
+const size_t TIMING_WHEEL_LEVELS = 4;
+const size_t TIMING_WHEEL_SLOT_BITS = 8;
+const size_t TIMING_WHEEL_SLOTS = 1 << TIMING_WHEEL_SLOT_BITS;
+const size_t TIMING_WHEEL_SLOT_MASK = TIMING_WHEEL_SLOTS - 1;
+const size_t TIMING_WHEEL_BITMAP_WORDS = TIMING_WHEEL_SLOTS / 32;
+const unsigned long long TIMING_WHEEL_RANGE = 1ull << (TIMING_WHEEL_SLOT_BITS * TIMING_WHEEL_LEVELS);
+
+// Intrusive list link , embed it in whatever is scheduled. m_prevNext is null while not scheduled.
+struct TimingWheelNode
+{
+	TimingWheelNode() : m_next(nullptr) , m_prevNext(nullptr) , m_expireTick(0) {};
+
+	TimingWheelNode* m_next;
+	TimingWheelNode** m_prevNext;
+	unsigned long long m_expireTick;
+};
+
+
+// Hierarchical timing wheel , level n has TIMING_WHEEL_SLOTS slots of 2^(8n) ticks each , so the four
+// levels cover 2^32 ticks ahead and anything further waits in the last level until it comes in range.
+// Schedule and Cancel are O(1). Advance only visits occupied slots and the level boundaries it crosses ,
+// the nodes that expire are moved to an expired list and handed out one at a time by PopExpired , so
+// callbacks may schedule or cancel anything , the popped node included.
+class TimingWheel
+{
+public:
+	TimingWheel();
+	void Schedule(TimingWheelNode* node, unsigned long long expireTick);
+	void Cancel(TimingWheelNode* node);
+	static bool IsScheduled(const TimingWheelNode* node) { return node->m_prevNext != nullptr; };
+	size_t Advance(unsigned long long tick);
+	TimingWheelNode* PopExpired();
+	TimingWheelNode* PopAny();
+	unsigned long long GetCurrentTick() const { return m_currentTick; };
+	size_t GetNumberOfNodes() const { return m_numberOfNodes; };
+
+	// Walks every scheduled node , expired ones included , for lookups that are allowed to be slow.
+	template <typename Visitor>
+	TimingWheelNode* FindNode(Visitor visitor) const
+	{
+		for (TimingWheelNode* node = m_expired; node; node = node->m_next)
+		{
+			if (visitor(node))
+				return node;
+		}
+
+		for (size_t level = 0; level < TIMING_WHEEL_LEVELS; ++level)
+		{
+			for (size_t slot = 0; slot < TIMING_WHEEL_SLOTS; ++slot)
+			{
+				for (TimingWheelNode* node = m_slots[level][slot]; node; node = node->m_next)
+				{
+					if (visitor(node))
+						return node;
+				}
+			}
+		}
+		return nullptr;
+	};
+
+private:
+	TimingWheel(const TimingWheel&);
+	void operator=(const TimingWheel&);
+	void Place(TimingWheelNode* node);
+	void Link(TimingWheelNode** head, TimingWheelNode* node);
+	size_t Cascade(size_t level, size_t slot);
+	size_t FindOccupiedSlot(size_t level, size_t fromSlot) const;
+
+	TimingWheelNode* m_slots[TIMING_WHEEL_LEVELS][TIMING_WHEEL_SLOTS];
+	unsigned int m_occupied[TIMING_WHEEL_LEVELS][TIMING_WHEEL_BITMAP_WORDS];
+	TimingWheelNode* m_expired;
+	TimingWheelNode** m_expiredTail;
+	unsigned long long m_currentTick;
+	size_t m_numberOfNodes;
+};
+
+};
+
+#endif
@@ -0,0 +1,396 @@
+#include "AllocationTrace.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+
+
+namespace Henry
+{
+
+struct AllocationTraceCallsiteSlot
+{
+	const char* m_file;
+	int m_line;
+	unsigned short m_index;
+};
+
+
+struct AllocationTraceState
+{
+	FILE* m_file;
+	AllocationTraceRecord* m_buffer;
+	size_t m_numberOfBuffered;
+	unsigned long long m_numberOfRecords;
+	std::chrono::steady_clock::time_point m_startTime;
+	AllocationTraceCallsiteSlot m_callsiteSlots[ALLOCATION_TRACE_CALLSITE_CAPACITY];
+	unsigned short m_callsiteOrder[ALLOCATION_TRACE_CALLSITE_CAPACITY];
+	unsigned short m_numberOfCallsites;
+};
+
+// a record waiting in its thread's buffer , the callsite is interned when the buffer is flushed
+struct AllocationTraceThreadRecord
+{
+	AllocationTraceRecord m_record;
+	const char* m_file;
+	int m_line;
+};
+
+
+// the owning thread and Stop both take m_lock , so a thread only ever waits for Stop draining it
+struct AllocationTraceThreadBuffer
+{
+	std::mutex m_lock;
+	std::atomic<size_t> m_numberOfRecords;
+	std::atomic<bool> m_inUse;
+	AllocationTraceThreadBuffer* m_next;
+	AllocationTraceThreadRecord m_records[ALLOCATION_TRACE_THREAD_RECORDS];
+};
+
+
+// gives the buffer back when its thread exits , the next new thread picks it up
+struct AllocationTraceThreadOwner
+{
+	AllocationTraceThreadOwner() : m_buffer(nullptr) {};
+	~AllocationTraceThreadOwner() { if (m_buffer) m_buffer->m_inUse.store(false, std::memory_order_release); };
+	AllocationTraceThreadBuffer* m_buffer;
+};
+
+
+struct AllocationTraceRecordEarlier
+{
+	bool operator()(const AllocationTraceRecord& lhs, const AllocationTraceRecord& rhs) const { return lhs.m_timestamp < rhs.m_timestamp; };
+};
+
+std::atomic<bool> AllocationTrace::s_isRecording(false);
+static AllocationTraceState s_traceState;
+static std::atomic<unsigned int> s_numberOfTraceThreads(0);
+static std::atomic<AllocationTraceThreadBuffer*> s_firstThreadBuffer(nullptr);
+
+
+static std::mutex& GetTraceLock()
+{
+	static std::mutex s_lock;
+	return s_lock;
+}
+
+
+static unsigned char GetTraceThreadIndex()
+{
+	static thread_local int s_threadIndex = -1;
+	if (s_threadIndex < 0)
+		s_threadIndex = (int)(s_numberOfTraceThreads.fetch_add(1, std::memory_order_relaxed) & 0xff);
+	return (unsigned char)s_threadIndex;
+}
+
+
+static AllocationTraceThreadBuffer* GetTraceThreadBuffer()
+{
+	static thread_local AllocationTraceThreadBuffer* s_threadBuffer = nullptr;
+	if (s_threadBuffer)
+		return s_threadBuffer;
+
+	static thread_local AllocationTraceThreadOwner s_owner;
+	for (AllocationTraceThreadBuffer* candidate = s_firstThreadBuffer.load(std::memory_order_acquire); candidate; candidate = candidate->m_next)
+	{
+		bool expected = false;
+		if (candidate->m_inUse.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+		{
+			s_threadBuffer = candidate;
+			s_owner.m_buffer = candidate;
+			return candidate;
+		}
+	}
+
+	void* memory = malloc(sizeof(AllocationTraceThreadBuffer));
+	if (memory == nullptr)
+		return nullptr;
+
+	AllocationTraceThreadBuffer* buffer = new (memory) AllocationTraceThreadBuffer();
+	buffer->m_numberOfRecords.store(0, std::memory_order_relaxed);
+	buffer->m_inUse.store(true, std::memory_order_relaxed);
+	buffer->m_next = s_firstThreadBuffer.load(std::memory_order_relaxed);
+	while (!s_firstThreadBuffer.compare_exchange_weak(buffer->m_next, buffer, std::memory_order_release, std::memory_order_relaxed))
+		;
+
+	s_threadBuffer = buffer;
+	s_owner.m_buffer = buffer;
+	return buffer;
+}
+
+
+static unsigned short FindTraceCallsite(AllocationTraceState& state, const char* filename, int line)
+{
+	if (filename == nullptr || filename[0] == '\0')
+		return 0;
+
+	size_t hash = ((size_t)filename * 31 + (size_t)line) * 2654435761u;
+	for (size_t probe = 0; probe < ALLOCATION_TRACE_CALLSITE_CAPACITY; ++probe)
+	{
+		AllocationTraceCallsiteSlot& slot = state.m_callsiteSlots[(hash + probe) & (ALLOCATION_TRACE_CALLSITE_CAPACITY - 1)];
+		if (slot.m_file == filename && slot.m_line == line)
+			return slot.m_index;
+
+		if (slot.m_file == nullptr)
+		{
+			if ((size_t)state.m_numberOfCallsites + 1 >= ALLOCATION_TRACE_CALLSITE_CAPACITY)
+				return 0;
+
+			slot.m_file = filename;
+			slot.m_line = line;
+			slot.m_index = ++state.m_numberOfCallsites;
+			state.m_callsiteOrder[slot.m_index] = (unsigned short)((hash + probe) & (ALLOCATION_TRACE_CALLSITE_CAPACITY - 1));
+			return slot.m_index;
+		}
+	}
+
+	return 0;
+}
+
+
+static void FlushTraceBuffer(AllocationTraceState& state)
+{
+	if (state.m_numberOfBuffered == 0)
+		return;
+
+	fwrite(state.m_buffer, sizeof(AllocationTraceRecord), state.m_numberOfBuffered, state.m_file);
+	state.m_numberOfBuffered = 0;
+}
+
+
+// caller holds the thread buffer's lock , the records are dropped when no trace is open
+static void FlushThreadBuffer(AllocationTraceThreadBuffer& buffer)
+{
+	size_t numberOfRecords = buffer.m_numberOfRecords.load(std::memory_order_relaxed);
+	if (numberOfRecords == 0)
+		return;
+
+	std::lock_guard<std::mutex> guard(GetTraceLock());
+	AllocationTraceState& state = s_traceState;
+	for (size_t index = 0; state.m_file && index < numberOfRecords; ++index)
+	{
+		const AllocationTraceThreadRecord& pending = buffer.m_records[index];
+		AllocationTraceRecord& record = state.m_buffer[state.m_numberOfBuffered++];
+		record = pending.m_record;
+		record.m_callsite = record.m_op == ALLOCATION_TRACE_ALLOCATE ? FindTraceCallsite(state, pending.m_file, pending.m_line) : 0;
+		++state.m_numberOfRecords;
+
+		if (state.m_numberOfBuffered == ALLOCATION_TRACE_BUFFER_RECORDS)
+			FlushTraceBuffer(state);
+	}
+	buffer.m_numberOfRecords.store(0, std::memory_order_relaxed);
+}
+
+
+// thread buffers reach the file in the order they fill , put the records back into time order for the replay
+static void MergeTraceRecords(AllocationTraceState& state)
+{
+	size_t numberOfRecords = (size_t)state.m_numberOfRecords;
+	AllocationTraceRecord* records = numberOfRecords > 1 ? (AllocationTraceRecord*)malloc(numberOfRecords * sizeof(AllocationTraceRecord)) : nullptr;
+	if (records)
+	{
+		fseek(state.m_file, sizeof(AllocationTraceHeader), SEEK_SET);
+		if (fread(records, sizeof(AllocationTraceRecord), numberOfRecords, state.m_file) == numberOfRecords)
+		{
+			std::stable_sort(records, records + numberOfRecords, AllocationTraceRecordEarlier());
+			fseek(state.m_file, sizeof(AllocationTraceHeader), SEEK_SET);
+			fwrite(records, sizeof(AllocationTraceRecord), numberOfRecords, state.m_file);
+		}
+		free(records);
+	}
+
+	fseek(state.m_file, (long)(sizeof(AllocationTraceHeader) + numberOfRecords * sizeof(AllocationTraceRecord)), SEEK_SET);
+}
+
+
+bool AllocationTrace::Start(const char* filePath)
+{
+	std::lock_guard<std::mutex> guard(GetTraceLock());
+	AllocationTraceState& state = s_traceState;
+	if (state.m_file)
+		return false;
+
+#if defined(_MSC_VER)
+	fopen_s(&state.m_file, filePath, "w+b");
+#else
+	state.m_file = fopen(filePath, "w+b");
+#endif
+	if (state.m_file == nullptr)
+		return false;
+
+	state.m_buffer = (AllocationTraceRecord*)malloc(ALLOCATION_TRACE_BUFFER_RECORDS * sizeof(AllocationTraceRecord));
+	if (state.m_buffer == nullptr)
+	{
+		fclose(state.m_file);
+		state.m_file = nullptr;
+		return false;
+	}
+
+	AllocationTraceHeader header;
+	memset(&header, 0, sizeof(header));
+	fwrite(&header, sizeof(header), 1, state.m_file);
+
+	memset(state.m_callsiteSlots, 0, sizeof(state.m_callsiteSlots));
+	state.m_numberOfCallsites = 0;
+	state.m_numberOfBuffered = 0;
+	state.m_numberOfRecords = 0;
+	state.m_startTime = std::chrono::steady_clock::now();
+	s_isRecording.store(true, std::memory_order_release);
+	return true;
+}
+
+
+void AllocationTrace::Stop()
+{
+	s_isRecording.store(false, std::memory_order_release);
+	for (AllocationTraceThreadBuffer* buffer = s_firstThreadBuffer.load(std::memory_order_acquire); buffer; buffer = buffer->m_next)
+	{
+		std::lock_guard<std::mutex> bufferGuard(buffer->m_lock);
+		FlushThreadBuffer(*buffer);
+	}
+
+	std::lock_guard<std::mutex> guard(GetTraceLock());
+	AllocationTraceState& state = s_traceState;
+	if (state.m_file == nullptr)
+		return;
+
+	FlushTraceBuffer(state);
+	MergeTraceRecords(state);
+
+	AllocationTraceHeader header;
+	header.m_magic = ALLOCATION_TRACE_MAGIC;
+	header.m_version = ALLOCATION_TRACE_VERSION;
+	header.m_recordSize = sizeof(AllocationTraceRecord);
+	header.m_numberOfCallsites = state.m_numberOfCallsites + 1;
+	header.m_numberOfRecords = state.m_numberOfRecords;
+	header.m_callsiteTableOffset = sizeof(AllocationTraceHeader) + state.m_numberOfRecords * sizeof(AllocationTraceRecord);
+
+	// callsite table : line , name length , name , starting with the unknown entry
+	for (unsigned int index = 0; index < header.m_numberOfCallsites; ++index)
+	{
+		const char* name = "unknown";
+		int line = 0;
+		if (index > 0)
+		{
+			const AllocationTraceCallsiteSlot& slot = state.m_callsiteSlots[state.m_callsiteOrder[index]];
+			name = slot.m_file;
+			line = slot.m_line;
+		}
+
+		unsigned short length = (unsigned short)strlen(name);
+		fwrite(&line, sizeof(line), 1, state.m_file);
+		fwrite(&length, sizeof(length), 1, state.m_file);
+		fwrite(name, 1, length, state.m_file);
+	}
+
+	fseek(state.m_file, 0, SEEK_SET);
+	fwrite(&header, sizeof(header), 1, state.m_file);
+	fclose(state.m_file);
+	free(state.m_buffer);
+	state.m_file = nullptr;
+	state.m_buffer = nullptr;
+}
+
+
+void AllocationTrace::Record(AllocationTraceOp op, void* p, size_t sizeInBytes, const char* filename, int line)
+{
+	AllocationTraceThreadBuffer* buffer = GetTraceThreadBuffer();
+	if (buffer == nullptr)
+		return;
+
+	unsigned char thread = GetTraceThreadIndex();
+	std::lock_guard<std::mutex> guard(buffer->m_lock);
+	if (!s_isRecording.load(std::memory_order_acquire))
+		return;
+
+	size_t index = buffer->m_numberOfRecords.load(std::memory_order_relaxed);
+	AllocationTraceThreadRecord& pending = buffer->m_records[index];
+	AllocationTraceRecord& record = pending.m_record;
+	record.m_timestamp = (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_traceState.m_startTime).count();
+	record.m_address = (unsigned long long)(size_t)p;
+	record.m_sizeInBytes = (unsigned int)sizeInBytes;
+	record.m_callsite = 0;
+	record.m_op = (unsigned char)op;
+	record.m_thread = thread;
+	pending.m_file = filename;
+	pending.m_line = line;
+	buffer->m_numberOfRecords.store(index + 1, std::memory_order_relaxed);
+
+	if (index + 1 == ALLOCATION_TRACE_THREAD_RECORDS)
+		FlushThreadBuffer(*buffer);
+}
+
+
+void AllocationTrace::RecordAllocate(void* p, size_t sizeInBytes, const char* filename, int line)
+{
+	if (p)
+		Record(ALLOCATION_TRACE_ALLOCATE, p, sizeInBytes, filename, line);
+}
+
+
+void AllocationTrace::RecordFree(void* p)
+{
+	if (p)
+		Record(ALLOCATION_TRACE_FREE, p, 0, "", 0);
+}
+
+
+// written records plus the ones still waiting in thread buffers
+size_t AllocationTrace::GetNumberOfRecords()
+{
+	size_t numberOfRecords = 0;
+	for (AllocationTraceThreadBuffer* buffer = s_firstThreadBuffer.load(std::memory_order_acquire); buffer; buffer = buffer->m_next)
+		numberOfRecords += buffer->m_numberOfRecords.load(std::memory_order_relaxed);
+
+	std::lock_guard<std::mutex> guard(GetTraceLock());
+	return numberOfRecords + (size_t)s_traceState.m_numberOfRecords;
+}
+
+
+bool AllocationTrace::Load(const char* filePath, std::vector<AllocationTraceRecord>& out_records, std::vector<AllocationTraceCallsite>& out_callsites)
+{
+	FILE* file = nullptr;
+#if defined(_MSC_VER)
+	fopen_s(&file, filePath, "rb");
+#else
+	file = fopen(filePath, "rb");
+#endif
+	if (file == nullptr)
+		return false;
+
+	AllocationTraceHeader header;
+	bool success = fread(&header, sizeof(header), 1, file) == 1
+		&& header.m_magic == ALLOCATION_TRACE_MAGIC
+		&& header.m_version == ALLOCATION_TRACE_VERSION
+		&& header.m_recordSize == sizeof(AllocationTraceRecord);
+
+	if (success)
+	{
+		out_records.resize((size_t)header.m_numberOfRecords);
+		if (header.m_numberOfRecords > 0)
+			success = fread(&out_records[0], sizeof(AllocationTraceRecord), out_records.size(), file) == out_records.size();
+	}
+
+	out_callsites.clear();
+	for (unsigned int index = 0; success && index < header.m_numberOfCallsites; ++index)
+	{
+		AllocationTraceCallsite callsite;
+		unsigned short length = 0;
+		success = fread(&callsite.m_line, sizeof(callsite.m_line), 1, file) == 1 && fread(&length, sizeof(length), 1, file) == 1;
+		if (success)
+		{
+			callsite.m_file.resize(length);
+			success = length == 0 || fread(&callsite.m_file[0], 1, length, file) == length;
+			out_callsites.push_back(callsite);
+		}
+	}
+
+	fclose(file);
+	return success;
+}
+
+};
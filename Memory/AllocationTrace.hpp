@@ -0,0 +1,77 @@
+#pragma once
+
+#ifndef ALLOCATIONTRACE_HPP
+#define ALLOCATIONTRACE_HPP
+
+#include <stddef.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+
+namespace Henry
+{
+
+const unsigned int ALLOCATION_TRACE_MAGIC = 0x52544148;		// "HATR"
+const unsigned int ALLOCATION_TRACE_VERSION = 1;
+const size_t ALLOCATION_TRACE_BUFFER_RECORDS = 16384;
+const size_t ALLOCATION_TRACE_THREAD_RECORDS = 1024;
+const size_t ALLOCATION_TRACE_CALLSITE_CAPACITY = 4096;
+
+enum AllocationTraceOp { ALLOCATION_TRACE_ALLOCATE = 0 , ALLOCATION_TRACE_FREE };
+
+
+// 24 bytes per event. Frees carry no size , a replay matches them to the allocation by address.
+struct AllocationTraceRecord
+{
+	unsigned long long m_timestamp;		// nanoseconds since the trace started
+	unsigned long long m_address;
+	unsigned int m_sizeInBytes;
+	unsigned short m_callsite;			// index into the callsite table , 0 is unknown
+	unsigned char m_op;
+	unsigned char m_thread;
+};
+
+
+struct AllocationTraceHeader
+{
+	unsigned int m_magic;
+	unsigned int m_version;
+	unsigned int m_recordSize;
+	unsigned int m_numberOfCallsites;
+	unsigned long long m_numberOfRecords;
+	unsigned long long m_callsiteTableOffset;
+};
+
+
+struct AllocationTraceCallsite
+{
+	std::string m_file;
+	int m_line;
+};
+
+
+// Binary trace of every operator new/delete going through the global hooks (HENRY_MEMORY_OVERRIDE_NEW).
+// Each thread records into its own malloc'ed buffer , which takes the trace lock only when it fills.
+// Stop drains every thread buffer , merges the records back into time order and writes the callsite
+// table and the header. Recording never calls operator new.
+class AllocationTrace
+{
+public:
+	static bool Start(const char* filePath);
+	static void Stop();
+	static bool IsRecording() { return s_isRecording.load(std::memory_order_relaxed); };
+	static void RecordAllocate(void* p, size_t sizeInBytes, const char* filename, int line);
+	static void RecordFree(void* p);
+	static size_t GetNumberOfRecords();
+	static bool Load(const char* filePath, std::vector<AllocationTraceRecord>& out_records, std::vector<AllocationTraceCallsite>& out_callsites);
+
+private:
+	static void Record(AllocationTraceOp op, void* p, size_t sizeInBytes, const char* filename, int line);
+
+	static std::atomic<bool> s_isRecording;
+};
+
+};
+
+#endif
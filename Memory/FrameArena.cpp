@@ -0,0 +1,105 @@
+#include "FrameArena.hpp"
+
+#include <stdlib.h>
+
+
+namespace Henry
+{
+
+FrameArena* _frameArena = nullptr;
+
+
+FrameArena::FrameArena(size_t bytesPerFrame)
+	: m_numberOfAllocationsThisFrame(0)
+	, m_numberOfAllocationsLastFrame(0)
+	, m_numberOfOverflowsThisFrame(0)
+	, m_numberOfOverflowsLastFrame(0)
+	, m_bytesAllocatedThisFrame(0)
+	, m_bytesAllocatedLastFrame(0)
+	, m_highWaterMark(0)
+	, m_bytesPerFrame(bytesPerFrame)
+	, m_currentBuffer(0)
+{
+	for (int index = 0; index < 2; ++index)
+	{
+		m_buffers[index] = (char*)malloc(bytesPerFrame);
+		if (m_buffers[index] == nullptr)
+			throw std::bad_alloc();
+		m_overflowBlocks[index] = nullptr;
+	}
+
+	m_current = m_buffers[0];
+	m_end = m_current + bytesPerFrame;
+}
+
+
+FrameArena::~FrameArena()
+{
+	for (int index = 0; index < 2; ++index)
+	{
+		ReleaseOverflowBlocks(index);
+		free(m_buffers[index]);
+	}
+
+	if (_frameArena == this)
+		_frameArena = nullptr;
+}
+
+
+void* FrameArena::Allocate(size_t sizeInBytes, size_t alignment)
+{
+	++m_numberOfAllocationsThisFrame;
+	m_bytesAllocatedThisFrame += sizeInBytes;
+
+	char* p = (char*)(((size_t)m_current + alignment - 1) & ~(alignment - 1));
+	if (p + sizeInBytes <= m_end)
+	{
+		m_current = p + sizeInBytes;
+		return p;
+	}
+
+	++m_numberOfOverflowsThisFrame;
+	size_t headerSize = (sizeof(FrameArenaOverflowBlock) + alignment - 1) & ~(alignment - 1);
+	char* memory = (char*)malloc(headerSize + sizeInBytes + alignment);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+
+	FrameArenaOverflowBlock* block = (FrameArenaOverflowBlock*)memory;
+	block->next = m_overflowBlocks[m_currentBuffer];
+	m_overflowBlocks[m_currentBuffer] = block;
+	return (char*)(((size_t)memory + headerSize + alignment - 1) & ~(alignment - 1));
+}
+
+
+void FrameArena::EndFrame()
+{
+	size_t bytesUsed = m_current - m_buffers[m_currentBuffer];
+	if (bytesUsed > m_highWaterMark)
+		m_highWaterMark = bytesUsed;
+
+	m_numberOfAllocationsLastFrame = m_numberOfAllocationsThisFrame;
+	m_numberOfOverflowsLastFrame = m_numberOfOverflowsThisFrame;
+	m_bytesAllocatedLastFrame = m_bytesAllocatedThisFrame;
+	m_numberOfAllocationsThisFrame = 0;
+	m_numberOfOverflowsThisFrame = 0;
+	m_bytesAllocatedThisFrame = 0;
+
+	m_currentBuffer = 1 - m_currentBuffer;
+	ReleaseOverflowBlocks(m_currentBuffer);
+	m_current = m_buffers[m_currentBuffer];
+	m_end = m_current + m_bytesPerFrame;
+}
+
+
+void FrameArena::ReleaseOverflowBlocks(int bufferIndex)
+{
+	while (m_overflowBlocks[bufferIndex])
+	{
+		FrameArenaOverflowBlock* block = m_overflowBlocks[bufferIndex];
+		m_overflowBlocks[bufferIndex] = block->next;
+		free(block);
+	}
+}
+
+
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#ifndef FRAMEARENA_HPP
+#define FRAMEARENA_HPP
+
+#include <stddef.h>
+#include <new>
+#include <vector>
+#include <utility>
+
+
+namespace Henry
+{
+
+struct FrameArenaOverflowBlock
+{
+	FrameArenaOverflowBlock* next;
+};
+
+
+// Linear allocator for memory that only has to live until the end of the next frame.
+// Two buffers are used in turn , EndFrame switches to the other buffer and rewinds it ,
+// so memory handed out in frame N is still valid while frame N + 1 is being built.
+// Requests that do not fit in the buffer fall back to the heap and are released on rewind.
+// Only the thread running the frame loop may use it.
+class FrameArena
+{
+public:
+	FrameArena(size_t bytesPerFrame);
+	~FrameArena();
+	void* Allocate(size_t sizeInBytes, size_t alignment = 16);
+	void EndFrame();
+	size_t GetBytesPerFrame() const { return m_bytesPerFrame; };
+	size_t GetHeapCallsSavedLastFrame() const { return m_numberOfAllocationsLastFrame - m_numberOfOverflowsLastFrame; };
+
+public:
+	size_t m_numberOfAllocationsThisFrame;
+	size_t m_numberOfAllocationsLastFrame;
+	size_t m_numberOfOverflowsThisFrame;
+	size_t m_numberOfOverflowsLastFrame;
+	size_t m_bytesAllocatedThisFrame;
+	size_t m_bytesAllocatedLastFrame;
+	size_t m_highWaterMark;
+
+private:
+	FrameArena(const FrameArena&);
+	void operator=(const FrameArena&);
+	void ReleaseOverflowBlocks(int bufferIndex);
+
+	size_t m_bytesPerFrame;
+	int m_currentBuffer;
+	char* m_buffers[2];
+	char* m_current;
+	char* m_end;
+	FrameArenaOverflowBlock* m_overflowBlocks[2];
+};
+
+extern FrameArena* _frameArena;
+
+
+// STL allocator drawing from a FrameArena , deallocate is free since the arena rewinds as a whole.
+// Without an arena (none created yet) it behaves like std::allocator.
+template <class T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	template <class U> struct rebind { typedef FrameAllocator<U> other; };
+
+	FrameAllocator() : m_arena(_frameArena) {};
+	FrameAllocator(FrameArena* arena) : m_arena(arena) {};
+	template <class U> FrameAllocator(const FrameAllocator<U>& other) : m_arena(other.m_arena) {};
+
+	T* allocate(size_t count)
+	{
+		if (m_arena)
+			return (T*)m_arena->Allocate(count * sizeof(T), __alignof(T) > 16 ? __alignof(T) : 16);
+		return (T*)::operator new(count * sizeof(T));
+	};
+	void deallocate(T* p, size_t count)
+	{
+		(void)count;
+		if (!m_arena)
+			::operator delete(p);
+	};
+	size_t max_size() const { return ((size_t)-1) / sizeof(T); };
+	template <class U, class... Args> void construct(U* p, Args&&... args) { new ((void*)p) U(std::forward<Args>(args)...); };
+	template <class U> void destroy(U* p) { p->~U(); };
+
+	FrameArena* m_arena;
+};
+
+template <class T, class U>
+inline bool operator==(const FrameAllocator<T>& lhs, const FrameAllocator<U>& rhs) { return lhs.m_arena == rhs.m_arena; }
+
+template <class T, class U>
+inline bool operator!=(const FrameAllocator<T>& lhs, const FrameAllocator<U>& rhs) { return lhs.m_arena != rhs.m_arena; }
+
+
+template <class T>
+using FrameVector = std::vector<T, FrameAllocator<T> >;
+
+};
+
+#endif
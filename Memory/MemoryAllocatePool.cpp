@@ -1,89 +1,119 @@
 #include "MemoryAllocatePool.hpp"
 
 #include <stdlib.h> 
-#include "Engine\Renderer\OpenGLRenderer.hpp"
+#include <string.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 #include "Engine\Core\HenryFunctions.hpp"
-
-// #undef DEBUG_NEW 
-// #undef new
+#include "Engine\Memory\MemoryThreadCache.hpp"
+#include "Engine\Memory\VirtualMemory.hpp"
+#include "Engine\Memory\AllocationTrace.hpp"
+#include "Engine\Core\Metrics.hpp"
+#include "Engine\Core\Profiler.hpp"
 
 #define UNUSED(x) (void)(x);
 
 
-// void* operator new(size_t size)
-// {
-// 	if (!Henry::_memoryAllocatePool)
-// 	{
-// 		size_t halfGB = 524288000;//1073741824;
-// 		Henry::_memoryAllocatePool = (Henry::MemoryAllocatePool*)malloc(sizeof(Henry::MemoryAllocatePool));
-// 		Henry::_memoryAllocatePool->Initialize(halfGB);
-// 	}
-// 
-// 	return Henry::_memoryAllocatePool->AllocateMemory(size);
-// };
-// 
-// 
-// void operator delete(void *p)
-// {
-// 	Henry::_memoryAllocatePool->FreeMemory(p);
-// };
-// 
-// 
-// void* operator new[](size_t size)
-// {
-// 	if (!Henry::_memoryAllocatePool)
-// 	{
-// 		size_t halfGB = 524288000;//1073741824;
-// 		Henry::_memoryAllocatePool = (Henry::MemoryAllocatePool*)malloc(sizeof(Henry::MemoryAllocatePool));
-// 		Henry::_memoryAllocatePool->Initialize(halfGB);
-// 	}
-// 
-// 	return Henry::_memoryAllocatePool->AllocateMemory(size);
-// };
-// 
-// 
-// void operator delete[](void* p)
-// {
-// 	Henry::_memoryAllocatePool->FreeMemory(p);
-// };
-// 
-// 
-// void* operator new(size_t size, const char* file, int line)
-// {
-// 	if (!Henry::_memoryAllocatePool)
-// 	{
-// 		size_t halfGB = 524288000;//1073741824;
-// 		Henry::_memoryAllocatePool = (Henry::MemoryAllocatePool*)malloc(sizeof(Henry::MemoryAllocatePool));
-// 		Henry::_memoryAllocatePool->Initialize(halfGB);
-// 	}
-// 
-// 	return Henry::_memoryAllocatePool->AllocateMemory(size, file, line);
-// };
-// 
-// 
-// void operator delete(void* p, const char* file, int line)
-// {
-// 	Henry::_memoryAllocatePool->FreeMemory(p, file, line);
-// };
-// 
-// 
-// void* operator new[](size_t size, const char* file, int line)
-// {
-// 	if (!Henry::_memoryAllocatePool)
-// 	{
-// 		size_t halfGB = 524288000;//1073741824;
-// 		Henry::_memoryAllocatePool = (Henry::MemoryAllocatePool*)malloc(sizeof(Henry::MemoryAllocatePool));
-// 		Henry::_memoryAllocatePool->Initialize(halfGB);
-// 	}
-// 
-// 	return Henry::_memoryAllocatePool->AllocateMemory(size, file, line);
-// };
-// 
-// 
-// void operator delete[](void* p, const char* file, int line)
-// {
-// 	Henry::_memoryAllocatePool->FreeMemory(p, file, line);
-// };
+#if defined(HENRY_MEMORY_OVERRIDE_NEW)
+
+#if !defined(HENRY_MEMORY_RESERVE_SIZE)
+#define HENRY_MEMORY_RESERVE_SIZE ((size_t)1 << (sizeof(void*) == 8 ? 36 : 30))
+#endif
+
+#if defined(HENRY_MEMORY_USE_HUGE_PAGES)
+static const bool USE_HUGE_PAGES = true;
+#else
+static const bool USE_HUGE_PAGES = false;
+#endif
+
+
+// the pool lives in static storage and is never destroyed , blocks may still be freed during exit
+static Henry::MemoryAllocatePool* CreateGlobalMemoryAllocatePool()
+{
+	static char* s_storage[(sizeof(Henry::MemoryAllocatePool) + sizeof(char*) - 1) / sizeof(char*)];
+	Henry::MemoryAllocatePool* pool = new (s_storage) Henry::MemoryAllocatePool();
+	pool->InitializeReserved(HENRY_MEMORY_RESERVE_SIZE, USE_HUGE_PAGES);
+	Henry::_memoryAllocatePool = pool;
+	return pool;
+}
+
+
+static inline void* GlobalAllocate(size_t size, const char* file, int line)
+{
+	static Henry::MemoryAllocatePool* s_pool = CreateGlobalMemoryAllocatePool();
+	UNUSED(s_pool);
+	void* p = Henry::ThreadCacheAllocate(size, file, line);
+	Henry::Profiler::RecordAllocation(size);
+	if (Henry::AllocationTrace::IsRecording())
+		Henry::AllocationTrace::RecordAllocate(p, size, file, line);
+	return p;
+}
+
+
+static inline void GlobalFree(void* p)
+{
+	if (p)
+	{
+		if (Henry::AllocationTrace::IsRecording())
+			Henry::AllocationTrace::RecordFree(p);
+		Henry::ThreadCacheFree(p);
+	}
+}
+
+
+void* operator new(size_t size)
+{
+	return GlobalAllocate(size, "", 0);
+}
+
+
+void operator delete(void* p)
+{
+	GlobalFree(p);
+}
+
+
+void* operator new[](size_t size)
+{
+	return GlobalAllocate(size, "", 0);
+}
+
+
+void operator delete[](void* p)
+{
+	GlobalFree(p);
+}
+
+
+void* operator new(size_t size, const char* file, int line)
+{
+	return GlobalAllocate(size, file, line);
+}
+
+
+void operator delete(void* p, const char* file, int line)
+{
+	UNUSED(file);
+	UNUSED(line);
+	GlobalFree(p);
+}
+
+
+void* operator new[](size_t size, const char* file, int line)
+{
+	return GlobalAllocate(size, file, line);
+}
+
+
+void operator delete[](void* p, const char* file, int line)
+{
+	UNUSED(file);
+	UNUSED(line);
+	GlobalFree(p);
+}
+
+#endif
 
 
 namespace Henry
@@ -91,90 +121,213 @@ namespace Henry
 
 MemoryAllocatePool* _memoryAllocatePool = nullptr;
 
+static const size_t HEADER_SIZE = sizeof(MemorySpaceHeader);
+static const size_t MINIMUM_BLOCK_SIZE = MEMORY_ALIGNMENT;
+
+
+// sampled once per frame without the pool lock , the numbers may be a frame stale
+static long long SamplePoolAllocatedBytes() { return _memoryAllocatePool ? (long long)_memoryAllocatePool->m_allocatedSize : 0; }
+static long long SamplePoolPeakBytes() { return _memoryAllocatePool ? (long long)_memoryAllocatePool->m_peakAllocatedSize : 0; }
+static long long SamplePoolCommittedBytes() { return _memoryAllocatePool ? (long long)_memoryAllocatePool->m_committedSize : 0; }
+static long long SamplePoolBlocks() { return _memoryAllocatePool ? (long long)_memoryAllocatePool->m_numberOfMemoryBlocks : 0; }
+
+static const unsigned int s_poolAllocatedBytesMetric = Metrics::RegisterGauge("memory.poolAllocatedBytes", &SamplePoolAllocatedBytes);
+static const unsigned int s_poolPeakBytesMetric = Metrics::RegisterGauge("memory.poolPeakBytes", &SamplePoolPeakBytes);
+static const unsigned int s_poolCommittedBytesMetric = Metrics::RegisterGauge("memory.poolCommittedBytes", &SamplePoolCommittedBytes);
+static const unsigned int s_poolBlocksMetric = Metrics::RegisterGauge("memory.poolBlocks", &SamplePoolBlocks);
+
+
+static inline int FindFirstSetBit(unsigned int word)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, word);
+	return (int)index;
+#else
+	return __builtin_ctz(word);
+#endif
+}
+
+
+static inline int FindLastSetBit(size_t word)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanReverse64(&index, word);
+	return (int)index;
+#elif defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse(&index, word);
+	return (int)index;
+#else
+	return (int)(sizeof(unsigned long long) * 8 - 1) - __builtin_clzll((unsigned long long)word);
+#endif
+}
+
+
+static inline size_t AlignUp(size_t size)
+{
+	return (size + MEMORY_ALIGNMENT - 1) & ~(MEMORY_ALIGNMENT - 1);
+}
+
+
+static inline void MappingInsert(size_t size, int& firstLevel, int& secondLevel)
+{
+	if (size < MEMORY_SMALL_BLOCK_SIZE)
+	{
+		firstLevel = 0;
+		secondLevel = (int)(size / (MEMORY_SMALL_BLOCK_SIZE / MEMORY_SECOND_LEVEL_COUNT));
+	}
+	else
+	{
+		int lastBit = FindLastSetBit(size);
+		secondLevel = (int)(size >> (lastBit - MEMORY_SECOND_LEVEL_LOG2)) ^ (int)MEMORY_SECOND_LEVEL_COUNT;
+		firstLevel = lastBit - (int)(MEMORY_FIRST_LEVEL_SHIFT - 1);
+	}
+}
+
+
+static inline void MappingSearch(size_t size, int& firstLevel, int& secondLevel)
+{
+	// round up to the next list so any block found there is guaranteed to fit
+	if (size >= MEMORY_SMALL_BLOCK_SIZE)
+		size += ((size_t)1 << (FindLastSetBit(size) - MEMORY_SECOND_LEVEL_LOG2)) - 1;
+
+	MappingInsert(size, firstLevel, secondLevel);
+}
+
+
+static inline MemorySpaceHeader* HeaderFromPointer(void* p)
+{
+	return (MemorySpaceHeader*)((char*)p - HEADER_SIZE);
+}
+
+
+static inline void* PointerFromHeader(MemorySpaceHeader* header)
+{
+	return (char*)header + HEADER_SIZE;
+}
+
+
 MemoryAllocatePool::MemoryAllocatePool()
+	: m_memorySize(0)
+	, m_allocatedSize(0)
+	, m_numberOfMemoryBlocks(0)
+	, m_largestSizeOfMemoryAllocated(0)
+	, m_peakAllocatedSize(0)
+	, m_committedSize(0)
+	, m_numberOfDiscards(0)
+	, m_beginOfMemory(nullptr)
+	, m_headOfMemory(nullptr)
+	, m_tailOfMemory(nullptr)
+	, m_firstLevelBitmap(0)
+	, m_isReserved(false)
+	, m_commitGranularity(MEMORY_COMMIT_GRANULARITY)
+	, m_committedEnd(nullptr)
 {
-//	_memoryAllocatePool = this;
-// 	m_beginOfMemory = (void*)malloc(numOfBytes);
-// 	m_headOfFreeSpace = new FreeSpaceHeader(numOfBytes);
-// 	m_headOfFreeSpace = (FreeSpaceHeader*)m_beginOfMemory;
-// 	m_tailOfFreeSpace = (FreeSpaceHeader*)m_beginOfMemory;
+	memset(m_secondLevelBitmap, 0, sizeof(m_secondLevelBitmap));
+	memset(m_freeLists, 0, sizeof(m_freeLists));
 }
 
 
 MemoryAllocatePool::~MemoryAllocatePool()
 {
-	free(m_beginOfMemory);
+	if (m_isReserved)
+		ReleaseVirtualMemory(m_beginOfMemory, m_memorySize);
+#if defined(_MSC_VER)
+	else
+		_aligned_free(m_beginOfMemory);
+#else
+	else
+		free(m_beginOfMemory);
+#endif
 }
 
 
-void* MemoryAllocatePool::AllocateMemory(size_t sizeRequired, const char* filename , int line)
+void MemoryAllocatePool::InsertFreeBlock(MemorySpaceHeader* block)
 {
- 	MemorySpaceHeader* currentNode = m_headOfFreeSpace;
-	void* return_ptr = m_headOfFreeSpace;
-	
-	++m_numberOfMemoryBlocks;
-	m_allocatedSize += sizeRequired;
+	int firstLevel;
+	int secondLevel;
+	MappingInsert(block->sizeInBytes, firstLevel, secondLevel);
+
+	MemorySpaceHeader* head = m_freeLists[firstLevel][secondLevel];
+	block->available = true;
+	block->cached = false;
+	block->prevFree = nullptr;
+	block->nextFree = head;
+	if (head)
+		head->prevFree = block;
+
+	m_freeLists[firstLevel][secondLevel] = block;
+	m_firstLevelBitmap |= (1u << firstLevel);
+	m_secondLevelBitmap[firstLevel] |= (1u << secondLevel);
+}
 
-	while (currentNode)
- 	{
-		if (!currentNode->available && m_largestSizeOfMemoryAllocated < currentNode->sizeInBytes)
-			m_largestSizeOfMemoryAllocated = sizeRequired;
 
-		if (currentNode->sizeInBytes >= sizeRequired)
+void MemoryAllocatePool::RemoveFreeBlock(MemorySpaceHeader* block)
+{
+	int firstLevel;
+	int secondLevel;
+	MappingInsert(block->sizeInBytes, firstLevel, secondLevel);
+
+	if (block->prevFree)
+		block->prevFree->nextFree = block->nextFree;
+	if (block->nextFree)
+		block->nextFree->prevFree = block->prevFree;
+
+	if (m_freeLists[firstLevel][secondLevel] == block)
+	{
+		m_freeLists[firstLevel][secondLevel] = block->nextFree;
+		if (block->nextFree == nullptr)
 		{
-			if (currentNode == m_tailOfMemory)
-			{
-				m_allocatedSize += sizeof(MemorySpaceHeader);
-				return_ptr = currentNode + sizeof(MemorySpaceHeader);
-
-				MemorySpaceHeader* tail = currentNode + sizeof(MemorySpaceHeader) + sizeRequired;
-				tail->prev = currentNode;
-				tail->next = nullptr;
-				tail->sizeInBytes = currentNode->sizeInBytes - sizeof(MemorySpaceHeader) - sizeRequired;
-
-				currentNode->filename = filename;
-				currentNode->line = line;
-				currentNode->available = false;
-				currentNode->sizeInBytes = sizeRequired;
-				currentNode->next = tail;
-				m_tailOfMemory = tail;
-				break;
-			}
-			else if (currentNode->available)
-			{
-				return_ptr = currentNode + sizeof(MemorySpaceHeader);
-				currentNode->available = false;
-				currentNode->filename = filename;
-				currentNode->line = line;
-
-				int spaceRemain = currentNode->sizeInBytes - sizeRequired;
-				if (spaceRemain > sizeof(MemorySpaceHeader))
-				{
-					m_allocatedSize += sizeof(MemorySpaceHeader);
-
-					MemorySpaceHeader* space = currentNode + sizeof(MemorySpaceHeader) + sizeRequired;
-					space->available = true;
-					space->next = currentNode->next;
-					space->prev = currentNode;
-					space->sizeInBytes = spaceRemain - sizeof(MemorySpaceHeader);
-
-					currentNode->sizeInBytes = sizeRequired;
-					currentNode->next = space;
-				}
-				else
-					m_allocatedSize += spaceRemain;
-
-				break;
-			}
+			m_secondLevelBitmap[firstLevel] &= ~(1u << secondLevel);
+			if (m_secondLevelBitmap[firstLevel] == 0)
+				m_firstLevelBitmap &= ~(1u << firstLevel);
 		}
+	}
 
- 		currentNode = currentNode->next;
- 	}
+	block->available = false;
+	block->prevFree = nullptr;
+	block->nextFree = nullptr;
+}
 
-	if (currentNode == nullptr)
+
+MemorySpaceHeader* MemoryAllocatePool::FindFreeBlock(size_t sizeInBytes)
+{
+	int firstLevel;
+	int secondLevel;
+	MappingSearch(sizeInBytes, firstLevel, secondLevel);
+
+	if (firstLevel >= (int)MEMORY_FIRST_LEVEL_COUNT)
+		return nullptr;
+
+	unsigned int secondLevelMap = m_secondLevelBitmap[firstLevel] & (~0u << secondLevel);
+	if (secondLevelMap == 0)
+	{
+		if (firstLevel + 1 >= (int)MEMORY_FIRST_LEVEL_COUNT)
+			return nullptr;
+
+		unsigned int firstLevelMap = m_firstLevelBitmap & (~0u << (firstLevel + 1));
+		if (firstLevelMap == 0)
+			return nullptr;
+
+		firstLevel = FindFirstSetBit(firstLevelMap);
+		secondLevelMap = m_secondLevelBitmap[firstLevel];
+	}
+
+	secondLevel = FindFirstSetBit(secondLevelMap);
+	return m_freeLists[firstLevel][secondLevel];
+}
+
+
+void* MemoryAllocatePool::AllocateMemory(size_t sizeRequired, const char* filename , int line)
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	void* p = AllocateMemoryLocked(sizeRequired, filename, line, false);
+	if (p == nullptr)
 		throw std::bad_alloc();
 
-	return return_ptr;
+	return p;
 }
 
 
@@ -182,84 +335,358 @@ void MemoryAllocatePool::FreeMemory(void* p, const char* filename, int line)
 {
 	UNUSED(filename);
 	UNUSED(line);
-	
-	MemorySpaceHeader* ptr = (MemorySpaceHeader*)p - sizeof(MemorySpaceHeader);
-	ptr->available = true;
 
-	if (m_largestSizeOfMemoryAllocated == ptr->sizeInBytes)
-		m_largestSizeOfMemoryAllocated = 0;
-	
+	if (p == nullptr)
+		return;
+
+	std::lock_guard<std::mutex> guard(m_lock);
+	FreeMemoryLocked(p);
+}
+
+
+size_t MemoryAllocatePool::AllocateBatch(size_t sizeRequired, void** out_blocks, size_t count)
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	size_t allocated = 0;
+	for (; allocated < count; ++allocated)
+	{
+		out_blocks[allocated] = AllocateMemoryLocked(sizeRequired, "", 0, true);
+		if (out_blocks[allocated] == nullptr)
+			break;
+	}
+
+	return allocated;
+}
+
+
+void MemoryAllocatePool::FreeBatch(void** blocks, size_t count)
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	for (size_t index = 0; index < count; ++index)
+		FreeMemoryLocked(blocks[index]);
+}
+
+
+size_t MemoryAllocatePool::GetBlockSize(void* p)
+{
+	return HeaderFromPointer(p)->sizeInBytes;
+}
+
+
+void MemoryAllocatePool::TagBlock(void* p, bool cached, const char* filename, int line)
+{
+	MemorySpaceHeader* header = HeaderFromPointer(p);
+	MemoryTelemetry& telemetry = _memoryAllocatePool->m_telemetry;
+	if (cached && !header->cached)
+	{
+		telemetry.RecordFree(header->callsite, header->tag, header->sizeInBytes);
+	}
+	else if (!cached)
+	{
+		if (!header->cached)
+			telemetry.RecordFree(header->callsite, header->tag, header->sizeInBytes);
+
+		header->tag = MemoryTelemetry::GetCurrentTag();
+		header->callsite = telemetry.FindCallsite(filename, line);
+		telemetry.RecordAllocate(header->callsite, header->tag, header->sizeInBytes);
+	}
+
+	header->cached = cached;
+	header->filename = filename;
+	header->line = line;
+}
+
+
+void* MemoryAllocatePool::AllocateMemoryLocked(size_t sizeRequired, const char* filename , int line, bool cached)
+{
+	// rounding and the free list search would wrap around for sizes this close to the top
+	if (sizeRequired > ((size_t)-1) - HEADER_SIZE - MEMORY_ALIGNMENT || sizeRequired > m_memorySize)
+		return nullptr;
+
+	size_t blockSize = AlignUp(sizeRequired < MINIMUM_BLOCK_SIZE ? MINIMUM_BLOCK_SIZE : sizeRequired);
+
+	MemorySpaceHeader* currentNode = FindFreeBlock(blockSize);
+	if (currentNode == nullptr)
+		return nullptr;
+
+	size_t spaceRemain = currentNode->sizeInBytes - blockSize;
+	bool splitBlock = spaceRemain >= HEADER_SIZE + MINIMUM_BLOCK_SIZE;
+	char* usedEnd = (char*)PointerFromHeader(currentNode) + (splitBlock ? blockSize + HEADER_SIZE : currentNode->sizeInBytes);
+	if (!EnsureCommitted(usedEnd))
+		return nullptr;
+
+	RemoveFreeBlock(currentNode);
+
+	if (splitBlock)
+	{
+		MemorySpaceHeader* space = (MemorySpaceHeader*)((char*)PointerFromHeader(currentNode) + blockSize);
+		space->filename = "";
+		space->line = 0;
+		space->sizeInBytes = spaceRemain - HEADER_SIZE;
+		space->discarded = currentNode->discarded;
+		space->prev = currentNode;
+		space->next = currentNode->next;
+		if (space->next != nullptr)
+			space->next->prev = space;
+		else
+			m_tailOfMemory = space;
+
+		currentNode->sizeInBytes = blockSize;
+		currentNode->next = space;
+		InsertFreeBlock(space);
+	}
+
+	currentNode->cached = cached;
+	currentNode->filename = filename;
+	currentNode->line = line;
+	currentNode->tag = MemoryTelemetry::GetCurrentTag();
+	currentNode->callsite = m_telemetry.FindCallsite(filename, line);
+	if (!cached)
+		m_telemetry.RecordAllocate(currentNode->callsite, currentNode->tag, currentNode->sizeInBytes);
+
+	++m_numberOfMemoryBlocks;
+	m_allocatedSize += currentNode->sizeInBytes + HEADER_SIZE;
+	if (m_peakAllocatedSize < m_allocatedSize)
+		m_peakAllocatedSize = m_allocatedSize;
+	if (m_largestSizeOfMemoryAllocated < currentNode->sizeInBytes)
+		m_largestSizeOfMemoryAllocated = currentNode->sizeInBytes;
+
+	return PointerFromHeader(currentNode);
+}
+
+
+void MemoryAllocatePool::DiscardRange(char* begin, char* end, char* interiorBegin, char* interiorEnd)
+{
+	// whole pages touching the range , clipped to the free block's interior and what has been committed
+	size_t pageSize = GetVirtualMemoryPageSize();
+	if (interiorEnd > m_committedEnd)
+		interiorEnd = m_committedEnd;
+
+	char* freeBegin = (char*)((size_t)begin & ~(pageSize - 1));
+	char* freeEnd = (char*)(((size_t)end + pageSize - 1) & ~(pageSize - 1));
+	if (freeBegin < interiorBegin)
+		freeBegin = interiorBegin;
+	if (freeEnd > interiorEnd)
+		freeEnd = interiorEnd;
+
+	freeBegin = (char*)(((size_t)freeBegin + pageSize - 1) & ~(pageSize - 1));
+	freeEnd = (char*)((size_t)freeEnd & ~(pageSize - 1));
+	if (freeEnd > freeBegin)
+	{
+		DiscardVirtualMemory(freeBegin, freeEnd - freeBegin);
+		++m_numberOfDiscards;
+	}
+}
+
+
+void MemoryAllocatePool::FreeMemoryLocked(void* p)
+{
+	MemorySpaceHeader* ptr = HeaderFromPointer(p);
+	if (!ptr->cached)
+		m_telemetry.RecordFree(ptr->callsite, ptr->tag, ptr->sizeInBytes);
+	ptr->cached = false;
+
 	--m_numberOfMemoryBlocks;
-	m_allocatedSize -= ptr->sizeInBytes;
+	m_allocatedSize -= ptr->sizeInBytes + HEADER_SIZE;
 
-	if (ptr->next != nullptr)
+	// what becomes free in this call , plus any merged neighbour whose pages are still resident
+	char* releasedBegin = (char*)ptr;
+	char* releasedEnd = (char*)PointerFromHeader(ptr) + ptr->sizeInBytes;
+	char* residentBegin[2] = { nullptr, nullptr };
+	char* residentEnd[2] = { nullptr, nullptr };
+
+	MemorySpaceHeader* nextSpace = ptr->next;
+	if (nextSpace != nullptr && nextSpace->available)
 	{
-		MemorySpaceHeader* nextSpace = ptr->next;
-		if (nextSpace->available)
+		releasedEnd += HEADER_SIZE;
+		if (!nextSpace->discarded)
 		{
-			m_allocatedSize -= sizeof(MemorySpaceHeader);
-
-			ptr->sizeInBytes += (nextSpace->sizeInBytes + sizeof(MemorySpaceHeader));
-			ptr->next = nextSpace->next;
-			if (ptr->next != nullptr)
-				ptr->next->prev = ptr;
-			else
-				m_tailOfMemory = ptr;
+			residentBegin[0] = (char*)nextSpace;
+			residentEnd[0] = (char*)PointerFromHeader(nextSpace) + nextSpace->sizeInBytes;
 		}
+		RemoveFreeBlock(nextSpace);
+		ptr->sizeInBytes += nextSpace->sizeInBytes + HEADER_SIZE;
+		ptr->next = nextSpace->next;
+		if (ptr->next != nullptr)
+			ptr->next->prev = ptr;
+		else
+			m_tailOfMemory = ptr;
 	}
 
-	if (ptr->prev != nullptr)
+	MemorySpaceHeader* previousSpace = ptr->prev;
+	if (previousSpace != nullptr && previousSpace->available)
 	{
-		MemorySpaceHeader* previousSpace = ptr->prev;
-		if (previousSpace->available)
+		if (!previousSpace->discarded)
 		{
-			m_allocatedSize -= sizeof(MemorySpaceHeader);
-			
-			previousSpace->sizeInBytes += (ptr->sizeInBytes + sizeof(MemorySpaceHeader));
-			previousSpace->next = ptr->next;
-			if (previousSpace->next != nullptr)
-				previousSpace->next->prev = previousSpace;
-			else
-				m_tailOfMemory = previousSpace;
+			residentBegin[1] = (char*)previousSpace;
+			residentEnd[1] = (char*)PointerFromHeader(previousSpace) + previousSpace->sizeInBytes;
 		}
+		RemoveFreeBlock(previousSpace);
+		previousSpace->sizeInBytes += ptr->sizeInBytes + HEADER_SIZE;
+		previousSpace->next = ptr->next;
+		if (previousSpace->next != nullptr)
+			previousSpace->next->prev = previousSpace;
+		else
+			m_tailOfMemory = previousSpace;
+		ptr = previousSpace;
 	}
+
+	ptr->filename = "";
+	ptr->line = 0;
+	ptr->discarded = false;
+
+	if (m_isReserved && ptr->sizeInBytes >= MEMORY_DISCARD_THRESHOLD)
+	{
+		char* interiorBegin = (char*)PointerFromHeader(ptr);
+		char* interiorEnd = interiorBegin + ptr->sizeInBytes;
+
+		DiscardRange(releasedBegin, releasedEnd, interiorBegin, interiorEnd);
+		for (int i = 0; i < 2; ++i)
+		{
+			if (residentBegin[i] != nullptr)
+				DiscardRange(residentBegin[i], residentEnd[i], interiorBegin, interiorEnd);
+		}
+		ptr->discarded = true;
+	}
+
+	InsertFreeBlock(ptr);
+}
+
+
+bool MemoryAllocatePool::EnsureCommitted(char* end)
+{
+	if (end <= m_committedEnd)
+		return true;
+
+	char* beginOfMemory = (char*)m_beginOfMemory;
+	size_t committedSize = ((end - beginOfMemory) + m_commitGranularity - 1) / m_commitGranularity * m_commitGranularity;
+	if (committedSize > m_memorySize)
+		committedSize = m_memorySize;
+
+	if (!CommitVirtualMemory(m_committedEnd, committedSize - m_committedSize))
+		return false;
+
+	m_committedSize = committedSize;
+	m_committedEnd = beginOfMemory + committedSize;
+	return true;
 }
 
 
 void MemoryAllocatePool::ScanMemory()
 {
-	MemorySpaceHeader* currentNode = m_headOfFreeSpace;
+	MemorySpaceHeader* currentNode = m_headOfMemory;
 	while (currentNode)
 	{
-		if (!currentNode->available)
+		if (!currentNode->available && !currentNode->cached)
 		{
-			DebuggerPrintf("%s(%d) : memory leak , size-> %d bytes , memory address -> %d \r\n", currentNode->filename, currentNode->line, currentNode->sizeInBytes, currentNode);
+			DebuggerPrintf("%s(%d) : memory leak , size-> %d bytes , memory address -> %p \r\n", currentNode->filename, (int)currentNode->line, (int)currentNode->sizeInBytes, PointerFromHeader(currentNode));
 		}
 		currentNode = currentNode->next;
 	}
 }
 
 
+void MemoryAllocatePool::GetFreeBlockHistogram(MemoryFreeBlockHistogram& out_histogram)
+{
+	memset(&out_histogram, 0, sizeof(out_histogram));
+
+	std::lock_guard<std::mutex> guard(m_lock);
+	for (size_t firstLevel = 0; firstLevel < MEMORY_FIRST_LEVEL_COUNT; ++firstLevel)
+	{
+		if ((m_firstLevelBitmap & (1u << firstLevel)) == 0)
+			continue;
+
+		for (size_t secondLevel = 0; secondLevel < MEMORY_SECOND_LEVEL_COUNT; ++secondLevel)
+		{
+			for (MemorySpaceHeader* block = m_freeLists[firstLevel][secondLevel]; block; block = block->nextFree)
+			{
+				int bucket = FindLastSetBit(block->sizeInBytes);
+				++out_histogram.m_blockCount[bucket];
+				out_histogram.m_blockBytes[bucket] += block->sizeInBytes;
+				++out_histogram.m_numberOfFreeBlocks;
+				out_histogram.m_totalFreeBytes += block->sizeInBytes;
+				if (out_histogram.m_largestFreeBlock < block->sizeInBytes)
+					out_histogram.m_largestFreeBlock = block->sizeInBytes;
+			}
+		}
+	}
+
+	if (out_histogram.m_totalFreeBytes != 0)
+		out_histogram.m_fragmentation = 1.0f - (float)out_histogram.m_largestFreeBlock / (float)out_histogram.m_totalFreeBytes;
+}
+
+
+bool MemoryAllocatePool::WriteSnapshot(const char* filePath, MemorySnapshotFormat format)
+{
+	MemoryFreeBlockHistogram histogram;
+	GetFreeBlockHistogram(histogram);
+	return m_telemetry.WriteSnapshot(filePath, format, histogram, m_memorySize, m_allocatedSize, m_peakAllocatedSize);
+}
+
+
 void MemoryAllocatePool::Initialize(size_t numberOfBytes)
 {
-	m_beginOfMemory = malloc(numberOfBytes);
+	// malloc only gives 8 bytes on 32 bit builds , the first header needs MEMORY_ALIGNMENT.
+#if defined(_MSC_VER)
+	m_beginOfMemory = _aligned_malloc(numberOfBytes, MEMORY_ALIGNMENT);
+#else
+	if (posix_memalign(&m_beginOfMemory, MEMORY_ALIGNMENT, numberOfBytes) != 0)
+		m_beginOfMemory = nullptr;
+#endif
 	m_memorySize = numberOfBytes;
-	m_allocatedSize = sizeof(MemorySpaceHeader);
-	m_numberOfMemoryBlocks = 0;
-	m_largestSizeOfMemoryAllocated = 0;
+	m_isReserved = false;
+	if (m_beginOfMemory == nullptr || numberOfBytes < HEADER_SIZE + MINIMUM_BLOCK_SIZE)
+		throw std::bad_alloc();
 
+	m_committedSize = numberOfBytes;
+	m_committedEnd = (char*)m_beginOfMemory + numberOfBytes;
+	InitializeBlocks();
+}
+
+
+void MemoryAllocatePool::InitializeReserved(size_t numberOfBytes, bool useHugePages)
+{
+	m_commitGranularity = useHugePages ? MEMORY_HUGE_PAGE_SIZE : MEMORY_COMMIT_GRANULARITY;
+	numberOfBytes = (numberOfBytes + m_commitGranularity - 1) / m_commitGranularity * m_commitGranularity;
+
+	m_beginOfMemory = ReserveVirtualMemory(numberOfBytes);
+	m_memorySize = numberOfBytes;
+	m_isReserved = true;
+	m_committedSize = 0;
+	m_committedEnd = (char*)m_beginOfMemory;
 	if (m_beginOfMemory == nullptr)
 		throw std::bad_alloc();
 
+	if (useHugePages)
+		AdviseHugePages(m_beginOfMemory, numberOfBytes);
+
+	if (!EnsureCommitted((char*)m_beginOfMemory + HEADER_SIZE))
+		throw std::bad_alloc();
+
+	InitializeBlocks();
+}
+
+
+void MemoryAllocatePool::InitializeBlocks()
+{
+	m_allocatedSize = 0;
+	m_numberOfMemoryBlocks = 0;
+	m_largestSizeOfMemoryAllocated = 0;
+	m_peakAllocatedSize = 0;
+	m_firstLevelBitmap = 0;
+	memset(m_secondLevelBitmap, 0, sizeof(m_secondLevelBitmap));
+	memset(m_freeLists, 0, sizeof(m_freeLists));
+
 	m_headOfMemory = (MemorySpaceHeader*)m_beginOfMemory;
-	m_headOfMemory->available = true;
+	m_headOfMemory->filename = "";
+	m_headOfMemory->line = 0;
 	m_headOfMemory->prev = nullptr;
 	m_headOfMemory->next = nullptr;
-	m_headOfMemory->nextSpac = nullptr;
-	m_headOfMemory->sizeInBytes = numberOfBytes - sizeof(MemorySpaceHeader);
+	m_headOfMemory->sizeInBytes = (m_memorySize - HEADER_SIZE) & ~(MEMORY_ALIGNMENT - 1);
+	m_headOfMemory->discarded = true;
 
 	m_tailOfMemory = m_headOfMemory;
-	m_headOfFreeSpace = m_headOfMemory;
+	InsertFreeBlock(m_headOfMemory);
 }
 
 
@@ -275,7 +702,7 @@ void MemoryAllocatePool::Render()
 // 	float oneOverMemorySize = 1.0f / (float)m_memorySize;
 // 	int memoryAccumulate = 0;
 // 
-// 	MemorySpaceHeader* currentNode = m_headOfFreeSpace;
+// 	MemorySpaceHeader* currentNode = m_headOfMemory;
 // 	while (currentNode)
 // 	{
 // 		memoryAccumulate += currentNode->sizeInBytes;
@@ -1,41 +1,66 @@
 #pragma once
 
-#ifndef MEMORYALLOCATEPOOL_HPP 
+#ifndef MEMORYALLOCATEPOOL_HPP
 #define MEMORYALLOCATEPOOL_HPP
 
-// void* operator new(size_t size);
-// void operator delete(void * p);
-// 
-// void* operator new[](size_t size);
-// void operator delete[](void* ptr);
-// 
-// void* operator new(size_t size, const char* file, int line);
-// void operator delete(void* p, const char* file, int line);
-// 
-// void* operator new[](size_t size, const char* file, int line);
-// void operator delete[](void* p, const char* file, int line);
-
 #include <new>
+#include <mutex>
 #include "Engine\Core\VertexStruct.hpp"
+#include "Engine\Memory\MemoryTelemetry.hpp"
+
+// Define HENRY_MEMORY_OVERRIDE_NEW for the whole build to send global new / delete through a
+// MemoryAllocatePool that reserves HENRY_MEMORY_RESERVE_SIZE of address space and commits it on demand.
+// HENRY_MEMORY_USE_HUGE_PAGES asks for transparent huge pages on the reserved range.
+#if defined(HENRY_MEMORY_OVERRIDE_NEW)
+void* operator new(size_t size, const char* file, int line);
+void operator delete(void* p, const char* file, int line);
+void* operator new[](size_t size, const char* file, int line);
+void operator delete[](void* p, const char* file, int line);
 
-// #define DEBUG_NEW new(__FILE__, __LINE__)
-// #define new DEBUG_NEW
+#define HENRY_NEW new(__FILE__, __LINE__)
+#else
+#define HENRY_NEW new
+#endif
 
 
 namespace Henry
 {
 
+// Two-level segregated fit (TLSF) parameters.
+// Blocks below MEMORY_SMALL_BLOCK_SIZE are binned linearly , larger blocks are binned by
+// power of two (first level) and then split into MEMORY_SECOND_LEVEL_COUNT ranges (second level).
+const size_t MEMORY_ALIGNMENT_LOG2 = 4;
+const size_t MEMORY_ALIGNMENT = 1 << MEMORY_ALIGNMENT_LOG2;
+const size_t MEMORY_SECOND_LEVEL_LOG2 = 5;
+const size_t MEMORY_SECOND_LEVEL_COUNT = 1 << MEMORY_SECOND_LEVEL_LOG2;
+const size_t MEMORY_FIRST_LEVEL_SHIFT = MEMORY_SECOND_LEVEL_LOG2 + MEMORY_ALIGNMENT_LOG2;
+const size_t MEMORY_SMALL_BLOCK_SIZE = 1 << MEMORY_FIRST_LEVEL_SHIFT;
+const size_t MEMORY_FIRST_LEVEL_COUNT = 32;
+
+// Reserved mode only : commit in steps of this many bytes (2 MB with huge pages) ,
+// and hand the pages of free blocks at least this large back to the OS.
+const size_t MEMORY_COMMIT_GRANULARITY = 64 * 1024;
+const size_t MEMORY_HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+const size_t MEMORY_DISCARD_THRESHOLD = 256 * 1024;
 
-struct MemorySpaceHeader
+
+// Aligned so the block after a header keeps MEMORY_ALIGNMENT on 32 bit builds too.
+struct alignas(MEMORY_ALIGNMENT) MemorySpaceHeader
 {
 	bool available;
+	bool cached;					// parked in a MemoryThreadCache magazine
+	bool discarded;					// interior pages already handed back , only valid while available
+	unsigned char tag;
+	unsigned short callsite;		// index into MemoryTelemetry , only valid while allocated
 	const char* filename;
 	size_t line;
 	size_t sizeInBytes;
-	MemorySpaceHeader* prev;
+	MemorySpaceHeader* prev;		// physical neighbours
 	MemorySpaceHeader* next;
-	MemorySpaceHeader* nextSpac;
+	MemorySpaceHeader* prevFree;	// segregated free list , only valid while available
+	MemorySpaceHeader* nextFree;
 };
+static_assert(sizeof(MemorySpaceHeader) % MEMORY_ALIGNMENT == 0, "MemorySpaceHeader must keep blocks MEMORY_ALIGNMENT aligned");
 
 
 class MemoryAllocatePool
@@ -44,21 +69,50 @@ public:
 	MemoryAllocatePool();
 	~MemoryAllocatePool();
 	void Initialize(size_t numberOfBytes);
+	void InitializeReserved(size_t numberOfBytes, bool useHugePages = false);
 	void* AllocateMemory(size_t sizeRequired, const char* filename = "", int line = 0);
 	void FreeMemory(void* p, const char* filename = "", int line = 0);
+	size_t AllocateBatch(size_t sizeRequired, void** out_blocks, size_t count);
+	void FreeBatch(void** blocks, size_t count);
+	bool Owns(void* p) const { return (char*)p >= (char*)m_beginOfMemory && (char*)p < (char*)m_beginOfMemory + m_memorySize; };
+	static size_t GetBlockSize(void* p);
+	static void TagBlock(void* p, bool cached, const char* filename = "", int line = 0);
 	void ScanMemory();
+	void GetFreeBlockHistogram(MemoryFreeBlockHistogram& out_histogram);
+	bool WriteSnapshot(const char* filePath, MemorySnapshotFormat format = MEMORY_SNAPSHOT_JSON);
 	void Render();
 
 public:
 	size_t m_memorySize;
 	size_t m_allocatedSize;
 	size_t m_numberOfMemoryBlocks;
-	size_t m_largestSizeOfMemoryAllocated;
+	size_t m_largestSizeOfMemoryAllocated;		// largest single block ever handed out
+	size_t m_peakAllocatedSize;
+	size_t m_committedSize;
+	size_t m_numberOfDiscards;
+	MemoryTelemetry m_telemetry;
 
 	void* m_beginOfMemory;
 	MemorySpaceHeader* m_headOfMemory;
 	MemorySpaceHeader* m_tailOfMemory;
-	MemorySpaceHeader* m_headOfFreeSpace;
+
+private:
+	void InitializeBlocks();
+	bool EnsureCommitted(char* end);
+	void* AllocateMemoryLocked(size_t sizeRequired, const char* filename, int line, bool cached);
+	void FreeMemoryLocked(void* p);
+	void DiscardRange(char* begin, char* end, char* interiorBegin, char* interiorEnd);
+	void InsertFreeBlock(MemorySpaceHeader* block);
+	void RemoveFreeBlock(MemorySpaceHeader* block);
+	MemorySpaceHeader* FindFreeBlock(size_t sizeInBytes);
+
+	unsigned int m_firstLevelBitmap;
+	unsigned int m_secondLevelBitmap[MEMORY_FIRST_LEVEL_COUNT];
+	MemorySpaceHeader* m_freeLists[MEMORY_FIRST_LEVEL_COUNT][MEMORY_SECOND_LEVEL_COUNT];
+	std::mutex m_lock;
+	bool m_isReserved;
+	size_t m_commitGranularity;
+	char* m_committedEnd;
 };
 
 extern MemoryAllocatePool* _memoryAllocatePool;
@@ -0,0 +1,241 @@
+#include "MemoryResource.hpp"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <mutex>
+
+#include "Engine\Memory\MemoryAllocatePool.hpp"
+#include "Engine\Memory\FrameArena.hpp"
+#include "Engine\Core\HenryFunctions.hpp"
+
+#define UNUSED(x) (void)(x);
+
+
+namespace Henry
+{
+
+MemoryResource* MemoryResource::s_firstResource = nullptr;
+
+static std::mutex& GetResourceListLock()
+{
+	static std::mutex s_lock;
+	return s_lock;
+}
+
+
+MemoryResource::MemoryResource(const char* name)
+	: m_name(name)
+	, m_liveBytes(0)
+	, m_peakBytes(0)
+	, m_totalAllocations(0)
+	, m_prevResource(nullptr)
+{
+	std::lock_guard<std::mutex> guard(GetResourceListLock());
+	m_nextResource = s_firstResource;
+	if (s_firstResource)
+		s_firstResource->m_prevResource = this;
+	s_firstResource = this;
+}
+
+
+MemoryResource::~MemoryResource()
+{
+	std::lock_guard<std::mutex> guard(GetResourceListLock());
+	if (m_prevResource)
+		m_prevResource->m_nextResource = m_nextResource;
+	else
+		s_firstResource = m_nextResource;
+
+	if (m_nextResource)
+		m_nextResource->m_prevResource = m_prevResource;
+}
+
+
+void MemoryResource::CountAllocate(size_t bytes)
+{
+	m_totalAllocations.fetch_add(1, std::memory_order_relaxed);
+	size_t live = m_liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	size_t peak = m_peakBytes.load(std::memory_order_relaxed);
+	while (live > peak && !m_peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+	{
+	}
+}
+
+
+void MemoryResource::CountDeallocate(size_t bytes)
+{
+	m_liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+
+void MemoryResource::DumpStats()
+{
+	std::lock_guard<std::mutex> guard(GetResourceListLock());
+	DebuggerPrintf("%-24s %14s %14s %14s\n", "resource", "live bytes", "peak bytes", "allocations");
+	for (MemoryResource* resource = s_firstResource; resource; resource = resource->m_nextResource)
+		DebuggerPrintf("%-24s %14llu %14llu %14llu\n", resource->m_name, (unsigned long long)resource->GetLiveBytes(), (unsigned long long)resource->GetPeakBytes(), (unsigned long long)resource->GetTotalAllocations());
+}
+
+
+// operator new only promises max_align_t , bigger alignments over-allocate and keep the original
+// pointer just in front of the aligned block.
+static void* AllocateFromHeap(size_t bytes, size_t alignment)
+{
+	if (alignment <= alignof(max_align_t))
+		return ::operator new(bytes);
+
+	char* raw = (char*)::operator new(bytes + alignment + sizeof(void*));
+	char* p = (char*)(((size_t)raw + sizeof(void*) + alignment - 1) & ~(alignment - 1));
+	((void**)p)[-1] = raw;
+	return p;
+}
+
+
+static void FreeToHeap(void* p, size_t alignment)
+{
+	if (alignment <= alignof(max_align_t))
+		::operator delete(p);
+	else
+		::operator delete(((void**)p)[-1]);
+}
+
+
+MemoryResource* GetDefaultMemoryResource()
+{
+	static HeapMemoryResource s_heapResource("Heap");
+	return &s_heapResource;
+}
+
+
+void* HeapMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+	CountAllocate(bytes);
+	return AllocateFromHeap(bytes, alignment);
+}
+
+
+void HeapMemoryResource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+	CountDeallocate(bytes);
+	FreeToHeap(p, alignment);
+}
+
+
+MemoryAllocatePool* PoolMemoryResource::GetPool() const
+{
+	return m_pool ? m_pool : _memoryAllocatePool;
+}
+
+
+// The pool hands out MEMORY_ALIGNMENT , anything stricter goes to the heap.
+void* PoolMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+	CountAllocate(bytes);
+	MemoryAllocatePool* pool = GetPool();
+	if (pool && alignment <= MEMORY_ALIGNMENT)
+		return pool->AllocateMemory(bytes, m_name, 0);
+
+	return AllocateFromHeap(bytes, alignment);
+}
+
+
+void PoolMemoryResource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+	CountDeallocate(bytes);
+	MemoryAllocatePool* pool = GetPool();
+	if (pool && alignment <= MEMORY_ALIGNMENT && pool->Owns(p))
+		pool->FreeMemory(p);
+	else
+		FreeToHeap(p, alignment);
+}
+
+
+void* FrameMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+	FrameArena* arena = m_arena ? m_arena : _frameArena;
+	if (arena == nullptr)
+		throw std::bad_alloc();
+
+	CountAllocate(bytes);
+	return arena->Allocate(bytes, alignment < MEMORY_RESOURCE_DEFAULT_ALIGNMENT ? MEMORY_RESOURCE_DEFAULT_ALIGNMENT : alignment);
+}
+
+
+void FrameMemoryResource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+	UNUSED(p);
+	UNUSED(alignment);
+	CountDeallocate(bytes);
+}
+
+
+MonotonicMemoryResource::MonotonicMemoryResource(const char* name, size_t initialChunkSize, MemoryResourceBase* upstream)
+	: MemoryResource(name)
+	, m_upstream(upstream ? upstream : GetDefaultMemoryResource())
+	, m_chunks(nullptr)
+	, m_nextChunkSize(initialChunkSize < MONOTONIC_MINIMUM_CHUNK_SIZE ? MONOTONIC_MINIMUM_CHUNK_SIZE : initialChunkSize)
+	, m_current(nullptr)
+	, m_end(nullptr)
+	, m_bytesHandedOut(0)
+{
+}
+
+
+MonotonicMemoryResource::~MonotonicMemoryResource()
+{
+	Release();
+}
+
+
+void MonotonicMemoryResource::Release()
+{
+	while (m_chunks)
+	{
+		MonotonicChunk* chunk = m_chunks;
+		m_chunks = chunk->next;
+		m_upstream->deallocate(chunk, chunk->sizeInBytes, MEMORY_RESOURCE_DEFAULT_ALIGNMENT);
+	}
+
+	CountDeallocate(m_bytesHandedOut);
+	m_bytesHandedOut = 0;
+	m_current = nullptr;
+	m_end = nullptr;
+}
+
+
+void* MonotonicMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+	char* p = (char*)(((size_t)m_current + alignment - 1) & ~(alignment - 1));
+	if (m_current == nullptr || p + bytes > m_end)
+	{
+		size_t headerSize = (sizeof(MonotonicChunk) + MEMORY_RESOURCE_DEFAULT_ALIGNMENT - 1) & ~(MEMORY_RESOURCE_DEFAULT_ALIGNMENT - 1);
+		size_t chunkSize = m_nextChunkSize;
+		while (chunkSize < headerSize + bytes + alignment)
+			chunkSize *= 2;
+		m_nextChunkSize = chunkSize * 2;
+
+		MonotonicChunk* chunk = (MonotonicChunk*)m_upstream->allocate(chunkSize, MEMORY_RESOURCE_DEFAULT_ALIGNMENT);
+		chunk->next = m_chunks;
+		chunk->sizeInBytes = chunkSize;
+		m_chunks = chunk;
+		m_current = (char*)chunk + headerSize;
+		m_end = (char*)chunk + chunkSize;
+		p = (char*)(((size_t)m_current + alignment - 1) & ~(alignment - 1));
+	}
+
+	m_current = p + bytes;
+	m_bytesHandedOut += bytes;
+	CountAllocate(bytes);
+	return p;
+}
+
+
+void MonotonicMemoryResource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+	UNUSED(p);
+	UNUSED(bytes);
+	UNUSED(alignment);
+}
+
+
+};
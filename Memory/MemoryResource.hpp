@@ -0,0 +1,208 @@
+#pragma once
+
+#ifndef MEMORYRESOURCE_HPP
+#define MEMORYRESOURCE_HPP
+
+#include <stddef.h>
+#include <atomic>
+#include <map>
+#include <vector>
+#include <functional>
+#include <utility>
+#include <new>
+
+#if (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || __cplusplus >= 201703L
+#if !defined(__has_include)
+#define HENRY_HAS_PMR 1
+#elif __has_include(<memory_resource>)
+#define HENRY_HAS_PMR 1
+#endif
+#endif
+
+#if defined(HENRY_HAS_PMR)
+#include <memory_resource>
+#define HENRY_RESOURCE_NOEXCEPT noexcept
+#else
+#define HENRY_RESOURCE_NOEXCEPT
+#endif
+
+
+namespace Henry
+{
+
+class MemoryAllocatePool;
+class FrameArena;
+
+const size_t MEMORY_RESOURCE_DEFAULT_ALIGNMENT = 16;
+const size_t MONOTONIC_MINIMUM_CHUNK_SIZE = 256;
+
+
+// With C++17 the engine resources are std::pmr::memory_resource and can back std::pmr containers.
+// Older compilers get the same interface here so ResourceAllocator works either way.
+#if defined(HENRY_HAS_PMR)
+typedef std::pmr::memory_resource MemoryResourceBase;
+#else
+class MemoryResourceBase
+{
+public:
+	virtual ~MemoryResourceBase() {};
+	void* allocate(size_t bytes, size_t alignment = MEMORY_RESOURCE_DEFAULT_ALIGNMENT) { return do_allocate(bytes, alignment); };
+	void deallocate(void* p, size_t bytes, size_t alignment = MEMORY_RESOURCE_DEFAULT_ALIGNMENT) { do_deallocate(p, bytes, alignment); };
+	bool is_equal(const MemoryResourceBase& other) const { return do_is_equal(other); };
+
+private:
+	virtual void* do_allocate(size_t bytes, size_t alignment) = 0;
+	virtual void do_deallocate(void* p, size_t bytes, size_t alignment) = 0;
+	virtual bool do_is_equal(const MemoryResourceBase& other) const HENRY_RESOURCE_NOEXCEPT = 0;
+};
+#endif
+
+
+// Named resource with byte counters. Every resource links itself into a global list
+// so DumpStats can show which subsystem owns how much memory.
+class MemoryResource : public MemoryResourceBase
+{
+public:
+	MemoryResource(const char* name);
+	virtual ~MemoryResource();
+	const char* GetName() const { return m_name; };
+	size_t GetLiveBytes() const { return m_liveBytes.load(std::memory_order_relaxed); };
+	size_t GetPeakBytes() const { return m_peakBytes.load(std::memory_order_relaxed); };
+	size_t GetTotalAllocations() const { return m_totalAllocations.load(std::memory_order_relaxed); };
+	static void DumpStats();
+	static MemoryResource* GetFirstResource() { return s_firstResource; };
+	MemoryResource* GetNextResource() const { return m_nextResource; };
+
+protected:
+	void CountAllocate(size_t bytes);
+	void CountDeallocate(size_t bytes);
+	virtual bool do_is_equal(const MemoryResourceBase& other) const HENRY_RESOURCE_NOEXCEPT { return this == &other; };
+
+	const char* m_name;
+
+private:
+	MemoryResource(const MemoryResource&);
+	void operator=(const MemoryResource&);
+
+	std::atomic<size_t> m_liveBytes;
+	std::atomic<size_t> m_peakBytes;
+	std::atomic<size_t> m_totalAllocations;
+	MemoryResource* m_prevResource;
+	MemoryResource* m_nextResource;
+	static MemoryResource* s_firstResource;
+};
+
+
+class HeapMemoryResource : public MemoryResource
+{
+public:
+	HeapMemoryResource(const char* name) : MemoryResource(name) {};
+
+private:
+	virtual void* do_allocate(size_t bytes, size_t alignment);
+	virtual void do_deallocate(void* p, size_t bytes, size_t alignment);
+};
+
+
+// Blocks come from _memoryAllocatePool (or the given pool) , falls back to the heap before one exists.
+class PoolMemoryResource : public MemoryResource
+{
+public:
+	PoolMemoryResource(const char* name, MemoryAllocatePool* pool = nullptr) : MemoryResource(name) , m_pool(pool) {};
+
+private:
+	virtual void* do_allocate(size_t bytes, size_t alignment);
+	virtual void do_deallocate(void* p, size_t bytes, size_t alignment);
+	MemoryAllocatePool* GetPool() const;
+
+	MemoryAllocatePool* m_pool;
+};
+
+
+// Memory lives until the frame after next , deallocate does nothing.
+class FrameMemoryResource : public MemoryResource
+{
+public:
+	FrameMemoryResource(const char* name, FrameArena* arena = nullptr) : MemoryResource(name) , m_arena(arena) {};
+
+private:
+	virtual void* do_allocate(size_t bytes, size_t alignment);
+	virtual void do_deallocate(void* p, size_t bytes, size_t alignment);
+
+	FrameArena* m_arena;
+};
+
+
+struct MonotonicChunk
+{
+	MonotonicChunk* next;
+	size_t sizeInBytes;
+};
+
+
+// Bump allocator over growing chunks from an upstream resource , memory is only given back by Release.
+class MonotonicMemoryResource : public MemoryResource
+{
+public:
+	MonotonicMemoryResource(const char* name, size_t initialChunkSize = 4096, MemoryResourceBase* upstream = nullptr);
+	~MonotonicMemoryResource();
+	void Release();
+
+private:
+	virtual void* do_allocate(size_t bytes, size_t alignment);
+	virtual void do_deallocate(void* p, size_t bytes, size_t alignment);
+
+	MemoryResourceBase* m_upstream;
+	MonotonicChunk* m_chunks;
+	size_t m_nextChunkSize;
+	char* m_current;
+	char* m_end;
+	size_t m_bytesHandedOut;
+};
+
+
+MemoryResource* GetDefaultMemoryResource();
+
+
+template <class T>
+class ResourceAllocator
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	template <class U> struct rebind { typedef ResourceAllocator<U> other; };
+
+	ResourceAllocator() : m_resource(GetDefaultMemoryResource()) {};
+	ResourceAllocator(MemoryResourceBase* resource) : m_resource(resource) {};
+	template <class U> ResourceAllocator(const ResourceAllocator<U>& other) : m_resource(other.m_resource) {};
+
+	T* allocate(size_t count) { return (T*)m_resource->allocate(count * sizeof(T), __alignof(T)); };
+	void deallocate(T* p, size_t count) { m_resource->deallocate(p, count * sizeof(T), __alignof(T)); };
+	size_t max_size() const { return ((size_t)-1) / sizeof(T); };
+	template <class U, class... Args> void construct(U* p, Args&&... args) { new ((void*)p) U(std::forward<Args>(args)...); };
+	template <class U> void destroy(U* p) { p->~U(); };
+
+	MemoryResourceBase* m_resource;
+};
+
+template <class T, class U>
+inline bool operator==(const ResourceAllocator<T>& lhs, const ResourceAllocator<U>& rhs) { return lhs.m_resource == rhs.m_resource || lhs.m_resource->is_equal(*rhs.m_resource); }
+
+template <class T, class U>
+inline bool operator!=(const ResourceAllocator<T>& lhs, const ResourceAllocator<U>& rhs) { return !(lhs == rhs); }
+
+
+template <class Key, class Value, class Compare = std::less<Key> >
+using ResourceMap = std::map<Key, Value, Compare, ResourceAllocator<std::pair<const Key, Value> > >;
+
+template <class T>
+using ResourceVector = std::vector<T, ResourceAllocator<T> >;
+
+};
+
+#endif
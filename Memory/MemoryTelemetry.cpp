@@ -0,0 +1,268 @@
+#include "MemoryTelemetry.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+
+namespace Henry
+{
+
+MemorySourceStats MemoryTelemetry::s_tags[MEMORY_TAG_CAPACITY];
+std::atomic<size_t> MemoryTelemetry::s_numberOfTags(0);
+std::mutex MemoryTelemetry::s_tagLock;
+
+static thread_local unsigned char s_currentTag = 0;
+
+
+static inline size_t HashCallsite(const char* filename, int line)
+{
+	size_t hash = ((size_t)filename >> 3) ^ ((size_t)line * 2654435761u);
+	hash ^= hash >> 15;
+	return hash & (MEMORY_CALLSITE_CAPACITY - 1);
+}
+
+
+MemoryTelemetry::MemoryTelemetry()
+	: m_numberOfCallsites(1)
+{
+	for (size_t index = 0; index < MEMORY_CALLSITE_CAPACITY; ++index)
+	{
+		m_callsiteUsed[index].store(false, std::memory_order_relaxed);
+		ResetSource(m_callsites[index], "", 0);
+	}
+
+	// slot 0 is the unknown callsite , blocks allocated without file and line end up there
+	m_callsites[0].m_name = "unknown";
+	m_callsiteUsed[0].store(true, std::memory_order_release);
+	m_callsiteOrder[0] = 0;
+
+	if (s_numberOfTags.load(std::memory_order_acquire) == 0)
+		RegisterTag("Untagged");
+}
+
+
+void MemoryTelemetry::ResetSource(MemorySourceStats& stats, const char* name, int line)
+{
+	stats.m_name = name;
+	stats.m_line = line;
+	stats.m_liveBytes.store(0, std::memory_order_relaxed);
+	stats.m_liveCount.store(0, std::memory_order_relaxed);
+	stats.m_highWaterBytes.store(0, std::memory_order_relaxed);
+	stats.m_totalAllocations.store(0, std::memory_order_relaxed);
+	stats.m_totalBytes.store(0, std::memory_order_relaxed);
+	stats.m_allocationsAtLastSample = 0;
+	stats.m_allocationsPerSecond = 0.0;
+}
+
+
+unsigned short MemoryTelemetry::FindCallsite(const char* filename, int line)
+{
+	if (filename == nullptr || filename[0] == '\0')
+		return 0;
+
+	size_t slot = HashCallsite(filename, line);
+	for (size_t probe = 0; probe < MEMORY_CALLSITE_CAPACITY; ++probe, slot = (slot + 1) & (MEMORY_CALLSITE_CAPACITY - 1))
+	{
+		if (slot == 0)
+			continue;
+
+		if (!m_callsiteUsed[slot].load(std::memory_order_acquire))
+		{
+			std::lock_guard<std::mutex> guard(m_registerLock);
+			if (!m_callsiteUsed[slot].load(std::memory_order_acquire))
+			{
+				ResetSource(m_callsites[slot], filename, line);
+				m_callsiteOrder[m_numberOfCallsites.load(std::memory_order_relaxed)] = (unsigned short)slot;
+				m_callsiteUsed[slot].store(true, std::memory_order_release);
+				m_numberOfCallsites.fetch_add(1, std::memory_order_release);
+				return (unsigned short)slot;
+			}
+		}
+
+		if (m_callsites[slot].m_name == filename && m_callsites[slot].m_line == line)
+			return (unsigned short)slot;
+	}
+
+	return 0;
+}
+
+
+void MemoryTelemetry::Record(MemorySourceStats& stats, size_t sizeInBytes)
+{
+	stats.m_totalAllocations.fetch_add(1, std::memory_order_relaxed);
+	stats.m_totalBytes.fetch_add(sizeInBytes, std::memory_order_relaxed);
+	stats.m_liveCount.fetch_add(1, std::memory_order_relaxed);
+	size_t live = stats.m_liveBytes.fetch_add(sizeInBytes, std::memory_order_relaxed) + sizeInBytes;
+	size_t highWater = stats.m_highWaterBytes.load(std::memory_order_relaxed);
+	while (live > highWater && !stats.m_highWaterBytes.compare_exchange_weak(highWater, live, std::memory_order_relaxed))
+	{
+	}
+}
+
+
+void MemoryTelemetry::RecordAllocate(unsigned short callsite, unsigned char tag, size_t sizeInBytes)
+{
+	Record(m_callsites[callsite], sizeInBytes);
+	Record(s_tags[tag], sizeInBytes);
+}
+
+
+void MemoryTelemetry::RecordFree(unsigned short callsite, unsigned char tag, size_t sizeInBytes)
+{
+	m_callsites[callsite].m_liveCount.fetch_sub(1, std::memory_order_relaxed);
+	m_callsites[callsite].m_liveBytes.fetch_sub(sizeInBytes, std::memory_order_relaxed);
+	s_tags[tag].m_liveCount.fetch_sub(1, std::memory_order_relaxed);
+	s_tags[tag].m_liveBytes.fetch_sub(sizeInBytes, std::memory_order_relaxed);
+}
+
+
+void MemoryTelemetry::UpdateRates(double deltaSeconds)
+{
+	if (deltaSeconds <= 0.0)
+		return;
+
+	double oneOverDeltaSeconds = 1.0 / deltaSeconds;
+	size_t numberOfCallsites = GetNumberOfCallsites();
+	for (size_t index = 0; index < numberOfCallsites; ++index)
+	{
+		MemorySourceStats& stats = m_callsites[m_callsiteOrder[index]];
+		size_t total = stats.m_totalAllocations.load(std::memory_order_relaxed);
+		stats.m_allocationsPerSecond = (total - stats.m_allocationsAtLastSample) * oneOverDeltaSeconds;
+		stats.m_allocationsAtLastSample = total;
+	}
+
+	size_t numberOfTags = GetNumberOfTags();
+	for (size_t index = 0; index < numberOfTags; ++index)
+	{
+		size_t total = s_tags[index].m_totalAllocations.load(std::memory_order_relaxed);
+		s_tags[index].m_allocationsPerSecond = (total - s_tags[index].m_allocationsAtLastSample) * oneOverDeltaSeconds;
+		s_tags[index].m_allocationsAtLastSample = total;
+	}
+}
+
+
+unsigned char MemoryTelemetry::RegisterTag(const char* name)
+{
+	std::lock_guard<std::mutex> guard(s_tagLock);
+	size_t numberOfTags = s_numberOfTags.load(std::memory_order_relaxed);
+	for (size_t index = 0; index < numberOfTags; ++index)
+	{
+		if (strcmp(s_tags[index].m_name, name) == 0)
+			return (unsigned char)index;
+	}
+
+	if (numberOfTags == MEMORY_TAG_CAPACITY)
+		return 0;
+
+	ResetSource(s_tags[numberOfTags], name, 0);
+	s_numberOfTags.store(numberOfTags + 1, std::memory_order_release);
+	return (unsigned char)numberOfTags;
+}
+
+
+unsigned char MemoryTelemetry::GetCurrentTag()
+{
+	return s_currentTag;
+}
+
+
+unsigned char MemoryTelemetry::SetCurrentTag(unsigned char tag)
+{
+	unsigned char previousTag = s_currentTag;
+	s_currentTag = tag;
+	return previousTag;
+}
+
+
+static void WriteSourceCSV(FILE* file, const char* kind, const MemorySourceStats& stats)
+{
+	fprintf(file, "%s,\"%s\",%d,%llu,%llu,%llu,%llu,%llu,%.2f\n", kind, stats.m_name, stats.m_line,
+		(unsigned long long)stats.m_liveBytes.load(std::memory_order_relaxed),
+		(unsigned long long)stats.m_liveCount.load(std::memory_order_relaxed),
+		(unsigned long long)stats.m_highWaterBytes.load(std::memory_order_relaxed),
+		(unsigned long long)stats.m_totalAllocations.load(std::memory_order_relaxed),
+		(unsigned long long)stats.m_totalBytes.load(std::memory_order_relaxed),
+		stats.m_allocationsPerSecond);
+}
+
+
+static void WriteSourceJSON(FILE* file, const MemorySourceStats& stats, bool last)
+{
+	fprintf(file, "    { \"name\": \"");
+	for (const char* c = stats.m_name; *c; ++c)
+	{
+		if (*c == '\\' || *c == '"')
+			fputc('\\', file);
+		fputc(*c, file);
+	}
+	fprintf(file, "\", \"line\": %d, \"liveBytes\": %llu, \"liveCount\": %llu, \"highWaterBytes\": %llu, \"totalAllocations\": %llu, \"totalBytes\": %llu, \"allocationsPerSecond\": %.2f }%s\n",
+		stats.m_line,
+		(unsigned long long)stats.m_liveBytes.load(std::memory_order_relaxed),
+		(unsigned long long)stats.m_liveCount.load(std::memory_order_relaxed),
+		(unsigned long long)stats.m_highWaterBytes.load(std::memory_order_relaxed),
+		(unsigned long long)stats.m_totalAllocations.load(std::memory_order_relaxed),
+		(unsigned long long)stats.m_totalBytes.load(std::memory_order_relaxed),
+		stats.m_allocationsPerSecond, last ? "" : ",");
+}
+
+
+bool MemoryTelemetry::WriteSnapshot(const char* filePath, MemorySnapshotFormat format, const MemoryFreeBlockHistogram& histogram, size_t poolSize, size_t allocatedSize, size_t peakAllocatedSize)
+{
+	FILE* file = nullptr;
+#if defined(_MSC_VER)
+	fopen_s(&file, filePath, "w");
+#else
+	file = fopen(filePath, "w");
+#endif
+	if (file == nullptr)
+		return false;
+
+	size_t numberOfCallsites = GetNumberOfCallsites();
+	size_t numberOfTags = GetNumberOfTags();
+
+	if (format == MEMORY_SNAPSHOT_CSV)
+	{
+		fprintf(file, "kind,name,line,liveBytes,liveCount,highWaterBytes,totalAllocations,totalBytes,allocationsPerSecond\n");
+		fprintf(file, "pool,\"size\",0,%llu,0,%llu,0,%llu,0\n", (unsigned long long)allocatedSize, (unsigned long long)peakAllocatedSize, (unsigned long long)poolSize);
+		for (size_t index = 0; index < numberOfTags; ++index)
+			WriteSourceCSV(file, "tag", s_tags[index]);
+		for (size_t index = 0; index < numberOfCallsites; ++index)
+			WriteSourceCSV(file, "callsite", GetCallsite(index));
+
+		fprintf(file, "\nfreeBucketBytes,freeBlocks,freeBytes\n");
+		for (size_t bucket = 0; bucket < MEMORY_FREE_HISTOGRAM_BUCKETS; ++bucket)
+		{
+			if (histogram.m_blockCount[bucket] != 0)
+				fprintf(file, "%llu,%llu,%llu\n", 1ull << bucket, (unsigned long long)histogram.m_blockCount[bucket], (unsigned long long)histogram.m_blockBytes[bucket]);
+		}
+		fprintf(file, "\nfreeBlocks,freeBytes,largestFreeBlock,fragmentation\n%llu,%llu,%llu,%.4f\n", (unsigned long long)histogram.m_numberOfFreeBlocks,
+			(unsigned long long)histogram.m_totalFreeBytes, (unsigned long long)histogram.m_largestFreeBlock, histogram.m_fragmentation);
+	}
+	else
+	{
+		fprintf(file, "{\n  \"pool\": { \"size\": %llu, \"allocatedBytes\": %llu, \"peakAllocatedBytes\": %llu },\n", (unsigned long long)poolSize, (unsigned long long)allocatedSize, (unsigned long long)peakAllocatedSize);
+		fprintf(file, "  \"free\": { \"blocks\": %llu, \"bytes\": %llu, \"largestBlock\": %llu, \"fragmentation\": %.4f, \"histogram\": [",
+			(unsigned long long)histogram.m_numberOfFreeBlocks, (unsigned long long)histogram.m_totalFreeBytes, (unsigned long long)histogram.m_largestFreeBlock, histogram.m_fragmentation);
+		bool first = true;
+		for (size_t bucket = 0; bucket < MEMORY_FREE_HISTOGRAM_BUCKETS; ++bucket)
+		{
+			if (histogram.m_blockCount[bucket] == 0)
+				continue;
+			fprintf(file, "%s{ \"minBytes\": %llu, \"blocks\": %llu, \"bytes\": %llu }", first ? " " : ", ", 1ull << bucket, (unsigned long long)histogram.m_blockCount[bucket], (unsigned long long)histogram.m_blockBytes[bucket]);
+			first = false;
+		}
+		fprintf(file, " ] },\n  \"tags\": [\n");
+		for (size_t index = 0; index < numberOfTags; ++index)
+			WriteSourceJSON(file, s_tags[index], index + 1 == numberOfTags);
+		fprintf(file, "  ],\n  \"callsites\": [\n");
+		for (size_t index = 0; index < numberOfCallsites; ++index)
+			WriteSourceJSON(file, GetCallsite(index), index + 1 == numberOfCallsites);
+		fprintf(file, "  ]\n}\n");
+	}
+
+	fclose(file);
+	return true;
+}
+
+
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#ifndef MEMORYTELEMETRY_HPP
+#define MEMORYTELEMETRY_HPP
+
+#include <stddef.h>
+#include <atomic>
+#include <mutex>
+
+
+namespace Henry
+{
+
+const size_t MEMORY_CALLSITE_CAPACITY = 4096;
+const size_t MEMORY_TAG_CAPACITY = 64;
+const size_t MEMORY_FREE_HISTOGRAM_BUCKETS = 48;
+
+enum MemorySnapshotFormat { MEMORY_SNAPSHOT_CSV = 0 , MEMORY_SNAPSHOT_JSON };
+
+
+// Counters for one allocation source , a callsite (file:line) or a subsystem tag.
+// Live numbers only count blocks handed to the user , blocks parked in thread caches are excluded.
+struct MemorySourceStats
+{
+	const char* m_name;
+	int m_line;
+	std::atomic<size_t> m_liveBytes;
+	std::atomic<size_t> m_liveCount;
+	std::atomic<size_t> m_highWaterBytes;
+	std::atomic<size_t> m_totalAllocations;
+	std::atomic<size_t> m_totalBytes;
+	size_t m_allocationsAtLastSample;
+	double m_allocationsPerSecond;
+};
+
+
+struct MemoryFreeBlockHistogram
+{
+	size_t m_blockCount[MEMORY_FREE_HISTOGRAM_BUCKETS];		// bucket n holds free blocks of [2^n , 2^(n+1)) bytes
+	size_t m_blockBytes[MEMORY_FREE_HISTOGRAM_BUCKETS];
+	size_t m_numberOfFreeBlocks;
+	size_t m_totalFreeBytes;
+	size_t m_largestFreeBlock;
+	float m_fragmentation;									// 1 - largest / total , 0 when all free memory is one block
+};
+
+
+// Allocation telemetry kept by MemoryAllocatePool.
+// Callsites are interned into a fixed open addressing table so recording never allocates ,
+// the index is stored in the block header and used again when the block is freed.
+// Subsystem tags are set per thread with MEMORY_TAG_SCOPE("Name").
+// Profiler::EndFrame calls UpdateRates for the global pool , other pools have to call it once a frame themselves.
+class MemoryTelemetry
+{
+public:
+	MemoryTelemetry();
+	unsigned short FindCallsite(const char* filename, int line);
+	void RecordAllocate(unsigned short callsite, unsigned char tag, size_t sizeInBytes);
+	void RecordFree(unsigned short callsite, unsigned char tag, size_t sizeInBytes);
+	void UpdateRates(double deltaSeconds);
+	size_t GetNumberOfCallsites() const { return m_numberOfCallsites.load(std::memory_order_acquire); };
+	const MemorySourceStats& GetCallsite(size_t index) const { return m_callsites[m_callsiteOrder[index]]; };
+	const MemorySourceStats& GetTag(size_t index) const { return s_tags[index]; };
+	bool WriteSnapshot(const char* filePath, MemorySnapshotFormat format, const MemoryFreeBlockHistogram& histogram, size_t poolSize, size_t allocatedSize, size_t peakAllocatedSize);
+
+	static unsigned char RegisterTag(const char* name);
+	static size_t GetNumberOfTags() { return s_numberOfTags.load(std::memory_order_acquire); };
+	static unsigned char GetCurrentTag();
+	static unsigned char SetCurrentTag(unsigned char tag);
+
+private:
+	MemoryTelemetry(const MemoryTelemetry&);
+	void operator=(const MemoryTelemetry&);
+	static void Record(MemorySourceStats& stats, size_t sizeInBytes);
+	static void ResetSource(MemorySourceStats& stats, const char* name, int line);
+
+	MemorySourceStats m_callsites[MEMORY_CALLSITE_CAPACITY];
+	std::atomic<bool> m_callsiteUsed[MEMORY_CALLSITE_CAPACITY];
+	unsigned short m_callsiteOrder[MEMORY_CALLSITE_CAPACITY];
+	std::atomic<size_t> m_numberOfCallsites;
+	std::mutex m_registerLock;
+
+	static MemorySourceStats s_tags[MEMORY_TAG_CAPACITY];
+	static std::atomic<size_t> s_numberOfTags;
+	static std::mutex s_tagLock;
+};
+
+
+class MemoryTagScope
+{
+public:
+	MemoryTagScope(unsigned char tag) : m_previousTag(MemoryTelemetry::SetCurrentTag(tag)) {};
+	~MemoryTagScope() { MemoryTelemetry::SetCurrentTag(m_previousTag); };
+
+private:
+	unsigned char m_previousTag;
+};
+
+#define MEMORY_TAG_CONCAT_INNER(a, b) a##b
+#define MEMORY_TAG_CONCAT(a, b) MEMORY_TAG_CONCAT_INNER(a, b)
+#define MEMORY_TAG_SCOPE(name) \
+	static const unsigned char MEMORY_TAG_CONCAT(s_memoryTag, __LINE__) = Henry::MemoryTelemetry::RegisterTag(name); \
+	Henry::MemoryTagScope MEMORY_TAG_CONCAT(memoryTagScope, __LINE__)(MEMORY_TAG_CONCAT(s_memoryTag, __LINE__))
+
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include "MemoryThreadCache.hpp"
+
+#include <new>
+#include "Engine\Memory\MemoryAllocatePool.hpp"
+
+
+namespace Henry
+{
+
+static inline size_t GetSizeClassIndex(size_t blockSize)
+{
+	if (blockSize == 0)
+		return 0;
+
+	return (blockSize + MEMORY_CACHE_CLASS_GRANULARITY - 1) / MEMORY_CACHE_CLASS_GRANULARITY - 1;
+}
+
+
+MemoryThreadCache::MemoryThreadCache()
+	: m_numberOfRefills(0)
+	, m_numberOfDrains(0)
+{
+	for (size_t index = 0; index < MEMORY_CACHE_CLASS_COUNT; ++index)
+		m_magazines[index].m_count = 0;
+}
+
+
+MemoryThreadCache::~MemoryThreadCache()
+{
+	Flush();
+}
+
+
+MemoryThreadCache* MemoryThreadCache::GetThreadCache()
+{
+	static thread_local MemoryThreadCache s_threadCache;
+	return &s_threadCache;
+}
+
+
+void* MemoryThreadCache::AllocateMemory(size_t sizeRequired, const char* filename, int line)
+{
+	if (!_memoryAllocatePool)
+		throw std::bad_alloc();
+
+	if (sizeRequired > MEMORY_CACHE_MAX_BLOCK_SIZE)
+		return _memoryAllocatePool->AllocateMemory(sizeRequired, filename, line);
+
+	size_t classIndex = GetSizeClassIndex(sizeRequired);
+	MemoryMagazine& magazine = m_magazines[classIndex];
+	if (magazine.m_count == 0)
+		Refill(magazine, (classIndex + 1) * MEMORY_CACHE_CLASS_GRANULARITY);
+
+	void* p = magazine.m_blocks[--magazine.m_count];
+	MemoryAllocatePool::TagBlock(p, false, filename, line);
+	return p;
+}
+
+
+void MemoryThreadCache::FreeMemory(void* p)
+{
+	if (p == nullptr)
+		return;
+
+	size_t blockSize = MemoryAllocatePool::GetBlockSize(p);
+	if (blockSize > MEMORY_CACHE_MAX_BLOCK_SIZE)
+	{
+		_memoryAllocatePool->FreeMemory(p);
+		return;
+	}
+
+	// a block is filed under the largest class it can serve
+	size_t classIndex = blockSize / MEMORY_CACHE_CLASS_GRANULARITY - 1;
+	MemoryMagazine& magazine = m_magazines[classIndex];
+	if (magazine.m_count == MEMORY_CACHE_MAGAZINE_CAPACITY)
+		Drain(magazine, MEMORY_CACHE_BATCH_SIZE);
+
+	MemoryAllocatePool::TagBlock(p, true);
+	magazine.m_blocks[magazine.m_count++] = p;
+}
+
+
+void MemoryThreadCache::Flush()
+{
+	if (!_memoryAllocatePool)
+		return;
+
+	for (size_t index = 0; index < MEMORY_CACHE_CLASS_COUNT; ++index)
+		Drain(m_magazines[index], m_magazines[index].m_count);
+}
+
+
+void MemoryThreadCache::Refill(MemoryMagazine& magazine, size_t blockSize)
+{
+	++m_numberOfRefills;
+	magazine.m_count = _memoryAllocatePool->AllocateBatch(blockSize, magazine.m_blocks, MEMORY_CACHE_BATCH_SIZE);
+	if (magazine.m_count == 0)
+		throw std::bad_alloc();
+}
+
+
+void MemoryThreadCache::Drain(MemoryMagazine& magazine, size_t numberOfBlocks)
+{
+	if (numberOfBlocks == 0)
+		return;
+
+	++m_numberOfDrains;
+	magazine.m_count -= numberOfBlocks;
+	_memoryAllocatePool->FreeBatch(&magazine.m_blocks[magazine.m_count], numberOfBlocks);
+}
+
+
+};
\ No newline at end of file
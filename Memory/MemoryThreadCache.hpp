@@ -0,0 +1,63 @@
+#pragma once
+
+#ifndef MEMORYTHREADCACHE_HPP
+#define MEMORYTHREADCACHE_HPP
+
+#include <stddef.h>
+
+
+namespace Henry
+{
+
+// Small blocks are cached per thread in magazines , one per 16 byte size class.
+// A magazine refills from and drains to the shared MemoryAllocatePool in batches ,
+// so the central lock is taken once per MEMORY_CACHE_BATCH_SIZE blocks instead of once per block.
+const size_t MEMORY_CACHE_CLASS_GRANULARITY = 16;
+const size_t MEMORY_CACHE_CLASS_COUNT = 32;
+const size_t MEMORY_CACHE_MAX_BLOCK_SIZE = MEMORY_CACHE_CLASS_GRANULARITY * MEMORY_CACHE_CLASS_COUNT;
+const size_t MEMORY_CACHE_MAGAZINE_CAPACITY = 128;
+const size_t MEMORY_CACHE_BATCH_SIZE = 32;
+
+
+struct MemoryMagazine
+{
+	void* m_blocks[MEMORY_CACHE_MAGAZINE_CAPACITY];
+	size_t m_count;
+};
+
+
+class MemoryThreadCache
+{
+public:
+	MemoryThreadCache();
+	~MemoryThreadCache();
+	void* AllocateMemory(size_t sizeRequired, const char* filename = "", int line = 0);
+	void FreeMemory(void* p);
+	void Flush();
+	static MemoryThreadCache* GetThreadCache();
+
+public:
+	size_t m_numberOfRefills;
+	size_t m_numberOfDrains;
+
+private:
+	void Refill(MemoryMagazine& magazine, size_t blockSize);
+	void Drain(MemoryMagazine& magazine, size_t numberOfBlocks);
+	MemoryMagazine m_magazines[MEMORY_CACHE_CLASS_COUNT];
+};
+
+
+inline void* ThreadCacheAllocate(size_t sizeRequired, const char* filename = "", int line = 0)
+{
+	return MemoryThreadCache::GetThreadCache()->AllocateMemory(sizeRequired, filename, line);
+}
+
+
+inline void ThreadCacheFree(void* p)
+{
+	MemoryThreadCache::GetThreadCache()->FreeMemory(p);
+}
+
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "ObjectPool.hpp"
+
+#include <stdlib.h>
+
+
+namespace Henry
+{
+
+static const size_t THREAD_CACHE_SLOTS = 16;
+static const size_t THREAD_CACHE_MAX_OBJECTS = 64;
+static const size_t THREAD_CACHE_BATCH_SIZE = 32;
+
+
+struct ObjectPoolThreadCacheEntry
+{
+	ObjectPoolBase* pool;
+	ObjectPoolFreeNode* head;
+	size_t count;
+};
+
+
+struct ObjectPoolThreadCache
+{
+	ObjectPoolThreadCache() { for (size_t index = 0; index < THREAD_CACHE_SLOTS; ++index) { m_entries[index].pool = nullptr; m_entries[index].head = nullptr; m_entries[index].count = 0; } };
+	~ObjectPoolThreadCache()
+	{
+		for (size_t index = 0; index < THREAD_CACHE_SLOTS; ++index)
+		{
+			if (m_entries[index].pool && m_entries[index].count != 0)
+				ObjectPoolBase::FlushThreadCache(m_entries[index].pool, m_entries[index].head);
+		}
+	};
+
+	ObjectPoolThreadCacheEntry* FindEntry(ObjectPoolBase* pool)
+	{
+		ObjectPoolThreadCacheEntry* emptyEntry = nullptr;
+		for (size_t index = 0; index < THREAD_CACHE_SLOTS; ++index)
+		{
+			if (m_entries[index].pool == pool)
+				return &m_entries[index];
+			if (!emptyEntry && m_entries[index].pool == nullptr)
+				emptyEntry = &m_entries[index];
+		}
+
+		if (emptyEntry)
+			emptyEntry->pool = pool;
+		return emptyEntry;
+	};
+
+	ObjectPoolThreadCacheEntry m_entries[THREAD_CACHE_SLOTS];
+};
+
+
+static ObjectPoolThreadCache& GetObjectPoolThreadCache()
+{
+	static thread_local ObjectPoolThreadCache s_threadCache;
+	return s_threadCache;
+}
+
+
+ObjectPoolBase::ObjectPoolBase(size_t objectSize, size_t objectAlignment, size_t objectsPerChunk, bool useThreadCache)
+	: m_objectsPerChunk(objectsPerChunk == 0 ? 1 : objectsPerChunk)
+	, m_numberOfChunks(0)
+	, m_useThreadCache(useThreadCache)
+	, m_freeList(nullptr)
+	, m_chunks(nullptr)
+	, m_liveCount(0)
+	, m_peakLiveCount(0)
+	, m_totalAllocations(0)
+{
+	if (objectAlignment < sizeof(void*))
+		objectAlignment = sizeof(void*);
+
+	m_slotSize = objectSize < sizeof(ObjectPoolFreeNode) ? sizeof(ObjectPoolFreeNode) : objectSize;
+	m_slotSize = (m_slotSize + objectAlignment - 1) & ~(objectAlignment - 1);
+}
+
+
+ObjectPoolBase::~ObjectPoolBase()
+{
+	if (m_useThreadCache)
+	{
+		ObjectPoolThreadCacheEntry* entry = GetObjectPoolThreadCache().FindEntry(this);
+		if (entry)
+		{
+			entry->pool = nullptr;
+			entry->head = nullptr;
+			entry->count = 0;
+		}
+	}
+
+	while (m_chunks)
+	{
+		ObjectPoolChunk* chunk = m_chunks;
+		m_chunks = chunk->next;
+		free(chunk);
+	}
+}
+
+
+void* ObjectPoolBase::Allocate()
+{
+	CountAllocation();
+
+	if (m_useThreadCache)
+	{
+		ObjectPoolThreadCacheEntry* entry = GetObjectPoolThreadCache().FindEntry(this);
+		if (entry)
+		{
+			if (entry->count == 0)
+			{
+				std::lock_guard<std::mutex> guard(m_lock);
+				for (; entry->count < THREAD_CACHE_BATCH_SIZE; ++entry->count)
+				{
+					ObjectPoolFreeNode* node = (ObjectPoolFreeNode*)AllocateFromCentral();
+					node->next = entry->head;
+					entry->head = node;
+				}
+			}
+
+			ObjectPoolFreeNode* node = entry->head;
+			entry->head = node->next;
+			--entry->count;
+			return node;
+		}
+
+		std::lock_guard<std::mutex> guard(m_lock);
+		return AllocateFromCentral();
+	}
+
+	return AllocateFromCentral();
+}
+
+
+void ObjectPoolBase::Free(void* p)
+{
+	if (p == nullptr)
+		return;
+
+	m_liveCount.fetch_sub(1, std::memory_order_relaxed);
+	ObjectPoolFreeNode* node = (ObjectPoolFreeNode*)p;
+
+	if (m_useThreadCache)
+	{
+		ObjectPoolThreadCacheEntry* entry = GetObjectPoolThreadCache().FindEntry(this);
+		if (entry)
+		{
+			node->next = entry->head;
+			entry->head = node;
+			++entry->count;
+			if (entry->count > THREAD_CACHE_MAX_OBJECTS)
+			{
+				ObjectPoolFreeNode* head = entry->head;
+				ObjectPoolFreeNode* tail = head;
+				for (size_t index = 1; index < THREAD_CACHE_BATCH_SIZE; ++index)
+					tail = tail->next;
+
+				entry->head = tail->next;
+				entry->count -= THREAD_CACHE_BATCH_SIZE;
+
+				std::lock_guard<std::mutex> guard(m_lock);
+				FreeToCentral(head, tail);
+			}
+			return;
+		}
+
+		std::lock_guard<std::mutex> guard(m_lock);
+		FreeToCentral(node, node);
+		return;
+	}
+
+	FreeToCentral(node, node);
+}
+
+
+void ObjectPoolBase::FlushThreadCache(ObjectPoolBase* pool, ObjectPoolFreeNode* head)
+{
+	ObjectPoolFreeNode* tail = head;
+	while (tail->next)
+		tail = tail->next;
+
+	std::lock_guard<std::mutex> guard(pool->m_lock);
+	pool->FreeToCentral(head, tail);
+}
+
+
+void ObjectPoolBase::CountAllocation()
+{
+	m_totalAllocations.fetch_add(1, std::memory_order_relaxed);
+	size_t live = m_liveCount.fetch_add(1, std::memory_order_relaxed) + 1;
+	size_t peak = m_peakLiveCount.load(std::memory_order_relaxed);
+	while (live > peak && !m_peakLiveCount.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+	{
+	}
+}
+
+
+void* ObjectPoolBase::AllocateFromCentral()
+{
+	if (m_freeList == nullptr)
+		AllocateChunk();
+
+	ObjectPoolFreeNode* node = m_freeList;
+	m_freeList = node->next;
+	return node;
+}
+
+
+void ObjectPoolBase::FreeToCentral(ObjectPoolFreeNode* head, ObjectPoolFreeNode* tail)
+{
+	tail->next = m_freeList;
+	m_freeList = head;
+}
+
+
+void ObjectPoolBase::AllocateChunk()
+{
+	size_t headerSize = (sizeof(ObjectPoolChunk) + m_slotSize - 1) / m_slotSize * m_slotSize;
+	char* memory = (char*)malloc(headerSize + m_slotSize * m_objectsPerChunk);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+
+	ObjectPoolChunk* chunk = (ObjectPoolChunk*)memory;
+	chunk->next = m_chunks;
+	m_chunks = chunk;
+	++m_numberOfChunks;
+
+	char* slots = memory + headerSize;
+	for (size_t index = m_objectsPerChunk; index > 0; --index)
+	{
+		ObjectPoolFreeNode* node = (ObjectPoolFreeNode*)(slots + (index - 1) * m_slotSize);
+		node->next = m_freeList;
+		m_freeList = node;
+	}
+}
+
+
+};
\ No newline at end of file
@@ -0,0 +1,117 @@
+#pragma once
+
+#ifndef OBJECTPOOL_HPP
+#define OBJECTPOOL_HPP
+
+#include <stddef.h>
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <utility>
+
+
+namespace Henry
+{
+
+struct ObjectPoolFreeNode
+{
+	ObjectPoolFreeNode* next;
+};
+
+
+struct ObjectPoolChunk
+{
+	ObjectPoolChunk* next;
+};
+
+
+// Fixed size block pool with an intrusive free list threaded through the unused slots.
+// Slots come from chunks of objectsPerChunk objects , chunks are only returned when the pool dies.
+// A pool created with useThreadCache keeps a small free list per thread in front of a locked
+// central list , otherwise the pool must only be touched from one thread at a time.
+// Pools using thread caches must outlive every thread that allocated from them.
+class ObjectPoolBase
+{
+public:
+	ObjectPoolBase(size_t objectSize, size_t objectAlignment, size_t objectsPerChunk, bool useThreadCache);
+	~ObjectPoolBase();
+	void* Allocate();
+	void Free(void* p);
+	size_t GetLiveCount() const { return m_liveCount.load(std::memory_order_relaxed); };
+	size_t GetPeakLiveCount() const { return m_peakLiveCount.load(std::memory_order_relaxed); };
+	size_t GetTotalAllocations() const { return m_totalAllocations.load(std::memory_order_relaxed); };
+	size_t GetNumberOfChunks() const { return m_numberOfChunks; };
+	size_t GetCapacity() const { return m_numberOfChunks * m_objectsPerChunk; };
+	size_t GetObjectSize() const { return m_slotSize; };
+
+public:
+	static void FlushThreadCache(ObjectPoolBase* pool, ObjectPoolFreeNode* head);
+
+private:
+	ObjectPoolBase(const ObjectPoolBase&);
+	void operator=(const ObjectPoolBase&);
+	void* AllocateFromCentral();
+	void FreeToCentral(ObjectPoolFreeNode* head, ObjectPoolFreeNode* tail);
+	void AllocateChunk();
+	void CountAllocation();
+
+	size_t m_slotSize;
+	size_t m_objectsPerChunk;
+	size_t m_numberOfChunks;
+	bool m_useThreadCache;
+	ObjectPoolFreeNode* m_freeList;
+	ObjectPoolChunk* m_chunks;
+	std::mutex m_lock;
+	std::atomic<size_t> m_liveCount;
+	std::atomic<size_t> m_peakLiveCount;
+	std::atomic<size_t> m_totalAllocations;
+};
+
+
+template <class T>
+class ObjectPool : public ObjectPoolBase
+{
+public:
+	ObjectPool(size_t objectsPerChunk = 64, bool useThreadCache = false)
+		: ObjectPoolBase(sizeof(T), __alignof(T), objectsPerChunk, useThreadCache) {};
+
+	// Default-initialized , so plain data like packet buffers is not zeroed on every acquire.
+	T* Acquire() { return new (Allocate()) T; };
+	template <typename... Args>
+	T* Acquire(Args&&... args) { return new (Allocate()) T(std::forward<Args>(args)...); };
+	void Release(T* object) { if (!object) return; object->~T(); Free(object); };
+};
+
+
+// Routes a class' operator new/delete through a static ObjectPool of that class.
+// Subclasses of a pooled class need their own declaration (and a virtual destructor in the base)
+// otherwise they fall back to the global heap.
+#define DECLARE_POOLED_ALLOCATION(ClassName) \
+public: \
+	static void* operator new(size_t size); \
+	static void operator delete(void* p, size_t size); \
+	static Henry::ObjectPool<ClassName>& GetObjectPool();
+
+#define DEFINE_POOLED_ALLOCATION(ClassName, objectsPerChunk) \
+	Henry::ObjectPool<ClassName>& ClassName::GetObjectPool() \
+	{ \
+		static Henry::ObjectPool<ClassName> s_objectPool(objectsPerChunk); \
+		return s_objectPool; \
+	} \
+	void* ClassName::operator new(size_t size) \
+	{ \
+		if (size != sizeof(ClassName)) \
+			return ::operator new(size); \
+		return GetObjectPool().Allocate(); \
+	} \
+	void ClassName::operator delete(void* p, size_t size) \
+	{ \
+		if (size != sizeof(ClassName)) \
+			::operator delete(p); \
+		else \
+			GetObjectPool().Free(p); \
+	}
+
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,365 @@
+#include "RelocatableHeap.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+
+namespace Henry
+{
+
+RelocatableHeap* _relocatableHeap = nullptr;
+
+static const size_t RELOCATABLE_ALIGNMENT = 16;
+static const size_t HEADER_SIZE = (sizeof(RelocatableBlockHeader) + RELOCATABLE_ALIGNMENT - 1) & ~(RELOCATABLE_ALIGNMENT - 1);
+static const size_t MINIMUM_BLOCK_SIZE = RELOCATABLE_ALIGNMENT;
+static const unsigned int NO_FREE_ENTRY = 0xffffffff;
+
+
+static inline void* PointerFromBlock(RelocatableBlockHeader* block)
+{
+	return (char*)block + HEADER_SIZE;
+}
+
+
+RelocatableHeap::RelocatableHeap(size_t numberOfBytes)
+	: m_memorySize(numberOfBytes)
+	, m_allocatedSize(0)
+	, m_numberOfBlocks(0)
+	, m_numberOfHoles(0)
+	, m_bytesMoved(0)
+	, m_numberOfFullCompactions(0)
+	, m_lastBlock(nullptr)
+	, m_holes(nullptr)
+	, m_freeEntry(NO_FREE_ENTRY)
+{
+	m_rawMemory = malloc(numberOfBytes + RELOCATABLE_ALIGNMENT);
+	if (m_rawMemory == nullptr)
+		throw std::bad_alloc();
+
+	m_beginOfMemory = (char*)(((size_t)m_rawMemory + RELOCATABLE_ALIGNMENT - 1) & ~(RELOCATABLE_ALIGNMENT - 1));
+	m_endOfMemory = m_beginOfMemory + numberOfBytes;
+	m_top = m_beginOfMemory;
+}
+
+
+RelocatableHeap::~RelocatableHeap()
+{
+	free(m_rawMemory);
+	if (_relocatableHeap == this)
+		_relocatableHeap = nullptr;
+}
+
+
+RelocatableBlockHeader* RelocatableHeap::NextBlock(RelocatableBlockHeader* block) const
+{
+	char* next = (char*)block + HEADER_SIZE + block->sizeInBytes;
+	return next < m_top ? (RelocatableBlockHeader*)next : nullptr;
+}
+
+
+RelocatableBlockHeader* RelocatableHeap::PrevBlock(RelocatableBlockHeader* block) const
+{
+	if ((char*)block == m_beginOfMemory)
+		return nullptr;
+
+	return (RelocatableBlockHeader*)((char*)block - HEADER_SIZE - block->prevSizeInBytes);
+}
+
+
+void RelocatableHeap::SetSize(RelocatableBlockHeader* block, size_t sizeInBytes)
+{
+	block->sizeInBytes = sizeInBytes;
+	RelocatableBlockHeader* next = NextBlock(block);
+	if (next)
+		next->prevSizeInBytes = sizeInBytes;
+}
+
+
+void RelocatableHeap::InsertHole(RelocatableBlockHeader* block)
+{
+	block->handleIndex = RELOCATABLE_FREE_BLOCK;
+	block->prevFree = nullptr;
+	block->nextFree = m_holes;
+	if (m_holes)
+		m_holes->prevFree = block;
+
+	m_holes = block;
+	++m_numberOfHoles;
+}
+
+
+void RelocatableHeap::RemoveHole(RelocatableBlockHeader* block)
+{
+	if (block->prevFree)
+		block->prevFree->nextFree = block->nextFree;
+	else
+		m_holes = block->nextFree;
+
+	if (block->nextFree)
+		block->nextFree->prevFree = block->prevFree;
+
+	block->prevFree = nullptr;
+	block->nextFree = nullptr;
+	--m_numberOfHoles;
+}
+
+
+MemoryHandle RelocatableHeap::Allocate(size_t sizeInBytes)
+{
+	sizeInBytes = sizeInBytes < MINIMUM_BLOCK_SIZE ? MINIMUM_BLOCK_SIZE : sizeInBytes;
+	sizeInBytes = (sizeInBytes + RELOCATABLE_ALIGNMENT - 1) & ~(RELOCATABLE_ALIGNMENT - 1);
+
+	MemoryHandle handle = AllocateFromHoles(sizeInBytes);
+	if (!handle.IsNull())
+		return handle;
+
+	handle = AllocateFromTop(sizeInBytes);
+	if (!handle.IsNull() || m_numberOfHoles == 0)
+		return handle;
+
+	++m_numberOfFullCompactions;
+	Compact((size_t)-1);
+	return AllocateFromTop(sizeInBytes);
+}
+
+
+MemoryHandle RelocatableHeap::AllocateFromHoles(size_t sizeInBytes)
+{
+	for (RelocatableBlockHeader* hole = m_holes; hole; hole = hole->nextFree)
+	{
+		if (hole->sizeInBytes < sizeInBytes)
+			continue;
+
+		RemoveHole(hole);
+		size_t spaceRemain = hole->sizeInBytes - sizeInBytes;
+		if (spaceRemain >= HEADER_SIZE + MINIMUM_BLOCK_SIZE)
+		{
+			SetSize(hole, sizeInBytes);
+			RelocatableBlockHeader* space = (RelocatableBlockHeader*)((char*)PointerFromBlock(hole) + sizeInBytes);
+			space->prevSizeInBytes = sizeInBytes;
+			SetSize(space, spaceRemain - HEADER_SIZE);
+			InsertHole(space);
+		}
+
+		return AssignHandle(hole);
+	}
+
+	return MemoryHandle();
+}
+
+
+MemoryHandle RelocatableHeap::AllocateFromTop(size_t sizeInBytes)
+{
+	if ((size_t)(m_endOfMemory - m_top) < HEADER_SIZE + sizeInBytes)
+		return MemoryHandle();
+
+	RelocatableBlockHeader* block = (RelocatableBlockHeader*)m_top;
+	block->sizeInBytes = sizeInBytes;
+	block->prevSizeInBytes = m_lastBlock ? m_lastBlock->sizeInBytes : 0;
+	block->prevFree = nullptr;
+	block->nextFree = nullptr;
+	m_top += HEADER_SIZE + sizeInBytes;
+	m_lastBlock = block;
+	return AssignHandle(block);
+}
+
+
+MemoryHandle RelocatableHeap::AssignHandle(RelocatableBlockHeader* block)
+{
+	unsigned int index = m_freeEntry;
+	if (index == NO_FREE_ENTRY)
+	{
+		RelocatableHandleEntry entry;
+		entry.generation = 1;
+		entry.nextFreeEntry = NO_FREE_ENTRY;
+		index = (unsigned int)m_handles.size();
+		m_handles.push_back(entry);
+	}
+	else
+	{
+		m_freeEntry = m_handles[index].nextFreeEntry;
+	}
+
+	RelocatableHandleEntry& entry = m_handles[index];
+	entry.block = block;
+	entry.lockCount = 0;
+	block->handleIndex = index;
+
+	++m_numberOfBlocks;
+	m_allocatedSize += block->sizeInBytes;
+	return MemoryHandle(index, entry.generation);
+}
+
+
+RelocatableHandleEntry* RelocatableHeap::FindEntry(MemoryHandle handle) const
+{
+	if (handle.IsNull() || handle.m_index >= m_handles.size())
+		return nullptr;
+
+	const RelocatableHandleEntry& entry = m_handles[handle.m_index];
+	if (entry.generation != handle.m_generation || entry.block == nullptr)
+		return nullptr;
+
+	return const_cast<RelocatableHandleEntry*>(&entry);
+}
+
+
+bool RelocatableHeap::IsValid(MemoryHandle handle) const
+{
+	return FindEntry(handle) != nullptr;
+}
+
+
+void* RelocatableHeap::GetPointer(MemoryHandle handle) const
+{
+	RelocatableHandleEntry* entry = FindEntry(handle);
+	return entry ? PointerFromBlock(entry->block) : nullptr;
+}
+
+
+size_t RelocatableHeap::GetSize(MemoryHandle handle) const
+{
+	RelocatableHandleEntry* entry = FindEntry(handle);
+	return entry ? entry->block->sizeInBytes : 0;
+}
+
+
+void* RelocatableHeap::Lock(MemoryHandle handle)
+{
+	RelocatableHandleEntry* entry = FindEntry(handle);
+	if (entry == nullptr)
+		return nullptr;
+
+	++entry->lockCount;
+	return PointerFromBlock(entry->block);
+}
+
+
+void RelocatableHeap::Unlock(MemoryHandle handle)
+{
+	RelocatableHandleEntry* entry = FindEntry(handle);
+	if (entry && entry->lockCount > 0)
+		--entry->lockCount;
+}
+
+
+void RelocatableHeap::Free(MemoryHandle handle)
+{
+	RelocatableHandleEntry* entry = FindEntry(handle);
+	if (entry == nullptr)
+		return;
+
+	RelocatableBlockHeader* block = entry->block;
+	entry->block = nullptr;
+	entry->lockCount = 0;
+	entry->generation = entry->generation + 1 == 0 ? 1 : entry->generation + 1;
+	entry->nextFreeEntry = m_freeEntry;
+	m_freeEntry = handle.m_index;
+
+	--m_numberOfBlocks;
+	m_allocatedSize -= block->sizeInBytes;
+	CreateHole(block, block->sizeInBytes);
+}
+
+
+RelocatableBlockHeader* RelocatableHeap::CreateHole(RelocatableBlockHeader* block, size_t sizeInBytes)
+{
+	block->handleIndex = RELOCATABLE_FREE_BLOCK;
+	SetSize(block, sizeInBytes);
+
+	RelocatableBlockHeader* next = NextBlock(block);
+	if (next && next->handleIndex == RELOCATABLE_FREE_BLOCK)
+	{
+		RemoveHole(next);
+		SetSize(block, block->sizeInBytes + HEADER_SIZE + next->sizeInBytes);
+	}
+
+	RelocatableBlockHeader* prev = PrevBlock(block);
+	if (prev && prev->handleIndex == RELOCATABLE_FREE_BLOCK)
+	{
+		RemoveHole(prev);
+		SetSize(prev, prev->sizeInBytes + HEADER_SIZE + block->sizeInBytes);
+		block = prev;
+	}
+
+	// a hole at the end of the region is given back to the top
+	if (NextBlock(block) == nullptr)
+	{
+		m_top = (char*)block;
+		m_lastBlock = PrevBlock(block);
+		return nullptr;
+	}
+
+	InsertHole(block);
+	return block;
+}
+
+
+size_t RelocatableHeap::Compact(size_t maxBytesToMove)
+{
+	RelocatableBlockHeader* hole = m_top > m_beginOfMemory ? (RelocatableBlockHeader*)m_beginOfMemory : nullptr;
+	while (hole && hole->handleIndex != RELOCATABLE_FREE_BLOCK)
+		hole = NextBlock(hole);
+
+	size_t bytesMoved = 0;
+	while (hole && bytesMoved < maxBytesToMove)
+	{
+		// holes are never last and never next to each other , so there is always a live block after one
+		RelocatableBlockHeader* block = NextBlock(hole);
+		RelocatableHandleEntry& entry = m_handles[block->handleIndex];
+		if (entry.lockCount > 0)
+		{
+			hole = NextBlock(block);
+			while (hole && hole->handleIndex != RELOCATABLE_FREE_BLOCK)
+				hole = NextBlock(hole);
+			continue;
+		}
+
+		if (bytesMoved != 0 && bytesMoved + block->sizeInBytes > maxBytesToMove)
+			break;
+
+		size_t holeSize = hole->sizeInBytes;
+		size_t holePrevSize = hole->prevSizeInBytes;
+		size_t blockSize = block->sizeInBytes;
+		bool wasLastBlock = NextBlock(block) == nullptr;
+
+		RemoveHole(hole);
+		memmove(hole, block, HEADER_SIZE + blockSize);
+		RelocatableBlockHeader* movedBlock = hole;
+		movedBlock->prevSizeInBytes = holePrevSize;
+		entry.block = movedBlock;
+		bytesMoved += blockSize;
+
+		RelocatableBlockHeader* space = (RelocatableBlockHeader*)((char*)PointerFromBlock(movedBlock) + blockSize);
+		space->prevSizeInBytes = blockSize;
+		if (wasLastBlock)
+		{
+			m_top = (char*)space;
+			m_lastBlock = movedBlock;
+			break;
+		}
+
+		hole = CreateHole(space, holeSize);
+	}
+
+	m_bytesMoved += bytesMoved;
+	return bytesMoved;
+}
+
+
+size_t RelocatableHeap::GetLargestFreeBlock() const
+{
+	size_t topSize = (size_t)(m_endOfMemory - m_top);
+	size_t largest = topSize > HEADER_SIZE ? topSize - HEADER_SIZE : 0;
+	for (RelocatableBlockHeader* hole = m_holes; hole; hole = hole->nextFree)
+	{
+		if (largest < hole->sizeInBytes)
+			largest = hole->sizeInBytes;
+	}
+
+	return largest;
+}
+
+
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#ifndef RELOCATABLEHEAP_HPP
+#define RELOCATABLEHEAP_HPP
+
+#include <stddef.h>
+#include <vector>
+
+
+namespace Henry
+{
+
+struct MemoryHandle
+{
+	MemoryHandle() : m_index(0) , m_generation(0) {};
+	MemoryHandle(unsigned int index, unsigned int generation) : m_index(index) , m_generation(generation) {};
+	bool IsNull() const { return m_generation == 0; };
+	bool operator==(const MemoryHandle& rhs) const { return m_index == rhs.m_index && m_generation == rhs.m_generation; };
+	bool operator!=(const MemoryHandle& rhs) const { return !(*this == rhs); };
+
+	unsigned int m_index;
+	unsigned int m_generation;
+};
+
+
+struct RelocatableBlockHeader
+{
+	size_t sizeInBytes;				// payload only
+	size_t prevSizeInBytes;			// payload of the physical predecessor , 0 for the first block
+	unsigned int handleIndex;		// RELOCATABLE_FREE_BLOCK when the block is a hole
+	unsigned int padding;
+	RelocatableBlockHeader* prevFree;
+	RelocatableBlockHeader* nextFree;
+};
+
+const unsigned int RELOCATABLE_FREE_BLOCK = 0xffffffff;
+
+
+struct RelocatableHandleEntry
+{
+	RelocatableBlockHeader* block;
+	unsigned int generation;
+	unsigned int lockCount;
+	unsigned int nextFreeEntry;
+};
+
+
+// Heap for large payloads that are only reached through MemoryHandle.
+// Blocks live back to back in one region , Compact slides unlocked blocks down into the holes
+// below them and fixes up the handle table , so free space gathers at the top of the region.
+// Pointers from GetPointer are only good until the next Allocate or Compact , Lock pins a block
+// in place for code that has to keep a raw pointer. Not thread safe.
+class RelocatableHeap
+{
+public:
+	RelocatableHeap(size_t numberOfBytes);
+	~RelocatableHeap();
+	MemoryHandle Allocate(size_t sizeInBytes);
+	void Free(MemoryHandle handle);
+	bool IsValid(MemoryHandle handle) const;
+	void* GetPointer(MemoryHandle handle) const;
+	size_t GetSize(MemoryHandle handle) const;
+	void* Lock(MemoryHandle handle);
+	void Unlock(MemoryHandle handle);
+	size_t Compact(size_t maxBytesToMove);
+	size_t GetLargestFreeBlock() const;
+
+public:
+	size_t m_memorySize;
+	size_t m_allocatedSize;
+	size_t m_numberOfBlocks;
+	size_t m_numberOfHoles;
+	size_t m_bytesMoved;
+	size_t m_numberOfFullCompactions;
+
+private:
+	RelocatableHeap(const RelocatableHeap&);
+	void operator=(const RelocatableHeap&);
+	RelocatableBlockHeader* NextBlock(RelocatableBlockHeader* block) const;
+	RelocatableBlockHeader* PrevBlock(RelocatableBlockHeader* block) const;
+	void InsertHole(RelocatableBlockHeader* block);
+	void RemoveHole(RelocatableBlockHeader* block);
+	void SetSize(RelocatableBlockHeader* block, size_t sizeInBytes);
+	RelocatableBlockHeader* CreateHole(RelocatableBlockHeader* block, size_t sizeInBytes);
+	MemoryHandle AllocateFromHoles(size_t sizeInBytes);
+	MemoryHandle AllocateFromTop(size_t sizeInBytes);
+	MemoryHandle AssignHandle(RelocatableBlockHeader* block);
+	RelocatableHandleEntry* FindEntry(MemoryHandle handle) const;
+
+	void* m_rawMemory;
+	char* m_beginOfMemory;
+	char* m_endOfMemory;
+	char* m_top;
+	RelocatableBlockHeader* m_lastBlock;
+	RelocatableBlockHeader* m_holes;
+	std::vector<RelocatableHandleEntry> m_handles;
+	unsigned int m_freeEntry;
+};
+
+extern RelocatableHeap* _relocatableHeap;
+
+};
+
+#endif
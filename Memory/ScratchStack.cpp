@@ -0,0 +1,111 @@
+#include "ScratchStack.hpp"
+
+#include <stdlib.h>
+
+
+namespace Henry
+{
+
+ScratchStack::ScratchStack(size_t numberOfBytes)
+	: m_highWaterMark(0)
+	, m_numberOfOverflows(0)
+{
+	m_begin = (char*)malloc(numberOfBytes);
+	if (m_begin == nullptr)
+		throw std::bad_alloc();
+
+	m_end = m_begin + numberOfBytes;
+	m_front = m_begin;
+	m_back = m_end;
+	m_overflowBlocks[SCRATCH_FRONT] = nullptr;
+	m_overflowBlocks[SCRATCH_BACK] = nullptr;
+}
+
+
+ScratchStack::~ScratchStack()
+{
+	for (int end = 0; end < 2; ++end)
+	{
+		ScratchMarker marker = { nullptr , nullptr };
+		marker.m_position = end == SCRATCH_FRONT ? m_begin : m_end;
+		Rewind((ScratchEnd)end, marker);
+	}
+
+	free(m_begin);
+}
+
+
+ScratchStack* ScratchStack::GetThreadScratchStack()
+{
+	static thread_local ScratchStack s_scratchStack(SCRATCH_STACK_DEFAULT_SIZE);
+	return &s_scratchStack;
+}
+
+
+void* ScratchStack::Allocate(ScratchEnd end, size_t sizeInBytes, size_t alignment)
+{
+	char* p;
+	if (end == SCRATCH_FRONT)
+	{
+		p = (char*)(((size_t)m_front + alignment - 1) & ~(alignment - 1));
+		if (p + sizeInBytes > m_back || p + sizeInBytes < p)
+			return AllocateOverflow(end, sizeInBytes, alignment);
+		m_front = p + sizeInBytes;
+	}
+	else
+	{
+		if (sizeInBytes > (size_t)(m_back - m_front))
+			return AllocateOverflow(end, sizeInBytes, alignment);
+		p = (char*)((size_t)(m_back - sizeInBytes) & ~(alignment - 1));
+		if (p < m_front)
+			return AllocateOverflow(end, sizeInBytes, alignment);
+		m_back = p;
+	}
+
+	size_t bytesUsed = (m_front - m_begin) + (m_end - m_back);
+	if (bytesUsed > m_highWaterMark)
+		m_highWaterMark = bytesUsed;
+	return p;
+}
+
+
+void* ScratchStack::AllocateOverflow(ScratchEnd end, size_t sizeInBytes, size_t alignment)
+{
+	++m_numberOfOverflows;
+	size_t headerSize = (sizeof(ScratchOverflowBlock) + alignment - 1) & ~(alignment - 1);
+	char* memory = (char*)malloc(headerSize + sizeInBytes + alignment);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+
+	ScratchOverflowBlock* block = (ScratchOverflowBlock*)memory;
+	block->next = m_overflowBlocks[end];
+	m_overflowBlocks[end] = block;
+	return (char*)(((size_t)memory + headerSize + alignment - 1) & ~(alignment - 1));
+}
+
+
+ScratchMarker ScratchStack::GetMarker(ScratchEnd end) const
+{
+	ScratchMarker marker;
+	marker.m_position = end == SCRATCH_FRONT ? m_front : m_back;
+	marker.m_overflowBlocks = m_overflowBlocks[end];
+	return marker;
+}
+
+
+void ScratchStack::Rewind(ScratchEnd end, const ScratchMarker& marker)
+{
+	while (m_overflowBlocks[end] != marker.m_overflowBlocks)
+	{
+		ScratchOverflowBlock* block = m_overflowBlocks[end];
+		m_overflowBlocks[end] = block->next;
+		free(block);
+	}
+
+	if (end == SCRATCH_FRONT)
+		m_front = marker.m_position;
+	else
+		m_back = marker.m_position;
+}
+
+};
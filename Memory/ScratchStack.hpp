@@ -0,0 +1,88 @@
+#pragma once
+
+#ifndef SCRATCHSTACK_HPP
+#define SCRATCHSTACK_HPP
+
+#include <stddef.h>
+#include <new>
+
+
+namespace Henry
+{
+
+const size_t SCRATCH_STACK_DEFAULT_SIZE = 4 * 1024 * 1024;
+
+enum ScratchEnd { SCRATCH_FRONT = 0 , SCRATCH_BACK };
+
+
+struct ScratchOverflowBlock
+{
+	ScratchOverflowBlock* next;
+};
+
+
+struct ScratchMarker
+{
+	char* m_position;
+	ScratchOverflowBlock* m_overflowBlocks;
+};
+
+
+// Two ended stack for temporary memory. The front grows up from the start of the buffer and the
+// back grows down from its end , so a loader can keep its file buffer at one end while parsing
+// helpers push and pop short lived temporaries at the other.
+// Memory is handed back by rewinding an end to a marker , requests that don't fit fall back to
+// the heap and are freed by the rewind that passes them.
+// Each thread gets its own stack from GetThreadScratchStack.
+class ScratchStack
+{
+public:
+	ScratchStack(size_t numberOfBytes);
+	~ScratchStack();
+	void* Allocate(ScratchEnd end, size_t sizeInBytes, size_t alignment = 16);
+	ScratchMarker GetMarker(ScratchEnd end) const;
+	void Rewind(ScratchEnd end, const ScratchMarker& marker);
+	size_t GetFreeBytes() const { return m_back - m_front; };
+	size_t GetSize() const { return m_end - m_begin; };
+	static ScratchStack* GetThreadScratchStack();
+
+public:
+	size_t m_highWaterMark;
+	size_t m_numberOfOverflows;
+
+private:
+	ScratchStack(const ScratchStack&);
+	void operator=(const ScratchStack&);
+	void* AllocateOverflow(ScratchEnd end, size_t sizeInBytes, size_t alignment);
+
+	char* m_begin;
+	char* m_end;
+	char* m_front;
+	char* m_back;
+	ScratchOverflowBlock* m_overflowBlocks[2];
+};
+
+
+// Remembers one end of a scratch stack and rewinds it when the scope ends.
+// Scopes on the same end have to close in the reverse order they were opened.
+class ScratchScope
+{
+public:
+	ScratchScope(ScratchEnd end = SCRATCH_FRONT, ScratchStack* stack = ScratchStack::GetThreadScratchStack())
+		: m_stack(stack) , m_end(end) , m_marker(stack->GetMarker(end)) {};
+	~ScratchScope() { m_stack->Rewind(m_end, m_marker); };
+	void* Allocate(size_t sizeInBytes, size_t alignment = 16) { return m_stack->Allocate(m_end, sizeInBytes, alignment); };
+	template <class T> T* AllocateArray(size_t count) { return (T*)Allocate(count * sizeof(T), __alignof(T) > 16 ? __alignof(T) : 16); };
+
+private:
+	ScratchScope(const ScratchScope&);
+	void operator=(const ScratchScope&);
+
+	ScratchStack* m_stack;
+	ScratchEnd m_end;
+	ScratchMarker m_marker;
+};
+
+};
+
+#endif
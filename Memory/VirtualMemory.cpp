@@ -0,0 +1,90 @@
+#include "VirtualMemory.hpp"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define UNUSED(x) (void)(x);
+
+
+namespace Henry
+{
+
+size_t GetVirtualMemoryPageSize()
+{
+	static size_t s_pageSize = 0;
+	if (s_pageSize == 0)
+	{
+#if defined(_WIN32)
+		SYSTEM_INFO systemInfo;
+		GetSystemInfo(&systemInfo);
+		s_pageSize = systemInfo.dwPageSize;
+#else
+		s_pageSize = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+	}
+
+	return s_pageSize;
+}
+
+
+void* ReserveVirtualMemory(size_t numberOfBytes)
+{
+#if defined(_WIN32)
+	return VirtualAlloc(NULL, numberOfBytes, MEM_RESERVE, PAGE_NOACCESS);
+#else
+	void* p = mmap(nullptr, numberOfBytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return p == MAP_FAILED ? nullptr : p;
+#endif
+}
+
+
+bool CommitVirtualMemory(void* p, size_t numberOfBytes)
+{
+#if defined(_WIN32)
+	return VirtualAlloc(p, numberOfBytes, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+	return mprotect(p, numberOfBytes, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+
+void DiscardVirtualMemory(void* p, size_t numberOfBytes)
+{
+#if defined(_WIN32)
+	VirtualAlloc(p, numberOfBytes, MEM_RESET, PAGE_READWRITE);
+#else
+	madvise(p, numberOfBytes, MADV_DONTNEED);
+#endif
+}
+
+
+void ReleaseVirtualMemory(void* p, size_t numberOfBytes)
+{
+#if defined(_WIN32)
+	UNUSED(numberOfBytes);
+	VirtualFree(p, 0, MEM_RELEASE);
+#else
+	munmap(p, numberOfBytes);
+#endif
+}
+
+
+bool AdviseHugePages(void* p, size_t numberOfBytes)
+{
+#if defined(MADV_HUGEPAGE)
+	return madvise(p, numberOfBytes, MADV_HUGEPAGE) == 0;
+#else
+	// large pages on Windows need SeLockMemoryPrivilege and a MEM_LARGE_PAGES commit , not supported here
+	UNUSED(p);
+	UNUSED(numberOfBytes);
+	return false;
+#endif
+}
+
+
+};
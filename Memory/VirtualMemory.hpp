@@ -0,0 +1,24 @@
+#pragma once
+
+#ifndef VIRTUALMEMORY_HPP
+#define VIRTUALMEMORY_HPP
+
+#include <stddef.h>
+
+
+namespace Henry
+{
+
+// Thin wrapper over the OS virtual memory calls (VirtualAlloc on Windows , mmap / madvise elsewhere).
+// Reserved ranges are not accessible until committed. Discarded ranges stay committed and readable
+// but the OS may drop their physical pages , they read back as zero (Linux) or stale data (Windows).
+size_t GetVirtualMemoryPageSize();
+void* ReserveVirtualMemory(size_t numberOfBytes);
+bool CommitVirtualMemory(void* p, size_t numberOfBytes);
+void DiscardVirtualMemory(void* p, size_t numberOfBytes);
+void ReleaseVirtualMemory(void* p, size_t numberOfBytes);
+bool AdviseHugePages(void* p, size_t numberOfBytes);
+
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include <MSTcpIP.h>
 
 #include "PacketHeader.hpp"
+#include "Engine\Core\Metrics.hpp"
 
 #pragma comment(lib, "Ws2_32.lib")
 #define UNUSED(x) (void)(x);
@@ -12,12 +13,20 @@
 namespace Henry
 {
 
+static const unsigned int s_packetsSentMetric = Metrics::RegisterCounter("network.packetsSent");
+static const unsigned int s_packetsResentMetric = Metrics::RegisterCounter("network.packetsResent");
+static const unsigned int s_packetsReceivedMetric = Metrics::RegisterCounter("network.packetsReceived");
+static const unsigned int s_bytesSentMetric = Metrics::RegisterCounter("network.bytesSent");
+static const unsigned int s_bytesReceivedMetric = Metrics::RegisterCounter("network.bytesReceived");
+static const unsigned int s_messagesDroppedMetric = Metrics::RegisterCounter("network.messagesDropped");
+
 	NetworkingSystem::NetworkingSystem(NetworkType type, const char* ipAddr, u_short port, int playerID, bool nonBlocking, bool echoServer)
 	: m_type(type)
 	, m_ipAddr(ipAddr)
 	, m_port(port)
 	, m_playerID(playerID)
 	, m_echoServer(echoServer)
+	, m_packetPool(64)
 {
 	WSAData wsaData;
 	WORD DLLVSERION;
@@ -29,7 +38,7 @@ namespace Henry
 	m_addr.sin_port = htons(m_port);
 	m_addrlen = sizeof(m_addr);
 
-	m_maxPacketSizeInByte = 2048;
+	m_maxPacketSizeInByte = PACKET_BUFFER_SIZE;
 	m_tempBuffer = new char[m_maxPacketSizeInByte];
 	m_orderedPacketID = 0;
 	m_reliablePacketID = 0;
@@ -75,7 +84,8 @@ namespace Henry
 
 NetworkingSystem::~NetworkingSystem(void)
 {
-	delete m_tempBuffer;
+	ClearReceiveBuffer();
+	delete[] m_tempBuffer;
 	m_tempBuffer = nullptr;
 }
 
@@ -115,9 +125,13 @@ void NetworkingSystem::Update(float deltaSeconds)
 	{
 		RefreshConnectStatus(deltaSeconds);
 		ClientInfo clinet;
+		long long packetsReceived = 0;
+		long long bytesReceived = 0;
 		int recvLength = recvfrom(m_listen, m_tempBuffer, m_maxPacketSizeInByte, NULL, (SOCKADDR*)&clinet.SocketAddr, &m_addrlen);
 		while (recvLength > 0)
 		{
+			++packetsReceived;
+			bytesReceived += recvLength;
 			m_tempBuffer[recvLength] = NULL;
 			std::string clientID(inet_ntoa(clinet.SocketAddr.sin_addr));
 			clientID += "" + clinet.SocketAddr.sin_port;
@@ -125,7 +139,7 @@ void NetworkingSystem::Update(float deltaSeconds)
 			if (m_clinetMap.find(clientID) == m_clinetMap.end())
 				m_clinetMap[clientID] = clinet;
 
-			char* buffer = new char[recvLength];
+			char* buffer = AcquirePacket();
 			memcpy(buffer, m_tempBuffer, recvLength);
 			m_receiveBuffer.push_back(buffer);
 
@@ -135,6 +149,14 @@ void NetworkingSystem::Update(float deltaSeconds)
 			ZeroMemory(m_tempBuffer, m_maxPacketSizeInByte);
 			recvLength = recvfrom(m_listen, m_tempBuffer, m_maxPacketSizeInByte, NULL, (SOCKADDR*)&clinet.SocketAddr, &m_addrlen);
 		}
+
+		Metrics::Add(s_packetsReceivedMetric, packetsReceived);
+		Metrics::Add(s_bytesReceivedMetric, bytesReceived);
+		if (m_echoServer)
+		{
+			Metrics::Add(s_packetsSentMetric, packetsReceived);
+			Metrics::Add(s_bytesSentMetric, bytesReceived);
+		}
 	}
 		break;
 	case RAW_SOCKET:
@@ -176,7 +198,7 @@ void NetworkingSystem::Update(float deltaSeconds)
 				ptr += sizeof(ip_hdr) * 4 + sizeof(udp_hdr);
 				int size = recvLength - ip->ip_header_len * 4 - sizeof(udp_hdr);
 
-				char* buffer = new char[size];
+				char* buffer = AcquirePacket();
 				memcpy(buffer, ptr, size);
 				m_receiveBuffer.push_back(buffer);
 				printf("size received : %d , raw data : ", size);
@@ -201,22 +223,29 @@ void NetworkingSystem::Update(float deltaSeconds)
 
 void NetworkingSystem::ReceiveMessage()
 {
+	long long packetsReceived = 0;
+	long long bytesReceived = 0;
 	int recvLength = recvfrom(m_connect, m_tempBuffer, m_maxPacketSizeInByte, NULL, (SOCKADDR*)&m_addr, &m_addrlen);
 	while (recvLength > 0)
 	{
+		++packetsReceived;
+		bytesReceived += recvLength;
 		PacketChannel channel = (PacketChannel)m_tempBuffer[0];
 		int packetID = ExtractPacketIDFromPacket(m_tempBuffer);
 		
 		char* bufferPtr = m_tempBuffer;
 		bufferPtr += (4 + sizeof(int));
-		char* data = new char[recvLength - 4 - sizeof(int)];
+		char* data = AcquirePacket();
 		memcpy(data, bufferPtr, recvLength - 4 - sizeof(int));
 
 		switch (channel)
 		{
 		case UNRELIABLE:
 			if (data[0] == 1)	// Ack
+			{
 				RemoveFromResendList(packetID);
+				ReleasePacket(data);
+			}
 			else
 				m_processList.push_back(data);
 			break;
@@ -226,6 +255,8 @@ void NetworkingSystem::ReceiveMessage()
 				m_nextProcessOrderedPacketID = packetID;
 				m_processList.push_back(data);
 			}
+			else
+				ReleasePacket(data);
 			break;
 		case RELIABLE:
 			if (packetID <= m_nextProcessReliablePacketID)
@@ -235,13 +266,16 @@ void NetworkingSystem::ReceiveMessage()
 					m_processList.push_back(data);
 					++m_nextProcessReliablePacketID;
 				}
+				else
+					ReleasePacket(data);
+
 				AcknowledgePacket ack;
 				ack.info.channelID = UNRELIABLE;
 				ack.info.packetID = packetID;
 				ack.info.packetType = 1;
 				ack.info.playerID = (char)m_playerID;
 				
-				char* packet = new char[sizeof(AcknowledgePacket)];
+				char* packet = AcquirePacket();
 				memcpy(packet, ack.buffer, sizeof(AcknowledgePacket));
 				PacketInfo pi;
 				pi.buffer = packet;
@@ -250,25 +284,37 @@ void NetworkingSystem::ReceiveMessage()
 			}
 			else if (packetID > m_nextProcessReliablePacketID)
 			{
-				char* originalData = new char[recvLength];
+				char* originalData = AcquirePacket();
 				memcpy(originalData, m_tempBuffer, recvLength);
 				m_reliableProcessList.push(originalData);
-				delete data;
+				ReleasePacket(data);
 			}
 			break;
 		default:
+			ReleasePacket(data);
 			break;
 		}
 
 		ZeroMemory(m_tempBuffer, m_maxPacketSizeInByte);
 		recvLength = recvfrom(m_connect, m_tempBuffer, m_maxPacketSizeInByte, NULL, (SOCKADDR*)&m_addr, &m_addrlen);
 	}
+
+	Metrics::Add(s_packetsReceivedMetric, packetsReceived);
+	Metrics::Add(s_bytesReceivedMetric, bytesReceived);
 }
 
 
-void NetworkingSystem::PushMessage(PacketChannel channel, const char* data, int size)
+// Returns false and drops the message when it doesn't fit in one packet with its header.
+bool NetworkingSystem::PushMessage(PacketChannel channel, const char* data, int size)
 {
-	char* packet = new char[size + 4 + sizeof(int)];
+	if (size < 0 || size + 4 + (int)sizeof(int) > PACKET_BUFFER_SIZE)
+	{
+		_ASSERTE(!"NetworkingSystem::PushMessage : message larger than PACKET_BUFFER_SIZE");
+		Metrics::Add(s_messagesDroppedMetric, 1);
+		return false;
+	}
+
+	char* packet = AcquirePacket();
 	char* bufferPtr = packet;
 	
 	*bufferPtr = (char)channel;
@@ -299,6 +345,7 @@ void NetworkingSystem::PushMessage(PacketChannel channel, const char* data, int
 
 	if (channel == RELIABLE)
 		m_resendList.push_back(pi);
+	return true;
 }
 
 
@@ -326,12 +373,32 @@ void NetworkingSystem::ClearReceiveBuffer()
 	{
 		char* buffer = *it;
 		it = m_receiveBuffer.erase(it);
-		delete buffer;
+		ReleasePacket(buffer);
 		buffer = nullptr;
 	}
 }
 
 
+void NetworkingSystem::ClearProcessList()
+{
+	for (size_t index = 0; index < m_processList.size(); ++index)
+		ReleasePacket(m_processList[index]);
+	m_processList.clear();
+}
+
+
+char* NetworkingSystem::AcquirePacket()
+{
+	return m_packetPool.Acquire()->m_data;
+}
+
+
+void NetworkingSystem::ReleasePacket(char* packet)
+{
+	m_packetPool.Release((PacketBuffer*)packet);
+}
+
+
 void NetworkingSystem::WriteIntegerToBuffer(char*& buffer, int data)
 {
 	for (int index = 0; index < sizeof(int); ++index)
@@ -361,7 +428,7 @@ void NetworkingSystem::RefreshSendListFromWaitProcessList()
 
 		if (topPacketID < m_nextProcessReliablePacketID)
 		{
-			delete topPacket;
+			ReleasePacket(topPacket);
 			m_reliableProcessList.pop();
 		}
 	}
@@ -370,18 +437,30 @@ void NetworkingSystem::RefreshSendListFromWaitProcessList()
 
 void NetworkingSystem::SendAllMessages()
 {
+	long long bytesSent = 0;
+	long long packetsSent = (long long)m_sendList.size();
 	std::vector<PacketInfo>::iterator it = m_sendList.begin();
 	while (it != m_sendList.end())
 	{
 		char* msg = (*it).buffer;
 		int size = (*it).size;
 		sendto(m_connect, msg, size, NULL, (SOCKADDR*)&m_addr, m_addrlen);
+		bytesSent += size;
 		it = m_sendList.erase(it);
+		if (msg[0] != RELIABLE)		// reliable packets are owned by the resend list until acked
+			ReleasePacket(msg);
 		msg = nullptr;
 	}
 	
 	for (size_t index = 0; index < m_resendList.size(); ++index)
+	{
 		sendto(m_connect, m_resendList[index].buffer, m_resendList[index].size, NULL, (SOCKADDR*)&m_addr, m_addrlen);
+		bytesSent += m_resendList[index].size;
+	}
+
+	Metrics::Add(s_packetsSentMetric, packetsSent);
+	Metrics::Add(s_packetsResentMetric, (long long)m_resendList.size());
+	Metrics::Add(s_bytesSentMetric, bytesSent);
 }
 
 
@@ -392,7 +471,10 @@ void NetworkingSystem::RemoveFromResendList(int packetID)
 	{
 		char* packetBuffer = (*it).buffer;
 		if (ExtractPacketIDFromPacket(packetBuffer) <= packetID)
+		{
 			it = m_resendList.erase(it);
+			ReleasePacket(packetBuffer);
+		}
 		else
 			++it;
 	}
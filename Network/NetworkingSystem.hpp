@@ -9,9 +9,13 @@
 #include <WinSock2.h>
 #include <vector>
 
+#include "Engine\Memory\ObjectPool.hpp"
+
 namespace Henry
 {
 
+const int PACKET_BUFFER_SIZE = 2048;
+
 enum NetworkType{ TCP_SERVER , UDP_SERVER , TCP_CLIENT , UDP_CLIENT , RAW_SOCKET };
 enum PacketChannel{ UNRELIABLE, ORDERED, RELIABLE };
 struct ClientInfo
@@ -51,6 +55,10 @@ union AcknowledgePacket
 
 	char buffer[sizeof(Ack)];
 };
+struct PacketBuffer
+{
+	char m_data[PACKET_BUFFER_SIZE];
+};
 union HeartbeatPacket
 {
 	struct Heartbeat
@@ -68,9 +76,14 @@ public:
 	NetworkingSystem(NetworkType type, const char* ipAddr, u_short port, int playerID = 37, bool nonBlocking = true, bool echoServer = false);
 	~NetworkingSystem(void);
 	void Update(float deltaSeconds);
-	void PushMessage(PacketChannel channel, const char* data, int size);
+	bool PushMessage(PacketChannel channel, const char* data, int size);
 	void ClearReceiveBuffer();
 	void ResetOrderedAndReliablePacketID();
+	void ReleasePacket(char* packet);
+	void ClearProcessList();
+
+	// Packets received this frame , owned by the packet pool. ClearProcessList hands them back , never delete or release them yourself.
+	const std::vector<char*>& GetProcessList() const { return m_processList; };
 
 public:
 	NetworkType m_type;
@@ -78,7 +91,6 @@ public:
 	u_short m_port;
 	int m_sendLength;
 	std::map<std::string, ClientInfo> m_clinetMap;
-	std::vector<char*> m_processList;
 	
 private:
 	void ReceiveMessage();
@@ -90,8 +102,10 @@ private:
 	void RemoveFromResendList(int packetID);
 	void HeartBeat(double deltaSeconds);
 	int ExtractPacketIDFromPacket(char* packetBuffer);
+	char* AcquirePacket();
 
 private:
+	std::vector<char*> m_processList;
 	bool m_echoServer;
 	char* m_tempBuffer;
 	int m_addrlen;
@@ -104,6 +118,7 @@ private:
 	std::vector<PacketInfo> m_sendList;
 	std::vector<char*> m_receiveBuffer;
 	int m_maxPacketSizeInByte;
+	ObjectPool<PacketBuffer> m_packetPool;
 	int m_orderedPacketID;
 	int m_reliablePacketID;
 	int m_nextProcessOrderedPacketID;
@@ -1,19 +1,20 @@
 #include "BufferParser.hpp"
 
 #include <Windows.h>
+#include <string.h>
 #include <sstream>
 
 namespace Henry
 {
 
 
-BufferParser::BufferParser() : m_fileSize(0) , m_buffer(nullptr) , m_scan(nullptr) , m_end(nullptr)
+BufferParser::BufferParser() : m_buffer(nullptr) , m_scanOffset(0) , m_ownsBuffer(false) , m_fileSize(0)
 {
 
 }
 
 
-BufferParser::BufferParser(const char* filePath) : m_fileSize(0) , m_buffer(nullptr) , m_scan(nullptr) , m_end(nullptr)
+BufferParser::BufferParser(const char* filePath) : m_buffer(nullptr) , m_scanOffset(0) , m_ownsBuffer(false) , m_fileSize(0)
 {
 	LoadFile(filePath);
 }
@@ -21,19 +22,46 @@ BufferParser::BufferParser(const char* filePath) : m_fileSize(0) , m_buffer(null
 
 BufferParser::~BufferParser(void)
 {
-	if(m_buffer)
+	ReleaseBuffer();
+}
+
+
+void BufferParser::ReleaseBuffer()
+{
+	if(!m_bufferHandle.IsNull())
+	{
+		if(_relocatableHeap)
+			_relocatableHeap->Free(m_bufferHandle);
+		m_bufferHandle = MemoryHandle();
+	}
+	else if(m_buffer && m_ownsBuffer)
+	{
 		delete[] m_buffer;
-	if(m_scan)
-		delete m_scan;
-	if(m_end)
-		delete m_end;
+	}
+
+	m_buffer = nullptr;
+	m_ownsBuffer = false;
+	m_scanOffset = 0;
+	m_fileSize = 0;
 }
 
 
 bool BufferParser::LoadFile(const char* filePath)
 {
-	if(m_fileSize != 0)
-		delete[] m_buffer;
+	return ReadWholeFile(filePath, nullptr);
+}
+
+
+// the buffer comes from the caller's scratch scope , the parser must be done with it before the scope closes
+bool BufferParser::LoadFile(const char* filePath, ScratchScope& scratch)
+{
+	return ReadWholeFile(filePath, &scratch);
+}
+
+
+bool BufferParser::ReadWholeFile(const char* filePath, ScratchScope* scratch)
+{
+	ReleaseBuffer();
 
 	FILE *file;
 	fopen_s(&file,filePath,"rb");
@@ -52,12 +80,70 @@ bool BufferParser::LoadFile(const char* filePath)
 	long fsize = ftell(file);
 	fseek(file, 0, SEEK_SET);
 
-	m_buffer = new unsigned char[fsize];
-	fread(m_buffer, sizeof(unsigned char), fsize, file);
+	// the parser keeps an offset , so a buffer from the relocatable heap is only locked while it is read into
+	if(scratch)
+	{
+		m_buffer = scratch->AllocateArray<unsigned char>(fsize);
+	}
+	else if(_relocatableHeap)
+	{
+		m_bufferHandle = _relocatableHeap->Allocate(fsize);
+		unsigned char* buffer = (unsigned char*)_relocatableHeap->Lock(m_bufferHandle);
+		if(buffer)
+		{
+			fread(buffer, sizeof(unsigned char), fsize, file);
+			_relocatableHeap->Unlock(m_bufferHandle);
+		}
+		else
+		{
+			m_bufferHandle = MemoryHandle();
+		}
+	}
+	if(m_buffer == nullptr && m_bufferHandle.IsNull())
+	{
+		m_buffer = new unsigned char[fsize];
+		m_ownsBuffer = true;
+	}
+
+	if(m_buffer)
+		fread(m_buffer, sizeof(unsigned char), fsize, file);
 	fclose(file);
 
-	m_scan = m_buffer;
-	m_end = m_buffer + fsize * sizeof(unsigned char);
+	m_fileSize = (int)fsize;
+	m_scanOffset = 0;
+	return true;
+}
+
+
+// Locked for one read at a time , compaction may move the buffer in between.
+const unsigned char* BufferParser::LockBuffer()
+{
+	if(!m_bufferHandle.IsNull() && _relocatableHeap)
+		return (const unsigned char*)_relocatableHeap->Lock(m_bufferHandle);
+	return m_buffer;
+}
+
+
+void BufferParser::UnlockBuffer()
+{
+	if(!m_bufferHandle.IsNull() && _relocatableHeap)
+		_relocatableHeap->Unlock(m_bufferHandle);
+}
+
+
+template <typename T>
+bool BufferParser::ReadValue(T& out_value)
+{
+	if(m_scanOffset + sizeof(T) > (size_t)m_fileSize)
+		return false;
+
+	const unsigned char* buffer = LockBuffer();
+	if(!buffer)
+		return false;
+
+	memcpy(&out_value, buffer + m_scanOffset, sizeof(T));
+	UnlockBuffer();
+	m_scanOffset += sizeof(T);
 	return true;
 }
 
@@ -121,68 +207,66 @@ bool BufferParser::WriteFile(const char* filePath,const std::vector<Vertex_PCTN>
 
 bool BufferParser::ReadBool(bool& out_bool)
 {
-	out_bool = *((bool*)m_scan);
-	m_scan += sizeof(bool);
-	return true;
+	return ReadValue(out_bool);
 }
 
 
 bool BufferParser::ReadFloat(float& out_float)
 {
-	out_float = *((float*)m_scan);
-	m_scan += sizeof(float);
-	return true;
+	return ReadValue(out_float);
 }
 
 
 bool BufferParser::ReadInt(int& out_int)
 {
-	out_int = *((int*)m_scan);
-	m_scan += sizeof(int);
-	return true;
+	return ReadValue(out_int);
 }
 
 
 bool BufferParser::ReadUInt(unsigned int& out_int)
 {
-	out_int = *((unsigned int*)m_scan);
-	m_scan += sizeof(unsigned int);
-	return true;
+	return ReadValue(out_int);
 }
 
 
+// One lock for the whole string rather than one per character.
 bool BufferParser::ReadString(std::string& out_string)
 {
-	char data;
-	ReadChar(data);
-	while(data != '\0')
+	const unsigned char* buffer = LockBuffer();
+	if(!buffer)
+		return false;
+
+	while(m_scanOffset < (size_t)m_fileSize)
 	{
+		char data = (char)buffer[m_scanOffset++];
+		if(data == '\0')
+		{
+			UnlockBuffer();
+			return true;
+		}
 		out_string.push_back(data);
-		ReadChar(data);
 	}
-	return true;
+
+	UnlockBuffer();
+	return false;
 }
 
 
 bool BufferParser::ReadChar(char& out_char)
 {
-	out_char = *((char*)m_scan);
-	m_scan += sizeof(char);
-	return true;
+	return ReadValue(out_char);
 }
 
 
 bool BufferParser::ReadUChar(unsigned char& our_char)
 {
-	our_char = *((unsigned char*)m_scan);
-	m_scan += sizeof(unsigned char);
-	return true;
+	return ReadValue(our_char);
 }
 
 
 void BufferParser::Rewind()
 {
-	m_scan = m_buffer;
+	m_scanOffset = 0;
 }
 
 bool BufferParser::WriteFloat(std::vector<unsigned char>& buffer,const float data)
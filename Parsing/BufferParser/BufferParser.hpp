@@ -4,6 +4,8 @@
 #define BUFFERPARSER_HPP
 
 #include "Engine\Core\VertexStruct.hpp"
+#include "Engine\Memory\RelocatableHeap.hpp"
+#include "Engine\Memory\ScratchStack.hpp"
 
 #include <string>
 #include <vector>
@@ -18,6 +20,7 @@ public:
 	BufferParser(const char* filePath);
 	~BufferParser(void);
 	bool LoadFile(const char* filePath);
+	bool LoadFile(const char* filePath, ScratchScope& scratch);
 	bool WriteFile(const char* filePath,const std::vector<Vertex_PCTN>& verticesToWrite,const std::vector<int>& indicesToWrite);
 	void Rewind();
 	bool ReadInt(int& out_int);
@@ -28,8 +31,6 @@ public:
 	bool ReadChar(char& out_char);
 	bool ReadUChar(unsigned char& our_char);
 
-	const unsigned char* m_scan;
-	unsigned const char* m_end;
 private:
 	bool WriteFloat(std::vector<unsigned char>& buffer,const float data);
 	bool WriteChar(std::vector<unsigned char>& buffer,const char data);
@@ -38,7 +39,16 @@ private:
 	bool WriteBool(std::vector<unsigned char>& buffer,const bool data);
 	bool WriteString(std::vector<unsigned char>& buffer,const std::string& data);
 	bool WriteUChar(std::vector<unsigned char>& buffer,const unsigned char data);
-	unsigned char* m_buffer;
+	void ReleaseBuffer();
+	bool ReadWholeFile(const char* filePath, ScratchScope* scratch);
+	const unsigned char* LockBuffer();
+	void UnlockBuffer();
+	template <typename T>
+	bool ReadValue(T& out_value);
+	unsigned char* m_buffer;			// null for a relocatable buffer , reached through m_bufferHandle
+	size_t m_scanOffset;
+	bool m_ownsBuffer;
+	MemoryHandle m_bufferHandle;
 	int m_fileSize;
 	//int m_writeIndex;
 };
@@ -3,6 +3,7 @@
 #include <Windows.h>
 
 #include "ObjLoader.hpp"
+#include "Engine\Memory\ScratchStack.hpp"
 
 namespace Henry
 {
@@ -44,12 +45,14 @@ bool ObjLoader::LoadFile(const char* path)
 	long fsize = ftell(file);
 	fseek(file, 0, SEEK_SET);
 
-	char* buffer = new char[fsize];
+	// the whole load works out of the thread's scratch stack and hands it back in one rewind
+	ScratchScope scratch(SCRATCH_FRONT);
+	char* buffer = scratch.AllocateArray<char>(fsize + 1);
 	fread(buffer, sizeof(char), fsize, file);
 	fclose(file);
+	buffer[fsize] = '\0';
 
 	ParseData(buffer,fsize);
-	delete[] buffer;
 
 	return true;
 }
@@ -87,18 +90,14 @@ void ObjLoader::ParseData(const char* buffer,int dataSize)
 
 		if(IsLineEnded(buffer,dataIndex-1) && data == '#' && buffer[++dataIndex] == ' ')
 		{
-			char temp[256];
+			char temp[OBJ_TOKEN_SIZE];
 			char* result = temp;
-			memset(temp, 0, 256);
 
 			SeekToNonWhiteSpace(buffer,&dataIndex);
 			CopyUntilWhitespaceOrEOL(buffer, dataIndex, result);
 			
-			char toLower[256];
-			memset(toLower,0,256);
+			char toLower[OBJ_TOKEN_SIZE];
 			ToLower(result,toLower);
-
-			std::string strForCompare(toLower);
 			
 			if(strcmp(toLower,"metadata") == 0)
 				type = metaData;
@@ -146,13 +145,14 @@ void ObjLoader::SeekToNonWhiteSpace(const char* buffer, int* dataIndex)
 
 void ObjLoader::CopyUntilWhitespaceOrEOL(const char* buffer, int& dataIndex, char*& result)
 {
+	int length = 0;
 	while(buffer[dataIndex] != ' ' && buffer[dataIndex] != '\t' && !IsLineEnded(buffer, dataIndex))
-// 	{
-// 		*result = buffer[ dataIndex ];
-// 		++ result;
-// 		++ dataIndex;
-// 	}
-		strncat_s(result, 256, &buffer[dataIndex++], 1);//strncat(result, &buffer[index++], 1);
+	{
+		if(length < OBJ_TOKEN_SIZE - 1)
+			result[length++] = buffer[dataIndex];
+		++dataIndex;
+	}
+	result[length] = '\0';
 }
 
 
@@ -190,13 +190,11 @@ void ObjLoader::ParsingMetaData(const char* buffer,int* dataIndex)
 
 		if(data != ' ' && section == none)
 		{
-			char type[256];
-			memset(type, 0, 256);
+			char type[OBJ_TOKEN_SIZE];
 			char* result = type;
 			CopyUntilWhitespaceOrEOL(buffer, index, result);
 
-			char toLower[256];
-			memset(toLower, 0, 256);
+			char toLower[OBJ_TOKEN_SIZE];
 			ToLower(type,toLower);
 
 			if(strcmp(toLower,"orientation") == 0)
@@ -210,8 +208,7 @@ void ObjLoader::ParsingMetaData(const char* buffer,int* dataIndex)
 
 		if(data != '=' && captureEqualSymbol && data != ' ')
 		{
-			char value[256];
-			memset(value, 0, 256);
+			char value[OBJ_TOKEN_SIZE];
 			char* result = value;
 			CopyUntilWhitespaceOrEOL(buffer, index, result);
 
@@ -243,8 +240,7 @@ void ObjLoader::ParsingMetaData(const char* buffer,int* dataIndex)
 
 Vec3f ObjLoader::GetAxisBasis(const char* direction)
 {
-	char toLowerDirection[256];
-	memset(&toLowerDirection[0], 0, 256);
+	char toLowerDirection[OBJ_TOKEN_SIZE];
 	ToLower(direction,toLowerDirection);
 
 	if(strcmp(toLowerDirection,"up") == 0 || strcmp(toLowerDirection,"top") == 0)
@@ -301,8 +297,9 @@ void ObjLoader::SetScale(const char* scale)
 void ObjLoader::ToLower(const char* source, char* dst)
 {
 	int index = 0;
-	while(source[index])
-		dst[index] = source[index++];
+	for( ; source[index] && index < OBJ_TOKEN_SIZE - 1; ++index)
+		dst[index] = (char)tolower(source[index]);
+	dst[index] = '\0';
 }
 
 
@@ -311,12 +308,11 @@ void ObjLoader::ParsingTextureData(const char* buffer,int* dataIndex)
 	int& index = *dataIndex;
 	int variableIndex = 0;
 	Vec3f textCoord;
-	char temp[256];
+	char temp[OBJ_TOKEN_SIZE];
 
 	while(!IsLineEnded(buffer,index))
 	{
 		char* result = temp;
-		memset(temp,0,256);
 		CopyUntilWhitespaceOrEOL(buffer, index, result);
 
 		switch(variableIndex)
@@ -349,13 +345,12 @@ void ObjLoader::ParsingVertexData(const char* buffer,int* dataIndex)
 	int variableIndex = 0;
 	Vec3f vertex;
 	RGBA color;
-	char temp[256];
+	char temp[OBJ_TOKEN_SIZE];
 	float w = 1;
 
 	while(!IsLineEnded(buffer,index))
 	{
 		char* result = temp;
-		memset(temp,0,256);
 		CopyUntilWhitespaceOrEOL(buffer, index, result);
 
 		switch(variableIndex)
@@ -405,12 +400,11 @@ void ObjLoader::ParsingNormalData(const char* buffer,int* dataIndex)
 	int& index = *dataIndex;
 	int variableIndex = 0;
 	Vec3f normal;
-	char temp[256];
+	char temp[OBJ_TOKEN_SIZE];
 
 	while(!IsLineEnded(buffer,index))
 	{
 		char* result = temp;
-		memset(temp,0,256);
 		CopyUntilWhitespaceOrEOL(buffer, index, result);
 
 		switch(variableIndex)
@@ -441,25 +435,25 @@ void ObjLoader::ParsingNormalData(const char* buffer,int* dataIndex)
 void ObjLoader::ParsingFaceData(const char* buffer,int* dataIndex)
 {
 	int& index = *dataIndex;
-	std::vector<int> vertexIndicesList;
-	std::vector<int> textureIndicesList;
-	std::vector<int> normalIndicesList;
-	char vertexAsText[256];
-	char vertexComponentAsText[256];
+	int numberOfCorners = CountTokensInLine(buffer,index);
+	ScratchScope scratch(SCRATCH_BACK);
+	int* vertexIndices = scratch.AllocateArray<int>(numberOfCorners + 1);
+	int* textureIndices = scratch.AllocateArray<int>(numberOfCorners + 1);
+	int* normalIndices = scratch.AllocateArray<int>(numberOfCorners + 1);
+	int numberOfVertexIndices = 0;
+	int numberOfTextureIndices = 0;
+	int numberOfNormalIndices = 0;
+	char vertexAsText[OBJ_TOKEN_SIZE];
+	char vertexComponentAsText[OBJ_TOKEN_SIZE];
 	int vertexComponentAsInt;
-	vertexIndicesList.reserve(6);
-	normalIndicesList.reserve(6);
-	textureIndicesList.reserve(6);
 	if(CheckTokenInLine(buffer,index,'/'))
 	{
-		while(!IsLineEnded(buffer,index))
+		while(!IsLineEnded(buffer,index) && numberOfVertexIndices < numberOfCorners)
 		{
 			char* writeLocation = vertexAsText;
-			memset(vertexAsText,0,256);
 			CopyUntilWhitespaceOrEOL(buffer, index, writeLocation);
 
 			writeLocation = vertexComponentAsText;
-			memset(vertexComponentAsText,0,256);
 			int currentIndex = 0;
 			SeekToToken(vertexAsText,&currentIndex,'/',writeLocation);
 			vertexComponentAsInt = std::atoi(vertexComponentAsText);
@@ -467,29 +461,29 @@ void ObjLoader::ParsingFaceData(const char* buffer,int* dataIndex)
 				vertexComponentAsInt += m_rawVertexList.size() + 1;
 			if(vertexComponentAsInt == 0)
 				vertexComponentAsInt++;
-			vertexIndicesList.push_back(vertexComponentAsInt);
-			currentIndex++;
+			vertexIndices[numberOfVertexIndices++] = vertexComponentAsInt;
+			if(vertexAsText[currentIndex])
+				currentIndex++;
 
 			writeLocation = vertexComponentAsText;
-			memset(vertexComponentAsText,0,256);
 			SeekToToken(vertexAsText,&currentIndex,'/',writeLocation);
 			vertexComponentAsInt = std::atoi(vertexComponentAsText);
 			if(vertexComponentAsInt < 0)
 				vertexComponentAsInt += m_rawTextureList.size() + 1;
 			if(vertexComponentAsInt == 0)
 				vertexComponentAsInt++;
-			textureIndicesList.push_back(vertexComponentAsInt);
-			currentIndex++;
+			textureIndices[numberOfTextureIndices++] = vertexComponentAsInt;
+			if(vertexAsText[currentIndex])
+				currentIndex++;
 
 			writeLocation = vertexComponentAsText;
-			memset(vertexComponentAsText,0,256);
 			CopyUntilWhitespaceOrEOL(vertexAsText, currentIndex, writeLocation);
 			vertexComponentAsInt = std::atoi(vertexComponentAsText);
 			if(vertexComponentAsInt < 0)
 				vertexComponentAsInt += m_rawNormalList.size() + 1;
 			if(vertexComponentAsInt == 0)
 				vertexComponentAsInt++;
-			normalIndicesList.push_back(vertexComponentAsInt);
+			normalIndices[numberOfNormalIndices++] = vertexComponentAsInt;
 
 			if(IsLineEnded(buffer,index))
 				break;
@@ -499,16 +493,14 @@ void ObjLoader::ParsingFaceData(const char* buffer,int* dataIndex)
 	}
 	else
 	{
-		Vec3f normal;
-		char temp[256];
+		char temp[OBJ_TOKEN_SIZE];
 
-		while(!IsLineEnded(buffer,index))
+		while(!IsLineEnded(buffer,index) && numberOfVertexIndices < numberOfCorners)
 		{
 			char* result = temp;
-			memset(temp,0,256);
 			CopyUntilWhitespaceOrEOL(buffer, index, result);
 
-			vertexIndicesList.push_back(std::atoi(temp));
+			vertexIndices[numberOfVertexIndices++] = std::atoi(temp);
 
 			if(IsLineEnded(buffer,index))
 				break;
@@ -517,34 +509,57 @@ void ObjLoader::ParsingFaceData(const char* buffer,int* dataIndex)
 		}
 	}
 
-	for(size_t startIndex = 1; startIndex + 1 < vertexIndicesList.size(); startIndex++)
+	for(int startIndex = 1; startIndex + 1 < numberOfVertexIndices; startIndex++)
 	{
-		m_vertexIndexList.push_back(vertexIndicesList[0]);
-		m_vertexIndexList.push_back(vertexIndicesList[startIndex]);
-		m_vertexIndexList.push_back(vertexIndicesList[startIndex+1]);
+		m_vertexIndexList.push_back(vertexIndices[0]);
+		m_vertexIndexList.push_back(vertexIndices[startIndex]);
+		m_vertexIndexList.push_back(vertexIndices[startIndex+1]);
 		
-		if(textureIndicesList.size() != 0)
+		if(numberOfTextureIndices != 0)
 		{
-			m_textureIndexList.push_back(textureIndicesList[0]);
-			m_textureIndexList.push_back(textureIndicesList[startIndex]);
-			m_textureIndexList.push_back(textureIndicesList[startIndex+1]);
+			m_textureIndexList.push_back(textureIndices[0]);
+			m_textureIndexList.push_back(textureIndices[startIndex]);
+			m_textureIndexList.push_back(textureIndices[startIndex+1]);
 		}
 
-		if(normalIndicesList.size() != 0)
+		if(numberOfNormalIndices != 0)
 		{
-			m_normalIndexList.push_back(normalIndicesList[0]);
-			m_normalIndexList.push_back(normalIndicesList[startIndex]);
-			m_normalIndexList.push_back(normalIndicesList[startIndex+1]);
+			m_normalIndexList.push_back(normalIndices[0]);
+			m_normalIndexList.push_back(normalIndices[startIndex]);
+			m_normalIndexList.push_back(normalIndices[startIndex+1]);
 		}
 	}
 }
 
 
+int ObjLoader::CountTokensInLine(const char* buffer,int dataIndex)
+{
+	int numberOfTokens = 0;
+	bool inToken = false;
+	while(!IsLineEnded(buffer,dataIndex))
+	{
+		bool isWhiteSpace = buffer[dataIndex] == ' ' || buffer[dataIndex] == '\t';
+		if(!isWhiteSpace && !inToken)
+			++numberOfTokens;
+		inToken = !isWhiteSpace;
+		dataIndex++;
+	}
+
+	return numberOfTokens;
+}
+
+
 void ObjLoader::SeekToToken(const char* buffer,int* dataIndex, const char token,char*& result)
 {
 	int& index = *dataIndex;
+	int length = 0;
 	while(buffer[index] != token && buffer[index] > 0 && !IsLineEnded(buffer,index))
-		strncat_s(result, 256, &buffer[index++], 1);
+	{
+		if(length < OBJ_TOKEN_SIZE - 1)
+			result[length++] = buffer[index];
+		++index;
+	}
+	result[length] = '\0';
 }
 
 
@@ -11,6 +11,8 @@
 namespace Henry
 {
 
+const int OBJ_TOKEN_SIZE = 256;
+
 class ObjLoader
 {
 public:
@@ -39,6 +41,7 @@ private:
 	void ParsingTextureData(const char* buffer,int* dataIndex);
 	void ParsingFaceData(const char* buffer,int* dataIndex);
 	bool CheckTokenInLine(const char* buffer,int dataIndex,const char token);
+	int CountTokensInLine(const char* buffer,int dataIndex);
 	Vec3f ChangeOfBasis(Vec3f vertex,bool doScale);
 	Vec3f GetAxisBasis(const char* direction);
 	void SetScale(const char* scale);
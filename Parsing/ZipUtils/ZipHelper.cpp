@@ -7,6 +7,7 @@
 
 #include "Engine\Parsing\ZipUtils\zip.h"
 #include "Engine\Parsing\ZipUtils\unzip.h"
+#include "Engine\Core\Metrics.hpp"
 
 
 namespace Henry
@@ -15,6 +16,14 @@ namespace Henry
 std::map< std::string , void* > ZipHelper::s_zipMap;
 
 
+static long long SampleNumberOfOpenZips()
+{
+	return (long long)ZipHelper::s_zipMap.size();
+}
+
+static const unsigned int s_openZipsMetric = Metrics::RegisterGauge("zip.open", &SampleNumberOfOpenZips);
+
+
 ZipHelper::ZipHelper(void) 
 {
 }
@@ -40,68 +49,75 @@ void ZipHelper::LoadZipToMap(const std::string& zipFilePath , const std::string&
 }
 
 
-const unsigned char* ZipHelper::GetContentInZip(const std::string& zipFilePath , const std::string& pathInZip , const std::string& password , int* bufferLength , bool* success)
+// Finds the item and its uncompressed size , the zip is opened on first use.
+static HZIP FindContentInZip(const std::string& zipFilePath , const std::string& pathInZip , const std::string& password , int* itemIndex , int* bufferLength , bool* success)
 {
 	*success = true;
-	HZIP zipFile = (HZIP)GetZip(zipFilePath);
-	if(zipFile)
+	*itemIndex = -1;
+	*bufferLength = 1;
+	HZIP zipFile = (HZIP)ZipHelper::GetZip(zipFilePath);
+	if(!zipFile)
 	{
-		ZIPENTRY ze;
-		int index;
-		USES_CONVERSION;
-		TCHAR* lpString = pathInZip.substr(0,2) == "./" ? A2T(pathInZip.substr(2).c_str()) : A2T(pathInZip.c_str());
-		FindZipItem(zipFile, lpString, true, &index, &ze);
-		if(index == -1)
-		{
-			std::string errorInfo(pathInZip);
-			errorInfo = "Failed to load file : " + errorInfo;
-			MessageBoxA( NULL , errorInfo.c_str(), "Failed to loading files in zip", MB_ICONERROR | MB_OK );
-			*success = false;
-		}
+		ZipHelper::LoadZipToMap(zipFilePath, password);
+		zipFile = (HZIP)ZipHelper::GetZip(zipFilePath);
+	}
 
-		*bufferLength = ze.unc_size + 1;
-		unsigned char* xmlBuffer = new unsigned char[ze.unc_size + 1];
-		xmlBuffer[ze.unc_size] = '\0';
-		UnzipItem( zipFile , index , xmlBuffer , ze.unc_size );
+	if(!zipFile)
+	{
+		//assertion
+		std::string errorInfo(pathInZip);
+		errorInfo = "Failed to load file : " + errorInfo;
+		MessageBoxA( NULL , errorInfo.c_str(), "Failed to loading files in zip", MB_ICONERROR | MB_OK );
 
-		return xmlBuffer;
+		*success = false;
+		exit(0);
 	}
-	else
-	{
-		LoadZipToMap(zipFilePath, password);
-		HZIP newZipFile = (HZIP)GetZip(zipFilePath);
-		if(newZipFile)
-		{
-			ZIPENTRY ze;
-			int index;
-			USES_CONVERSION;
-			TCHAR* lpString = pathInZip.substr(0,2) == "./" ? A2T(pathInZip.substr(2).c_str()) : A2T(pathInZip.c_str());
-			FindZipItem(newZipFile, lpString, true, &index, &ze);
-			if(index == -1)
-			{
-				std::string errorInfo(pathInZip);
-				errorInfo = "Failed to load file : " + errorInfo;
-				MessageBoxA( NULL , errorInfo.c_str(), "Failed to loading files in zip", MB_ICONERROR | MB_OK );
-				*success = false;
-			}
-
-			unsigned char* xmlBuffer = new unsigned char[ze.unc_size + 1];
-			xmlBuffer[ze.unc_size] = '\0';
-			UnzipItem( newZipFile , index , xmlBuffer , ze.unc_size );
-			
-			return xmlBuffer;
-		}
-		else
-		{
-			//assertion
-			std::string errorInfo(pathInZip);
-			errorInfo = "Failed to load file : " + errorInfo;
-			MessageBoxA( NULL , errorInfo.c_str(), "Failed to loading files in zip", MB_ICONERROR | MB_OK );
 
-			*success = false;
-			exit(0);
-		}
+	ZIPENTRY ze;
+	USES_CONVERSION;
+	TCHAR* lpString = pathInZip.substr(0,2) == "./" ? A2T(pathInZip.substr(2).c_str()) : A2T(pathInZip.c_str());
+	FindZipItem(zipFile, lpString, true, itemIndex, &ze);
+	if(*itemIndex == -1)
+	{
+		std::string errorInfo(pathInZip);
+		errorInfo = "Failed to load file : " + errorInfo;
+		MessageBoxA( NULL , errorInfo.c_str(), "Failed to loading files in zip", MB_ICONERROR | MB_OK );
+		*success = false;
+		return zipFile;
 	}
+
+	*bufferLength = ze.unc_size + 1;
+	return zipFile;
+}
+
+
+static void UnzipContent(HZIP zipFile , int itemIndex , unsigned char* buffer , int bufferLength)
+{
+	buffer[bufferLength - 1] = '\0';
+	if(itemIndex != -1)
+		UnzipItem( zipFile , itemIndex , buffer , bufferLength - 1 );
+}
+
+
+// The buffer is the caller's , free it with delete[].
+const unsigned char* ZipHelper::GetContentInZip(const std::string& zipFilePath , const std::string& pathInZip , const std::string& password , int* bufferLength , bool* success)
+{
+	int itemIndex;
+	HZIP zipFile = FindContentInZip(zipFilePath, pathInZip, password, &itemIndex, bufferLength, success);
+	unsigned char* buffer = new unsigned char[*bufferLength];
+	UnzipContent(zipFile, itemIndex, buffer, *bufferLength);
+	return buffer;
+}
+
+
+// The buffer lives in the scratch scope and goes away with it.
+const unsigned char* ZipHelper::GetContentInZip(const std::string& zipFilePath , const std::string& pathInZip , const std::string& password , int* bufferLength , bool* success , ScratchScope& scratch)
+{
+	int itemIndex;
+	HZIP zipFile = FindContentInZip(zipFilePath, pathInZip, password, &itemIndex, bufferLength, success);
+	unsigned char* buffer = scratch.AllocateArray<unsigned char>(*bufferLength);
+	UnzipContent(zipFile, itemIndex, buffer, *bufferLength);
+	return buffer;
 }
 
 
@@ -6,6 +6,8 @@
 #include <string>
 #include <map>
 
+#include "Engine\Memory\ScratchStack.hpp"
+
 namespace Henry
 {
 
@@ -16,6 +18,7 @@ public:
 	~ZipHelper();
 	static void LoadZipToMap(const std::string& zipFilePath, const std::string& password);
 	static const unsigned char* GetContentInZip(const std::string& zipFilePath, const std::string& pathInZip, const std::string& password, int* bufferLength, bool* success);
+	static const unsigned char* GetContentInZip(const std::string& zipFilePath, const std::string& pathInZip, const std::string& password, int* bufferLength, bool* success, ScratchScope& scratch);
 	static std::map< std::string , void* > s_zipMap;
 	static void* GetZip(const std::string& zipFilePath);
 };
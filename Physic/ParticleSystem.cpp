@@ -1,5 +1,7 @@
 #include "Engine\Physic\ParticleSystem.hpp"
 #include "Engine\Renderer\OpenGLRenderer.hpp"
+#include "Engine\Memory\FrameArena.hpp"
+#include "Engine\Core\Metrics.hpp"
 #include <math.h>
 
 
@@ -8,6 +10,8 @@ namespace Henry
 
 #define MOD_MASK_1024 1023
 
+static const unsigned int s_liveParticlesMetric = Metrics::RegisterGauge("particles.live");
+
 ParticleSystem::ParticleSystem(Emitter emitter, Particle particle, int num, float time, bool launchTogether)
 {
 	m_emitter = emitter;
@@ -27,6 +31,7 @@ ParticleSystem::ParticleSystem(Emitter emitter, Particle particle, int num, floa
 			Particle p(m_particleTemplate);
 			m_particles.push_back(p);
 		}
+		Metrics::Add(s_liveParticlesMetric, num);
 	}
 }
 
@@ -39,7 +44,7 @@ ParticleSystem::ParticleSystem(void)
 
 ParticleSystem::~ParticleSystem(void)
 {
-
+	Metrics::Add(s_liveParticlesMetric, -(long long)m_particles.size());
 }
 
 
@@ -68,7 +73,8 @@ void ParticleSystem::Update(float deltaTime, bool hasRandomSpawn)
 
 void ParticleSystem::Draw()
 {
-	std::vector<Vertex_PosColor> vertices;
+	FrameVector<Vertex_PosColor> vertices;
+	vertices.reserve(m_particles.size() * 8);
 	std::vector<Particle>::iterator it = m_particles.begin();
 	while(it != m_particles.end())
 	{
@@ -104,7 +110,8 @@ void ParticleSystem::Draw()
 	}
 
 	OpenGLRenderer::LineWidth(5.0f);
-	OpenGLRenderer::DrawVertexWithVertexArray(vertices,OpenGLRenderer::SHAPE_LINES);
+	if(!vertices.empty())
+		OpenGLRenderer::DrawVertexWithVertexArray(&vertices[0],(int)vertices.size(),OpenGLRenderer::SHAPE_LINES);
 }
 
 
@@ -117,10 +124,12 @@ void ParticleSystem::AddNewParticleToList()
 		p.velocity = m_velocity;
 		p.surviveTime = m_surviveTime;
 		m_particles.push_back(p);
+		Metrics::Add(s_liveParticlesMetric, 1);
 	}
 
 	if(m_particles.size() > m_maxNum)
 	{
+		Metrics::Add(s_liveParticlesMetric, -(long long)m_particles.size());
 		std::vector<Particle> empty;
 		m_particles = empty;
 	}
@@ -136,10 +145,12 @@ void ParticleSystem::AddNewParticleToListWithRandomDirectionAndForce()
 		p.velocity = Vec3f((((rand() & MOD_MASK_1024) - offset) * 0.001f),(((rand() & MOD_MASK_1024) - offset) * 0.001f),(((rand() & MOD_MASK_1024) - offset) * 0.001f)) * 50.0f + m_velocity;
 		p.surviveTime = m_surviveTime;
 		m_particles.push_back(p);
+		Metrics::Add(s_liveParticlesMetric, 1);
 	}
 
 	if(m_particles.size() > m_maxNum)
 	{
+		Metrics::Add(s_liveParticlesMetric, -(long long)m_particles.size());
 		std::vector<Particle> empty;
 		m_particles = empty;
 	}
@@ -155,8 +166,8 @@ void ParticleSystem::SetInitialPosition(Particle* particle)
 
 void ParticleSystem::Draw2D()
 {
-	if(m_particles.size() * 4 != m_particles.size())
-		m_vertices.reserve(m_particles.size() * 4);
+	FrameVector<Vertex_PCT> vertices;
+	vertices.reserve(m_particles.size() * 4);
 	std::vector<Particle>::iterator it = m_particles.begin();
 	while(it != m_particles.end())
 	{
@@ -177,17 +188,15 @@ void ParticleSystem::Draw2D()
 		vpct[2].color = particle.color;
 		vpct[3].color = particle.color;
 
-		m_vertices.push_back(vpct[0]);
-		m_vertices.push_back(vpct[1]);
-		m_vertices.push_back(vpct[2]);
-		m_vertices.push_back(vpct[3]);
+		vertices.push_back(vpct[0]);
+		vertices.push_back(vpct[1]);
+		vertices.push_back(vpct[2]);
+		vertices.push_back(vpct[3]);
 		it++;
 	}
 
-	OpenGLRenderer::DrawVertexWithVertexArray2D(m_vertices,OpenGLRenderer::SHAPE_QUADS);
-	
-	std::vector<Vertex_PCT> empty;
-	m_vertices = empty;
+	if(!vertices.empty())
+		OpenGLRenderer::DrawVertexWithVertexArray2D(&vertices[0],(int)vertices.size(),OpenGLRenderer::SHAPE_QUADS);
 }
 
 };
\ No newline at end of file
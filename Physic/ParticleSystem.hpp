@@ -57,12 +57,13 @@ public:
 	bool m_launchTogether;
 	EMITTER_SHAPE m_emitterShape;
 private:
+	ParticleSystem(const ParticleSystem&);
+	void operator=(const ParticleSystem&);
 	void SetInitialPosition(Particle* particle);
 	void AddNewParticleToList();
 	void AddNewParticleToListWithRandomDirectionAndForce();
 	Particle m_particleTemplate;
 	std::vector<Particle> m_particles;
-	std::vector<Vertex_PCT> m_vertices;
 };
 
 };
@@ -6,12 +6,16 @@
 
 #include "Engine\Renderer\OpenGLRenderer.hpp"
 #include "Engine\Parsing\ZipUtils\ZipHelper.hpp"
+#include "Engine\Memory\FrameArena.hpp"
 
 
 namespace Henry
 {
 
 BitmapFont::BitmapFont(char* fontDocPath , bool* success , bool autoParsing)
+	: m_glyphSheet(nullptr)
+	, m_glyphResource("Fonts", 4096)
+	, m_glyphData(std::less<int>(), GlyphMap::allocator_type(&m_glyphResource))
 {
 	m_metaDoc = new	TiXmlDocument(fontDocPath);
 	*success = m_metaDoc->LoadFile();
@@ -36,9 +40,13 @@ BitmapFont::BitmapFont(char* fontDocPath , bool* success , bool autoParsing)
 
 
 BitmapFont::BitmapFont(char* fontDocPath , char* zipFilePath , bool* success , bool autoParsing)
+	: m_glyphSheet(nullptr)
+	, m_glyphResource("Fonts", 4096)
+	, m_glyphData(std::less<int>(), GlyphMap::allocator_type(&m_glyphResource))
 {
 	int len;
-	const unsigned char* xmlBuffer = ZipHelper::GetContentInZip(zipFilePath,fontDocPath,"c23",&len,success);
+	ScratchScope scratch;
+	const unsigned char* xmlBuffer = ZipHelper::GetContentInZip(zipFilePath,fontDocPath,"c23",&len,success,scratch);
 
 	m_metaDoc = new TiXmlDocument();
 	m_metaDoc->Parse((const char*)xmlBuffer , 0, TIXML_ENCODING_UTF8);
@@ -56,6 +64,9 @@ BitmapFont::BitmapFont(char* fontDocPath , char* zipFilePath , bool* success , b
 
 
 BitmapFont::BitmapFont(BuildInFont font , bool autoParsing)
+	: m_glyphSheet(nullptr)
+	, m_glyphResource("Fonts", 4096)
+	, m_glyphData(std::less<int>(), GlyphMap::allocator_type(&m_glyphResource))
 {
 	Initialize();
 	m_metaDoc = new TiXmlDocument();
@@ -79,15 +90,13 @@ void BitmapFont::Draw(const std::string& rawSentence, const Vec2f& position, con
 	std::string sentence = ConvertArgument( rawSentence.c_str(), args);
 	va_end(args);
 
-	std::vector<float> empty;
-	m_widthTable = empty;
 	m_widthTable.clear();
 	m_widthTable.reserve(sentence.length());
 
-	std::vector<Vertex_PCT> vertices;
+	FrameVector<Vertex_PCT> vertices;
 	vertices.reserve(sentence.length() * 4);
 	float width = 0;
-	std::map<int,GlyphMetaData>::iterator it;
+	GlyphMap::iterator it;
 	for(size_t index = 0; index < sentence.length(); ++index)
 	{
 		it = m_glyphData.find(sentence[index]);
@@ -124,7 +133,10 @@ void BitmapFont::Draw(const std::string& rawSentence, const Vec2f& position, con
 	}
 
 	OpenGLRenderer::BindTexture(m_glyphSheet->m_textureID);
-	OpenGLRenderer::DrawVertexWithVertexArray2D(vertices , OpenGLRenderer::SHAPE_QUADS , (float)canvasCoord.x , (float)canvasCoord.y);
+	if(vertices.empty())
+		return;
+
+	OpenGLRenderer::DrawVertexWithVertexArray2D(&vertices[0] , (int)vertices.size() , OpenGLRenderer::SHAPE_QUADS , (float)canvasCoord.x , (float)canvasCoord.y);
 }
 
 
@@ -147,7 +159,7 @@ float BitmapFont::GetWidthOfText(const std::string& rawSentence, float& fontHeig
 	va_end(args);
 
 	float width = 0;
-	std::map<int, GlyphMetaData>::iterator it;
+	GlyphMap::iterator it;
 	for (size_t index = 0; index < sentence.length(); ++index)
 	{
 		it = m_glyphData.find(sentence[index]);
@@ -6716,15 +6728,10 @@ void BitmapFont::ParsingXmlDataAndLoadTexture(BuildInFont bf , const std::string
 		std::string errorInfo("Failed to load root in file.");
 		errorInfo = "Error , can't find root element of meta-data file : " + errorInfo + "\n\n";
 		MessageBoxA( NULL , (LPCSTR)errorInfo.c_str() , "BMP Fonts Metadata Analysis Failed!", MB_ICONERROR | MB_OK );
+		return;
 	}
 
-	Vec2f imageSize;
-	TiXmlElement* node = NULL;
-	node = root->FirstChildElement("common");
-	imageSize.x = (float)atoi(node->Attribute("scaleW"));
-	imageSize.y = (float)atoi(node->Attribute("scaleH"));
-	m_fontHeight = atoi(node->Attribute("lineHeight"));
-	node = root->FirstChildElement("pages");
+	TiXmlElement* node = root->FirstChildElement("pages");
 	node = node->FirstChildElement("page");
 	std::string filaName(node->Attribute("file"));
 
@@ -6745,10 +6752,26 @@ void BitmapFont::ParsingXmlDataAndLoadTexture(BuildInFont bf , const std::string
 	else
 		BindBuildInTexture(bf);
 
+	ParsingGlyphData();
+}
+
+
+// Glyph metrics only , no texture is touched so this works without a GL context.
+bool BitmapFont::ParsingGlyphData()
+{
+	TiXmlElement* root = m_metaDoc->RootElement();
+	if(!root)
+		return false;
+
+	Vec2f imageSize;
+	TiXmlElement* node = root->FirstChildElement("common");
+	imageSize.x = (float)atoi(node->Attribute("scaleW"));
+	imageSize.y = (float)atoi(node->Attribute("scaleH"));
+	m_fontHeight = atoi(node->Attribute("lineHeight"));
+
 	Vec2f oneOverImageSize(1.0f/imageSize.x , 1.0f/imageSize.y);
 	float oneOverFontHeight = 1.0f/m_fontHeight;
 
-	GlyphMetaData data;
 	for(TiXmlElement* elem = root->FirstChildElement(); elem != NULL; elem = elem->NextSiblingElement())
 	{
 		std::string elemName = elem->Value();
@@ -6770,11 +6793,11 @@ void BitmapFont::ParsingXmlDataAndLoadTexture(BuildInFont bf , const std::string
 				data.m_ttfC = (float)(( atoi(sub_elem->Attribute("xadvance")) - atoi(sub_elem->Attribute("width")) - atoi(sub_elem->Attribute("xoffset"))) * oneOverFontHeight);
 
 				m_glyphData[character_id] = data;
-				//std::string sub_elemName = sub_elem->Attribute("x");
-				//MessageBoxA( NULL , (LPCSTR)sub_elemName.c_str() , "File Name is....", MB_ICONERROR | MB_OK );
 			}
 		}
 	}
+
+	return true;
 }
 
 
@@ -6,6 +6,7 @@
 #include "Engine\Parsing\TinyXML\tinyxml.h"
 #include "Engine\Math\GeneralStruct.hpp"
 #include "Texture.hpp"
+#include "Engine\Memory\MemoryResource.hpp"
 
 #include <map>
 #include <vector>
@@ -23,6 +24,9 @@ struct GlyphMetaData
 };
 
 
+typedef ResourceMap<int,GlyphMetaData> GlyphMap;
+
+
 enum BuildInFont { NONE = 0 , ARIAL , ARIAL_NORMAL , BITFONT , BOOKANTIQUA , BUXTON , BUXTON_NORMAL };
 
 
@@ -36,13 +40,15 @@ public:
 	void Draw(const std::string& sentence , const Vec2f& position , const float& fontHeight , const RGBA& color , const Vec2i canvasCoord , ...);
 	float GetWidthOfText(const std::string& sentence, float& fontHeight, ...);
 	void ParsingXmlDataAndLoadTexture(BuildInFont bf = NONE , const std::string& zipFilePath = "");
+	bool ParsingGlyphData();
 
 public:
 	TiXmlDocument* m_metaDoc;
 	Texture* m_glyphSheet;
 	std::map<BuildInFont,std::ostringstream> m_buildInFontXML;
 	std::map<BuildInFont,int> m_buildInFontTextureID;
-	std::map<int,GlyphMetaData> m_glyphData;
+	MonotonicMemoryResource m_glyphResource;
+	GlyphMap m_glyphData;
 	std::vector<float> m_widthTable;
 	int m_fontHeight;
 
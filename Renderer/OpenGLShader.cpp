@@ -53,7 +53,8 @@ OpenGLShader::OpenGLShader(char* shaderFilePath , GLenum shader_type ,  const st
 	*success = true;
 	GLint wasSuccessful;
 	int len;
-	const unsigned char* shaderTextBuffer = ZipHelper::GetContentInZip(zipFile,shaderFilePath,"c23",&len,success);
+	ScratchScope scratch;
+	const unsigned char* shaderTextBuffer = ZipHelper::GetContentInZip(zipFile,shaderFilePath,"c23",&len,success,scratch);
 	m_shaderID = glCreateShader(shader_type);
 	glShaderSource( m_shaderID, 1, (const GLchar* const*)&shaderTextBuffer, nullptr );
 	glCompileShader( m_shaderID );
@@ -64,8 +65,6 @@ OpenGLShader::OpenGLShader(char* shaderFilePath , GLenum shader_type ,  const st
 		ReportShaderError( m_shaderType , m_shaderID , (const char*)shaderTextBuffer , m_shaderFileName , m_shaderFilePath );
 		*success = false;
 	}
-
-	delete[] shaderTextBuffer;
 }
 
 
@@ -336,7 +336,8 @@ int OpenGLRenderer::LoadTexture(const std::string& imageFilePath , Vec2i& size ,
 {
 	int len;
 	bool success;
-	const unsigned char* data = ZipHelper::GetContentInZip(zipFilePath,imageFilePath,"c23",&len,&success);
+	ScratchScope scratch;
+	const unsigned char* data = ZipHelper::GetContentInZip(zipFilePath,imageFilePath,"c23",&len,&success,scratch);
 	int openglTextureID = 0;
 	int numComponents = 0; // Filled in for us to indicate how many color/alpha components the image had (e.g. 3=RGB, 4=RGBA)
 	int numComponentsRequested = 0; // don't care; we support 3 (RGB) or 4 (RGBA)
@@ -2,6 +2,7 @@
 #include "Texture.hpp"
 #include "OpenGLRenderer.hpp"
 #include "Engine\Parsing\ZipUtils\unzip.h"
+#include "Engine\Core\Metrics.hpp"
 
 #define STBI_HEADER_FILE_ONLY
 #include "stb_image.c"
@@ -14,7 +15,24 @@ namespace Henry
 
 
 //---------------------------------------------------------------------------
-STATIC std::map< std::string, Texture* > Texture::s_textureRegistry;
+STATIC MemoryResource* Texture::GetMemoryResource()
+{
+	static PoolMemoryResource s_textureResource("Textures");
+	return &s_textureResource;
+}
+
+
+//---------------------------------------------------------------------------
+STATIC TextureRegistry Texture::s_textureRegistry( std::less<std::string>() , TextureRegistry::allocator_type( Texture::GetMemoryResource() ) );
+
+
+//---------------------------------------------------------------------------
+static long long SampleNumberOfTextures()
+{
+	return (long long)Texture::s_textureRegistry.size();
+}
+
+static const unsigned int s_texturesMetric = Metrics::RegisterGauge("textures.registered", &SampleNumberOfTextures);
 
 
 //---------------------------------------------------------------------------
@@ -52,7 +70,7 @@ STATIC Texture* Texture::GetTextureByName( const std::string& imageFilePath )
 {
 	// Todo: you write this
 	Texture* texture = nullptr;
-	std::map<std::string, Texture* >::iterator it = s_textureRegistry.find(imageFilePath.c_str());
+	TextureRegistry::iterator it = s_textureRegistry.find(imageFilePath.c_str());
 	if(it != s_textureRegistry.end())
 		texture = it->second;
 	return texture;
@@ -8,6 +8,7 @@
 #include <map>
 
 #include "Engine\Math\Vec2.hpp"
+#include "Engine\Memory\MemoryResource.hpp"
 
 
 namespace Henry
@@ -15,6 +16,9 @@ namespace Henry
 
 typedef Vec2<int> TextureSize;
 
+class Texture;
+typedef ResourceMap< std::string, Texture* > TextureRegistry;
+
 class Texture
 {
 public:
@@ -24,7 +28,8 @@ public:
 	Texture* Texture::GetTextureByName( const std::string& imageFilePath );
 	Texture* Texture::CreateOrGetTexture( const std::string& imageFilePath );
 	Texture* Texture::CreateOrGetTexture( const std::string& imageFilePath , const std::string& zipFilePath);
-	static std::map< std::string, Texture* > s_textureRegistry;
+	static TextureRegistry s_textureRegistry;
+	static MemoryResource* GetMemoryResource();
 	TextureSize m_size;
 	int m_textureID;
 };